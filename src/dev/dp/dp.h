@@ -32,58 +32,116 @@
 //
 // +----------------------------------+
 // |     DPC - Communication Area     |
+// |       DPX - To Device Ring       |
+// |       DPX - From Device Ring     |
 // +----------------------------------+
-// |     DPX - To Device Doorbell     |
+// |   Message Slots (To Device)      |
 // +----------------------------------+
-// |     DPX - From Device Doorbell   |
-// +----------------------------------+
-// |        User-defined Area         |
-// +----------------------------------+
-// |         Transmit Buffer          |
-// +----------------------------------+
-// |         Receive Buffer           |
+// |   Message Slots (From Device)    |
 // +----------------------------------+
+//
+// A device process is a child process which owns a slow host
+// resource (TAP interface, raw disk, printer spool, etc.) and
+// may block on it.  Emulator puts requests into 'to device' ring
+// and device process puts results into 'from device' ring.  Each
+// ring has one producer and one consumer, so no locks are needed.
+//
+// Emulator takes results by polling its ring from a timer, so that
+// no system calls are needed on CPU thread.  Device process waits
+// for requests on a doorbell (pipe) when it is idle, and emulator
+// rings that doorbell only when device process is sleeping.
+//
+// If device process dies, emulator will notice that and give
+// DP_CMD_DEAD message to its device.  Guest continues running.
 
 typedef struct dp  DP;   // Device Process - Handler
 typedef struct dpc DPC;  // Device Process - Communication Area
-typedef struct dpx DPX;  // Device Process - Doorbell/Transfer Area
+typedef struct dpx DPX;  // Device Process - Doorbell/Ring Area
+typedef struct dpm DPM;  // Device Process - Message
 
-// Device Process - Doorbell/Transfer Area
-struct dpx {
-	uint32 Command;   // Command
+// Device Process - Message (in ring slot)
+struct dpm {
+	uint32 Command;   // Command (Device-defined)
 	uint32 Result;    // Result from device
-	uint32 Flags;     // Doorbell Flags
-	uint32 Ready;     // Ready/Done or Busy Flag
-
-	uint32 Type;      // Communication Type
-	uint32 Signal;    // Signal Number
-	uint32 ParentPID; // Parent Process Identification
+	uint32 Param;     // Parameter (Device-defined)
+	uint32 Size;      // Data Length
+	uint8  Data[0];   // Data Area (up to szData bytes)
+};
 
-	void   *Buffer;   // Buffer Area
-	uint32 Offset;    // Offset from DPC address base
-	uint32 Size;      // Buffer Length
+// Device Process - Doorbell/Ring Area
+struct dpx {
+	volatile uint32 Head;    // Next slot to fill (producer)
+	volatile uint32 Tail;    // Next slot to take (consumer)
+	volatile uint32 Sleep;   // Consumer is waiting for doorbell
+	uint32          nSlots;  // Number of Slots (power of two)
+	uint32          szSlot;  // Size of Slot
+	uint32          Offset;  // Slots, offset from DPC address base
 };
 
 // Device Process - Communication Area
 struct dpc {
-	uint32 Version;     // Device Process Version
-	uint32 Offset;      // Buffer Area, Offset from base.
+	uint32          Version;    // Device Process Version
+	uint32          Size;       // Total Size of shared memory
+	volatile uint32 State;      // Device Process State
 
-	DPX    toDevice;    // Transmit data/results to device.
-	DPX    fromDevice;  // Receive data/results from device.
+	DPX    toDevice;    // Requests to device.
+	DPX    fromDevice;  // Results from device.
 };
 
 struct dp {
-	uint32 Type;      // Communication Type
-	DPC    *dpc;      // Communication Area (in shared memory area)
-	uint32 ShMemID;   // Shared Memory Identification
-	uint32 ChildPID;  // Chlid Process Identification
+	char      *Name;      // Device Process Name
+	DPC       *dpc;       // Communication Area (in shared memory area)
+	int32     ShMemID;    // Shared Memory Identification
+	int32     ChildPID;   // Child Process Identification
+	int       Doorbell[2]; // Doorbell to device process (pipe)
+	uint32    szData;     // Maximum Data Length per message
+	uint32    nPolls;     // Polls since last check of child
+
+	// Worker routine (in device process)
+	int       (*Worker)(DP *, void *);
+	void      *Arg;
+
+	// Completion routine (in emulator)
+	void      *Device;
+	void      (*Done)(void *, DPM *);
+	CLK_QUEUE Timer;      // Poll Timer (if pollTime is not zero)
+	int       pollTime;   // Poll interval (instructions)
 };
 
-#define DP_VERSION 0  // (Pre-Alpha)
+#define DP_VERSION   1  // Ring Version
 
+#define DP_NSLOTS    64    // Default slots per ring
+#define DP_POLLTIME  1000  // Default poll interval (instructions)
+#define DP_CHECKTIME 1000  // Polls between checks of device process
+
+// Device Process States
+#define DP_INIT   0   // Starting
+#define DP_RUN    1   // Running
+#define DP_STOP   2   // Stopped (or stopping)
+#define DP_DEAD   3   // Died
+
+// Reserved Commands
+#define DP_CMD_STOP 0xFFFFFFFF  // Stop device process (to device)
+#define DP_CMD_DEAD 0xFFFFFFFE  // Device process died (to emulator)
+
+// Result Codes
 #define DP_OK     0   // Successful
 #define DP_NOSHM  1   // No Shared Memory
 #define DP_NOADDR 2   // No Shared Address
 #define DP_NOFORK 3   // Fork failure
+#define DP_FULL   4   // Ring is full
+#define DP_NODEV  5   // Device process is not running
+#define DP_NOPIPE 6   // No Doorbell
+
+// Emulator side
+int  dp_Create(DP *, char *, uint32, uint32);
+int  dp_Start(DP *, int (*)(DP *, void *), void *);
+void dp_Stop(DP *);
+int  dp_Request(DP *, uint32, uint32, void *, uint32);
+int  dp_Poll(DP *);
 
+// Device process side
+DPM  *dp_GetRequest(DP *);
+void dp_Release(DP *);
+int  dp_PutResult(DP *, uint32, uint32, uint32, void *, uint32);
+int  dp_Wait(DP *, int, int);
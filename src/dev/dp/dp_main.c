@@ -26,37 +26,74 @@
 
 #include "emu/defs.h"
 #include "dev/dp/dp.h"
+#include <poll.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
 
-// Initialize DP doorbell/transfer area
-void dp_InitDoorbell(DPC *dpc, DPX *dpx,
-	uint32 Type, uint32 Signal, uint32 Offset, uint32 Size)
+// Get slot of ring by index.
+static __inline__ DPM *dp_GetSlot(DPC *dpc, DPX *dpx, uint32 idx)
 {
-	dpx->Type      = Type;
-	dpx->Signal    = Signal;
-	dpx->ParentPID = getpid();
-
-	// Set up buffer area
-	dpx->Buffer    = dpc + Offset;
-	dpx->Offset    = Offset;
-	dpx->Size      = Size;
+	return (DPM *)((uint8 *)dpc + dpx->Offset +
+		((idx & (dpx->nSlots - 1)) * dpx->szSlot));
+}
+
+// Put a message into ring.  Return NULL if ring is full.
+static DPM *dp_PutMessage(DPC *dpc, DPX *dpx, uint32 cmd, uint32 result,
+	uint32 param, void *data, uint32 size)
+{
+	DPM *msg;
+
+	if ((dpx->Head - dpx->Tail) >= dpx->nSlots)
+		return NULL;
+	msg = dp_GetSlot(dpc, dpx, dpx->Head);
+	msg->Command = cmd;
+	msg->Result  = result;
+	msg->Param   = param;
+	msg->Size    = size;
+	if (size)
+		memcpy(msg->Data, data, size);
+
+	// Let consumer see message before new head.
+	__sync_synchronize();
+	dpx->Head++;
+	__sync_synchronize();
+
+	return msg;
+}
+
+// Initialize DP doorbell/ring area
+void dp_InitDoorbell(DPX *dpx, uint32 nSlots, uint32 szSlot, uint32 Offset)
+{
+	dpx->Head   = 0;
+	dpx->Tail   = 0;
+	dpx->Sleep  = 0;
+	dpx->nSlots = nSlots;
+	dpx->szSlot = szSlot;
+	dpx->Offset = Offset;
 }
 
 // Create Device Process Communication Area
-int dp_Create(DP *dp, uint32 dpcSize,
-	uint32 outType, uint32 outSignal, uint32 outSize,
-	uint32 inType,  uint32 inSignal,  uint32 inSize)
+//   nSlots - Slots per ring (rounded up to power of two)
+//   szData - Maximum data length per message
+int dp_Create(DP *dp, char *name, uint32 nSlots, uint32 szData)
 {
 	DPC    *dpc;
-	uint32 totSize   = dpcSize + inSize + outSize;
-	uint32 outOffset = dpcSize;
-	uint32 inOffset  = dpcSize + outSize;
+	uint32 szSlot, totSize, slots;
 	int32  shmid;
 
 	// Initialize DP variables
-	dp->Type     = 0;
-	dp->dpc      = NULL;
-	dp->ShMemID  = -1;
-	dp->ChildPID = 0;
+	memset(dp, 0, sizeof(DP));
+	dp->Name        = name;
+	dp->ShMemID     = -1;
+	dp->Doorbell[0] = -1;
+	dp->Doorbell[1] = -1;
+	dp->szData      = szData;
+
+	for (slots = 1; slots < nSlots; slots <<= 1)
+		;
+	szSlot  = (sizeof(DPM) + szData + 7) & ~7;
+	totSize = ((sizeof(DPC) + 7) & ~7) + (2 * slots * szSlot);
 
 	// Create shared memory for DP communication area
 	if ((shmid = shmget(IPC_PRIVATE, totSize, 0600)) < 0) {
@@ -64,21 +101,36 @@ int dp_Create(DP *dp, uint32 dpcSize,
 		return DP_NOSHM;
 	}
 	
-	if ((dpc = (DPC *)shmat(shmid, NULL, SHM_RND)) == NULL) {
+	if ((dpc = (DPC *)shmat(shmid, NULL, SHM_RND)) == (DPC *)-1) {
 		printf("DP: Can't create shared memory - %s\n", strerror(errno));
 		shmctl(shmid, IPC_RMID, NULL);
 		return DP_NOADDR;
 	}
 
+	// Shared memory will be gone when both processes
+	// detach it (or exit/die).
+	shmctl(shmid, IPC_RMID, NULL);
+
 	memset(dpc, 0, totSize);
 	dpc->Version = DP_VERSION;
-	dpc->Offset  = dpcSize;
+	dpc->Size    = totSize;
+	dpc->State   = DP_INIT;
+
+	// Initialize Doorbell/Ring Areas
+	dp_InitDoorbell(&dpc->toDevice, slots, szSlot,
+		(sizeof(DPC) + 7) & ~7);
+	dp_InitDoorbell(&dpc->fromDevice, slots, szSlot,
+		((sizeof(DPC) + 7) & ~7) + (slots * szSlot));
 
-	// Initialize Doorbell/Transfer Area
-	dp_InitDoorbell(dpc, &dpc->toDevice,
-		outType, outSignal, outOffset, outSize);
-//	dp_InitDoorbell(dpc, &dpc->fromDevice,
-//		inType,  inSignal,  inOffset,  inSize);
+	// Doorbell to device process
+	if (pipe(dp->Doorbell) < 0) {
+		printf("DP: Can't create doorbell - %s\n", strerror(errno));
+		shmdt(dpc);
+		return DP_NOPIPE;
+	}
+	fcntl(dp->Doorbell[0], F_SETFD, FD_CLOEXEC);
+	fcntl(dp->Doorbell[1], F_SETFD, FD_CLOEXEC);
+	fcntl(dp->Doorbell[1], F_SETFL, O_NONBLOCK);
 
 	dp->dpc     = dpc;
 	dp->ShMemID = shmid;
@@ -86,9 +138,52 @@ int dp_Create(DP *dp, uint32 dpcSize,
 	return DP_OK;
 }
 
-int dp_Start(DPC *dpc)
+// Poll timer - take results from device process.
+static void dp_Timer(void *dptr)
+{
+	DP *dp = (DP *)dptr;
+
+	if (dp_Poll(dp) == DP_OK)
+		ts10_SetTimer(&dp->Timer);
+}
+
+// Close all files inherited from emulator (disk images, sockets,
+// doorbells of other device processes) except standard files and
+// that one.  Called in child process.
+static void dp_CloseFiles(int keep, int nFiles)
+{
+	int fd;
+
+#ifdef SYS_close_range
+	if (((keep == 3) || (syscall(SYS_close_range, 3, keep - 1, 0) == 0)) &&
+	    (syscall(SYS_close_range, keep + 1, ~0U, 0) == 0))
+		return;
+#endif /* SYS_close_range */
+	for (fd = 3; fd < nFiles; fd++)
+		if (fd != keep)
+			close(fd);
+}
+
+// Start Device Process
+//
+// Worker routine runs in a child process and returns its exit
+// code.  Set Device, Done and pollTime in DP before start to
+// take results from timer; otherwise call dp_Poll directly.
+//
+// Emulator has other threads running when it forks, so that
+// child process has only async-signal-safe calls available.
+// Worker routine must not use stdio, malloc or emulator routines
+// (including debug output), only system calls and DP routines.
+// Child process starts with its doorbell and standard files only.
+int dp_Start(DP *dp, int (*worker)(DP *, void *), void *arg)
 {
 	int32 pid;
+	int   nFiles;
+
+	dp->Worker = worker;
+	dp->Arg    = arg;
+	if ((nFiles = sysconf(_SC_OPEN_MAX)) < 0)
+		nFiles = 1024;
 
 	if ((pid = fork()) < 0) {
 		printf("DP: Can't fork - %s\n", strerror(errno));
@@ -96,11 +191,214 @@ int dp_Start(DPC *dpc)
 	} else if (pid == 0) {
 		// Child Process Here
 
-		printf("Hey, I am child process - %d\n", getpid());
+		// Leave console interrupts to emulator and
+		// go away when emulator goes away.
+		signal(SIGINT, SIG_IGN);
+		signal(SIGQUIT, SIG_IGN);
+		prctl(PR_SET_PDEATHSIG, SIGTERM);
+		dp_CloseFiles(dp->Doorbell[0], nFiles);
+		dp->Doorbell[1] = -1;
+
+		dp->dpc->State = DP_RUN;
+		_exit(dp->Worker(dp, dp->Arg));
+	}
+
+	// Parent Process Here
+	close(dp->Doorbell[0]);
+	dp->Doorbell[0] = -1;
+	dp->ChildPID    = pid;
 
-		_exit(1);
+	if (dp->Done && dp->pollTime) {
+		dp->Timer.Name     = dp->Name;
+		dp->Timer.Flags    = 0;
+		dp->Timer.outTimer = dp->pollTime;
+		dp->Timer.nxtTimer = dp->pollTime;
+		dp->Timer.Device   = dp;
+		dp->Timer.Execute  = dp_Timer;
+		ts10_SetTimer(&dp->Timer);
 	}
 
 	return DP_OK;
 }
 
+// Stop Device Process and release communication area.
+void dp_Stop(DP *dp)
+{
+	int idx;
+
+	if (dp->Timer.Flags & CLK_PENDING)
+		ts10_CancelTimer(&dp->Timer);
+	dp->Done = NULL;
+
+	if (dp->ChildPID > 0) {
+		// Ask device process to stop, then give it
+		// a short time before killing it.
+		if ((dp->dpc->State == DP_RUN) || (dp->dpc->State == DP_INIT))
+			dp_Request(dp, DP_CMD_STOP, 0, NULL, 0);
+		for (idx = 0; idx < 50; idx++) {
+			if (waitpid(dp->ChildPID, NULL, WNOHANG) != 0)
+				break;
+			usleep(10000);
+		}
+		if (idx == 50) {
+			kill(dp->ChildPID, SIGKILL);
+			waitpid(dp->ChildPID, NULL, 0);
+		}
+		dp->ChildPID = 0;
+	}
+
+	if (dp->Doorbell[1] >= 0)
+		close(dp->Doorbell[1]);
+	dp->Doorbell[1] = -1;
+	if (dp->dpc)
+		shmdt(dp->dpc);
+	dp->dpc = NULL;
+}
+
+// Device process died - tell its device.
+static void dp_Dead(DP *dp)
+{
+	DPM dead;
+
+	printf("DP: Device process %s (%d) died.\n", dp->Name, dp->ChildPID);
+	dp->dpc->State = DP_DEAD;
+
+	// Reap it if exited already, otherwise dp_Stop will.
+	if ((dp->ChildPID > 0) && (waitpid(dp->ChildPID, NULL, WNOHANG) != 0))
+		dp->ChildPID = 0;
+	if (dp->Done) {
+		memset(&dead, 0, sizeof(DPM));
+		dead.Command = DP_CMD_DEAD;
+		dp->Done(dp->Device, &dead);
+	}
+}
+
+// Send a request to device process.
+int dp_Request(DP *dp, uint32 cmd, uint32 param, void *data, uint32 size)
+{
+	DPC  *dpc = dp->dpc;
+	DPX  *dpx = &dpc->toDevice;
+	char bell = 0;
+
+	if ((dpc->State == DP_DEAD) || (dpc->State == DP_STOP))
+		return DP_NODEV;
+	if (size > dp->szData)
+		size = dp->szData;
+	if (dp_PutMessage(dpc, dpx, cmd, 0, param, data, size) == NULL)
+		return DP_FULL;
+
+	// Ring doorbell only if device process is sleeping.
+	if (dpx->Sleep) {
+		dpx->Sleep = 0;
+		if ((write(dp->Doorbell[1], &bell, 1) < 0) && (errno == EPIPE)) {
+			dp_Dead(dp);
+			return DP_NODEV;
+		}
+	}
+
+	return DP_OK;
+}
+
+// Take all results from device process.
+int dp_Poll(DP *dp)
+{
+	DPC *dpc = dp->dpc;
+	DPX *dpx = &dpc->fromDevice;
+	DPM *msg;
+
+	while (dpx->Tail != dpx->Head) {
+		__sync_synchronize();
+		msg = dp_GetSlot(dpc, dpx, dpx->Tail);
+		if (dp->Done)
+			dp->Done(dp->Device, msg);
+		__sync_synchronize();
+		dpx->Tail++;
+	}
+
+	// Check device process once a while.
+	if (++dp->nPolls >= DP_CHECKTIME) {
+		dp->nPolls = 0;
+		if ((dpc->State != DP_DEAD) && (dp->ChildPID > 0) &&
+		    (waitpid(dp->ChildPID, NULL, WNOHANG) != 0))
+			dp_Dead(dp);
+	}
+
+	return (dpc->State == DP_DEAD) ? DP_NODEV : DP_OK;
+}
+
+// ***************************************************************
+
+// Device Process Side
+
+// Get next request.  Return NULL if none.
+DPM *dp_GetRequest(DP *dp)
+{
+	DPC *dpc = dp->dpc;
+	DPX *dpx = &dpc->toDevice;
+
+	if (dpx->Tail == dpx->Head)
+		return NULL;
+	__sync_synchronize();
+	return dp_GetSlot(dpc, dpx, dpx->Tail);
+}
+
+// Release current request to emulator.
+void dp_Release(DP *dp)
+{
+	__sync_synchronize();
+	dp->dpc->toDevice.Tail++;
+}
+
+// Give a result to emulator.  Wait for free slot if ring is full.
+int dp_PutResult(DP *dp, uint32 cmd, uint32 result, uint32 param,
+	void *data, uint32 size)
+{
+	DPC *dpc = dp->dpc;
+
+	if (size > dp->szData)
+		size = dp->szData;
+	while (dp_PutMessage(dpc, &dpc->fromDevice, cmd, result,
+	                     param, data, size) == NULL)
+		poll(NULL, 0, 1);
+
+	return DP_OK;
+}
+
+// Wait for doorbell or for that file to become readable.
+//   fd      - Host resource (or -1)
+//   timeout - Milliseconds (-1 = forever)
+// Return 1 if that file is readable, otherwise 0.
+int dp_Wait(DP *dp, int fd, int timeout)
+{
+	DPX           *dpx = &dp->dpc->toDevice;
+	struct pollfd fds[2];
+	char          bell[16];
+	int           nfds = 1;
+
+	fds[0].fd      = dp->Doorbell[0];
+	fds[0].events  = POLLIN;
+	fds[0].revents = 0;
+	if (fd >= 0) {
+		fds[1].fd      = fd;
+		fds[1].events  = POLLIN;
+		fds[1].revents = 0;
+		nfds++;
+	}
+
+	// Tell emulator to ring doorbell, then check ring
+	// again in case of request before that.
+	dpx->Sleep = 1;
+	__sync_synchronize();
+	if (dpx->Tail != dpx->Head)
+		timeout = 0;
+
+	if (poll(fds, nfds, timeout) > 0) {
+		if (fds[0].revents & POLLIN)
+			read(dp->Doorbell[0], bell, sizeof(bell));
+		if (fds[0].revents & (POLLHUP|POLLERR))
+			_exit(0); // Emulator is gone.
+	}
+	dpx->Sleep = 0;
+
+	return (fd >= 0) && (fds[1].revents & POLLIN);
+}
@@ -42,3 +42,23 @@ enum {
 #define EPP_TUN_IOERROR -1
 #define EPP_TUN_INVALID -2
 
+#define EPP_NSLOTS  256  // Frames per ring
+
+// EPP Process States
+#define EPP_STARTING 0  // Waiting for EPP_INIT result
+#define EPP_READY    1  // Interface is open
+#define EPP_FAILED   2  // Can't open interface
+#define EPP_DEAD     3  // Device process died
+
+// EPP_INIT Result (from device process)
+typedef struct {
+	char    ifName[40];   // Interface Name
+	ETH_MAC hostAddr;     // Interface Ethernet Address
+} EPP_INFO;
+
+// EPP Device Process (Ethernet backend 'proc')
+typedef struct {
+	DP      dp;           // Device Process
+	int     State;        // Process State
+	char    tunName[40];  // TUN/TAP Type (tap or tun)
+} EPP_PROCESS;
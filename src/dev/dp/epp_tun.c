@@ -24,28 +24,24 @@
 // dealings in this Software without prior written authorization from
 // Timothy M Stark.
 
-#include <stdio.h>
-#include <strings.h>
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <errno.h>
+#include "emu/defs.h"
+#include "emu/socket.h"
+#include "emu/ether.h"
+#include "dev/dp/dp.h"
+#include "dev/dp/epp.h"
 
 #include <linux/ioctl.h>
 #include <linux/if.h>
 #include <linux/if_tun.h>
 
-#include "epp.h"
+// Ethernet backend 'proc:<tap|tun>' - TUN/TAP interface is owned by
+// a device process, so that reads and writes on it never block
+// emulator.  Frames are passed through DP rings and received frames
+// are taken by Ethernet poll timer.  Device process only uses
+// system calls (see dp_Start).
 
-typedef unsigned char uchar;
-
-void Usage(char *pgmName)
-{
-	printf("Usage: %s <tap|tun>\n", pgmName);
-}
-
-void DumpPacket(uchar *pkt, int len)
+#ifdef DEBUG
+static void DumpPacket(uchar *pkt, int len)
 {
 	uchar ascBuffer[17];
 	uchar ch, *pasc;
@@ -74,8 +70,9 @@ void DumpPacket(uchar *pkt, int len)
 		printf(" |%-16s|\n", ascBuffer);
 	}
 }
+#endif /* DEBUG */
 
-int OpenTUN(char *tunName)
+static int OpenTUN(char *tunName, uint8 *hostAddr)
 {
 	struct ifreq ifr; // Interface Requests
 	int  tunFlags;    // Interface Flags
@@ -94,52 +91,192 @@ int OpenTUN(char *tunName)
 
 	// Set up interface flags
 	memset(&ifr, 0, sizeof(ifr));
-	sprintf(ifr.ifr_name, "%s%%d", tunName);
+	strcpy(ifr.ifr_name, tunName);
+	strcat(ifr.ifr_name, "%d");
 	ifr.ifr_flags = tunFlags|IFF_NO_PI;
 
 	// Send interface requests to TUN/TAP driver.
-	if ((err = ioctl(tun, TUNSETIFF, &ifr)) < 0)
-		return err;
+	if (ioctl(tun, TUNSETIFF, &ifr) < 0) {
+		err = errno;
+		close(tun);
+		errno = err;
+		return -1;
+	}
 	strcpy(tunName, ifr.ifr_name);
 
+	// Get Ethernet address of that interface.
+	if (ioctl(tun, SIOCGIFHWADDR, &ifr) == 0)
+		memcpy(hostAddr, &ifr.ifr_hwaddr.sa_data[0], 6);
+
 	return tun;
 }
 
+// ***************************************************************
+
+// Device Process Side
 
-int main(int argc, char **argv)
+int epp_Worker(DP *dp, void *arg)
 {
-	char tunName[40];
-	int  tun;
-
-	uchar frame[2048];
-	int   len = 2048;
-	int   rc;
-
-	strcpy(tunName, argv[1]);
-	tun = OpenTUN(tunName);
-	switch(tun) {
-		case EPP_TUN_IOERROR:
-			printf("%s: Can't open %s: %s\n",
-				argv[0], tunName, strerror(errno));
-			return 1;
-
-		case EPP_TUN_INVALID:
-			Usage(argv[0]);
-			return 2;
-
-		default:
-			printf("Successful! %s\n", tunName);
-			break;
+	EPP_PROCESS *epp = (EPP_PROCESS *)arg;
+	EPP_INFO    info;
+	DPM         *msg;
+	uchar       frame[2048];
+	int         tun, rc;
+
+	// Open TUN/TAP interface and tell emulator that.
+	memset(&info, 0, sizeof(info));
+	strcpy(info.ifName, epp->tunName);
+	if ((tun = OpenTUN(info.ifName, info.hostAddr)) < 0) {
+		dp_PutResult(dp, EPP_INIT, (tun == EPP_TUN_INVALID) ? EINVAL : errno,
+			0, NULL, 0);
+		return 1;
 	}
+	dp_PutResult(dp, EPP_INIT, 0, 0, &info, sizeof(info));
+
+	for (;;) {
+		// Send all frames from emulator.
+		while (msg = dp_GetRequest(dp)) {
+			switch (msg->Command) {
+				case EPP_TRANSMIT:
+					// Lost frame like a busy Ethernet.
+					write(tun, msg->Data, msg->Size);
+					break;
 
+				case DP_CMD_STOP:
+					dp_Release(dp);
+					close(tun);
+					return 0;
+			}
+			dp_Release(dp);
+		}
 
-	// Test TUN/TAP interface (temp)
-	printf("Ok, listening...\n");
-	while(1) {
-		if ((rc = read(tun, frame, len)) < 0) {
-			printf("Error: %s\n", strerror(errno));
-			exit(1);
+		// Wait for frames from TUN/TAP or emulator.
+		if (dp_Wait(dp, tun, -1)) {
+			if ((rc = read(tun, frame, sizeof(frame))) > 0)
+				dp_PutResult(dp, EPP_RECEIVE, 0, 0, frame, rc);
+			else if ((rc < 0) && (errno != EINTR) && (errno != EAGAIN)) {
+				// Emulator will notice that and report it.
+				close(tun);
+				return 1;
+			}
 		}
-		DumpPacket(frame, rc);
 	}
 }
+
+// ***************************************************************
+
+// Emulator Side
+
+// Results from device process
+static void epp_Done(void *dev, DPM *msg)
+{
+	ETH_DEVICE  *eth = (ETH_DEVICE *)dev;
+	EPP_PROCESS *epp = (EPP_PROCESS *)eth->Process;
+	EPP_INFO    *info;
+
+	switch (msg->Command) {
+		case EPP_RECEIVE:
+#ifdef DEBUG
+			if (dbg_Check(DBG_IODATA))
+				DumpPacket(msg->Data, msg->Size);
+#endif /* DEBUG */
+			eth_Receive(eth, msg->Data, msg->Size);
+			break;
+
+		case EPP_INIT:
+			if (msg->Result) {
+				printf("EPP: Can't open %s: %s\n",
+					epp->tunName, strerror(msg->Result));
+				epp->State = EPP_FAILED;
+				break;
+			}
+			info = (EPP_INFO *)msg->Data;
+			strcpy(eth->ifName, info->ifName);
+			memcpy(eth->hostAddr, info->hostAddr, sizeof(ETH_MAC));
+			epp->State = EPP_READY;
+			break;
+
+		case DP_CMD_DEAD:
+			printf("EPP: Device process for %s died - No network.\n",
+				eth->ifName);
+			epp->State = EPP_DEAD;
+			break;
+	}
+}
+
+int epp_Open(ETH_DEVICE *eth, char *arg)
+{
+	EPP_PROCESS *epp;
+	int         idx;
+
+	if ((epp = (EPP_PROCESS *)calloc(1, sizeof(EPP_PROCESS))) == NULL)
+		return -1;
+	strcpy(epp->tunName, ((arg == NULL) || (*arg == '\0')) ? "tap" : arg);
+	if (strcmp(epp->tunName, "tap") && strcmp(epp->tunName, "tun")) {
+		printf("EPP: Invalid interface type - %s\n", epp->tunName);
+		free(epp);
+		return -1;
+	}
+	strcpy(eth->ifName, epp->tunName);
+	eth->Process = epp;
+
+	if (dp_Create(&epp->dp, "EPP", EPP_NSLOTS, ETH_MAX)) {
+		free(epp);
+		eth->Process = NULL;
+		return -1;
+	}
+	epp->dp.Device = eth;
+	epp->dp.Done   = epp_Done;
+	if (dp_Start(&epp->dp, epp_Worker, epp)) {
+		dp_Stop(&epp->dp);
+		free(epp);
+		eth->Process = NULL;
+		return -1;
+	}
+
+	// Wait for device process to open interface (up to 5 seconds).
+	for (idx = 0; (idx < 500) && (epp->State == EPP_STARTING); idx++) {
+		epp->dp.nPolls = DP_CHECKTIME;
+		dp_Poll(&epp->dp);
+		if (epp->State == EPP_STARTING)
+			usleep(10000);
+	}
+	if (epp->State != EPP_READY) {
+		dp_Stop(&epp->dp);
+		free(epp);
+		eth->Process = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+void epp_Close(ETH_DEVICE *eth)
+{
+	EPP_PROCESS *epp = (EPP_PROCESS *)eth->Process;
+
+	if (epp) {
+		dp_Stop(&epp->dp);
+		free(epp);
+	}
+	eth->Process = NULL;
+}
+
+int epp_Send(ETH_DEVICE *eth, uint8 *frame, int len)
+{
+	EPP_PROCESS *epp = (EPP_PROCESS *)eth->Process;
+
+	if (dp_Request(&epp->dp, EPP_TRANSMIT, 0, frame, len)) {
+		eth->nDrops++;
+		return -1;
+	}
+	return len;
+}
+
+void epp_Poll(ETH_DEVICE *eth)
+{
+	EPP_PROCESS *epp = (EPP_PROCESS *)eth->Process;
+
+	if (epp->State != EPP_DEAD)
+		dp_Poll(&epp->dp);
+}
@@ -307,56 +307,103 @@ void rp_SetReady(MBA_DRIVE *mbaDrive)
 	mbaDrive->Callback->SetReady(mbaDrive->pDevice);
 }
 
-int rp_WriteBlock(MBA_DRIVE *mbaDrive)
+// Transfers are done up to rest of current track at once.  Disk
+// blocks are read or written with one disk request per track while
+// data blocks are passed to/from the controller block by block, until
+// the controller tells that transfer is done.  Each routine returns
+// a number of blocks transferred at 'nDone'.  If host disk fails,
+// it returns RP_IOERR with no blocks done.
+
+#define RP_IOERR -3 // Host disk I/O error
+
+int rp_WriteTrack(MBA_DRIVE *mbaDrive, uint32 diskAddr,
+	uint32 nBlocks, uint32 *nDone)
 {
-	RP_DRIVE *rp  = (RP_DRIVE *)mbaDrive->FileRef;
-	uint18   blkData[RP_BLKSZ]; // 16/18-bit data buffer
-	int      rc;
+	RP_DRIVE *rp      = (RP_DRIVE *)mbaDrive->FileRef;
+	uint18   *blkData = rp->trkData; // 16/18-bit data buffer
+	uint32   idx;
+	int      rc = MBA_CONT;
+
+	// Get data blocks from host.
+	for (idx = 0; idx < nBlocks;) {
+		rc = mbaDrive->Callback->ReadBlock(mbaDrive->pDevice,
+			(uint8 *)&blkData[idx * RP_BLKSZ], RP_BLKSZ, MBA_18B);
+		if (rc == MBA_ERROR)
+			break;
+		idx++;
+		if (rc != MBA_CONT)
+			break;
+	}
 
-	// Get data block from host.
-	rc = mbaDrive->Callback->ReadBlock(mbaDrive->pDevice,
-		(uint8 *)blkData, RP_BLKSZ, MBA_18B);
-	if (rc != MBA_ERROR) {
-		if (vdk_WriteDisk(&rp->dpDisk, (uint8 *)blkData, VDK_18B))
-			return MBA_ERROR;
+	// Write all those blocks to disk at once.
+	*nDone = 0;
+	if (idx > 0) {
+		if (vdk_WriteBlocks(&rp->dpDisk, diskAddr, (uint8 *)blkData, idx, VDK_18B))
+			return RP_IOERR;
 	}
+	*nDone = idx;
 
 	return rc;
 }
 
-int rp_CheckBlock(MBA_DRIVE *mbaDrive)
+int rp_CheckTrack(MBA_DRIVE *mbaDrive, uint32 diskAddr,
+	uint32 nBlocks, uint32 *nDone)
 {
-	RP_DRIVE *rp  = (RP_DRIVE *)mbaDrive->FileRef;
-	uint18   blkData1[RP_BLKSZ]; // 16/18-bit buffer
-	uint18   blkData2[RP_BLKSZ]; // 16/18-bit buffer
-	int      idx, rc;
-
-	if (vdk_ReadDisk(&rp->dpDisk, (uint8 *)blkData1, VDK_18B))
-		return MBA_ERROR;
-
-	// Get data block from host.
-	rc = mbaDrive->Callback->ReadBlock(mbaDrive->pDevice,
-		(uint8 *)blkData2, RP_BLKSZ, MBA_18B);
+	RP_DRIVE *rp       = (RP_DRIVE *)mbaDrive->FileRef;
+	uint18   *blkData1 = rp->trkData; // 16/18-bit buffer
+	uint18   blkData2[RP_BLKSZ];      // 16/18-bit buffer
+	uint32   idx, idx2;
+	int      rc = MBA_CONT;
+
+	*nDone = 0;
+	if (vdk_ReadBlocks(&rp->dpDisk, diskAddr, (uint8 *)blkData1, nBlocks, VDK_18B))
+		return RP_IOERR;
+
+	for (idx = 0; idx < nBlocks;) {
+		// Get data block from host.
+		rc = mbaDrive->Callback->ReadBlock(mbaDrive->pDevice,
+			(uint8 *)blkData2, RP_BLKSZ, MBA_18B);
+		if (rc == MBA_ERROR)
+			break;
+		*nDone = ++idx;
 
-	if (rc != MBA_ERROR) {
-		for (idx = 0; idx < RP_BLKSZ; idx++)
-			if (blkData1[idx] != blkData2[idx])
+		for (idx2 = 0; idx2 < RP_BLKSZ; idx2++)
+			if (blkData1[idx2] != blkData2[idx2])
 				return -2;
+		blkData1 += RP_BLKSZ;
 
+		if (rc != MBA_CONT)
+			break;
 	}
 
 	return rc;
 }
 
-int rp_ReadBlock(MBA_DRIVE *mbaDrive)
+int rp_ReadTrack(MBA_DRIVE *mbaDrive, uint32 diskAddr,
+	uint32 nBlocks, uint32 *nDone)
 {
-	RP_DRIVE *rp  = (RP_DRIVE *)mbaDrive->FileRef;
-	uint18   blkData[RP_BLKSZ]; // 16/18-bit data buffer
+	RP_DRIVE *rp      = (RP_DRIVE *)mbaDrive->FileRef;
+	uint18   *blkData = rp->trkData; // 16/18-bit data buffer
+	uint32   idx;
+	int      rc = MBA_CONT;
+
+	// Read all blocks to end of track at once.
+	*nDone = 0;
+	if (vdk_ReadBlocks(&rp->dpDisk, diskAddr, (uint8 *)blkData, nBlocks, VDK_18B))
+		return RP_IOERR;
+
+	// Pass data blocks to host.
+	for (idx = 0; idx < nBlocks;) {
+		rc = mbaDrive->Callback->WriteBlock(mbaDrive->pDevice,
+			(uint8 *)&blkData[idx * RP_BLKSZ], RP_BLKSZ, MBA_18B);
+		if (rc == MBA_ERROR)
+			break;
+		*nDone = ++idx;
+		if (rc != MBA_CONT)
+			break;
+	}
 
-	if (vdk_ReadDisk(&rp->dpDisk, (uint8 *)blkData, VDK_18B))
-		return MBA_ERROR;
-	return mbaDrive->Callback->WriteBlock(mbaDrive->pDevice,
-		(uint8 *)blkData, RP_BLKSZ, MBA_18B);
+	return rc;
 }
 
 void rp_Process(void *dptr)
@@ -368,6 +415,7 @@ void rp_Process(void *dptr)
 	char   *diskName = mbaType->Name;
 	int    fnc       = (RPCS1 & RPCS1_FUNC) >> 1;
 	int    diskAddr;
+	uint32 nBlocks, nDone;
 	int    temp, st;
 	int    savedMode = 0; // temp.
 
@@ -436,35 +484,49 @@ void rp_Process(void *dptr)
 					break;
 				}
 
-				if ((st = vdk_SeekDisk(&rp->dpDisk, diskAddr)) == VDK_OK) {
-					switch (fnc) {
-						case FNC_WR_DATA:
-							st = rp_WriteBlock(mbaDrive);
-							break;
-
-						case FNC_CHK_DATA:
-							st = rp_CheckBlock(mbaDrive);
-							break;
-
-						case FNC_RD_DATA:
-							st = rp_ReadBlock(mbaDrive);
-							break;
-					}
-					if (st == MBA_ERROR)
+				// Transfer up to rest of current track.
+				nBlocks = mbaType->Sectors - (diskAddr % mbaType->Sectors);
+				if (nBlocks > (mbaType->Blocks - diskAddr))
+					nBlocks = mbaType->Blocks - diskAddr;
+				if (nBlocks > RP_MAXSECS)
+					nBlocks = RP_MAXSECS;
+
+				switch (fnc) {
+					case FNC_WR_DATA:
+						st = rp_WriteTrack(mbaDrive, diskAddr, nBlocks, &nDone);
 						break;
 
-					// Update RPDA and RPDC registers
-					diskAddr++;
-					temp = diskAddr % mbaType->Sectors;
-					if (temp == (mbaType->Sectors - 1))
-						RPDS |= RPDS_LST;
-					else
-						RPDS &= ~RPDS_LST;
-					RPDA = temp;
-					temp = diskAddr / mbaType->Sectors;
-					RPDA |= (temp % mbaType->Tracks) << RPDA_P_TA;
-					RPDC = temp / mbaType->Tracks;
+					case FNC_CHK_DATA:
+						st = rp_CheckTrack(mbaDrive, diskAddr, nBlocks, &nDone);
+						break;
+
+					case FNC_RD_DATA:
+						st = rp_ReadTrack(mbaDrive, diskAddr, nBlocks, &nDone);
+						break;
 				}
+
+				// Host disk failed - Leave disk address
+				// at first block not transferred.
+				if (st == RP_IOERR) {
+					RPER1 |= RPER1_OPI;
+					break;
+				}
+				if (nDone == 0)
+					break;
+
+				// Update RPDA and RPDC registers
+				diskAddr += nDone;
+				temp = diskAddr % mbaType->Sectors;
+				if (temp == (mbaType->Sectors - 1))
+					RPDS |= RPDS_LST;
+				else
+					RPDS &= ~RPDS_LST;
+				RPDA = temp;
+				temp = diskAddr / mbaType->Sectors;
+				RPDA |= (temp % mbaType->Tracks) << RPDA_P_TA;
+				RPDC = temp / mbaType->Tracks;
+				if (st == MBA_ERROR)
+					break;
 			} while (st == MBA_CONT);
 
 			// Tell disk controller that transfers are completed
@@ -188,6 +188,7 @@
 //#define RP_BLKSZ18  576 // 256 18-Bit Words per Block (in bytes)
 #define RP_BLKSZ18  (128 * 5) // 128 36-Bit Words per Block
 #define RP_BLKSZ    256 // 256 16/18-bit Words per Block (in words)
+#define RP_MAXSECS  64  // Maximum Sectors per Track (Track Buffer)
 
 // Get C/T/S values from one of drive registers
 #define GetCylinder(c) (c)
@@ -209,4 +210,7 @@ struct rp_Drive {
 	uint32    Flags;     // Drive Flags
 	MBA_DRIVE *mbaDrive; // MASSBUS Drive
 	uint32    idUnit;    // Unit ID
+
+	// Track buffer for full-track transfers
+	uint18    trkData[RP_MAXSECS * RP_BLKSZ];
 };
@@ -69,6 +69,7 @@ typedef struct ioEntry      MAP_IO;
 typedef struct ioCallback   UQ_CALL;
 typedef struct ioBootDevice UQ_BOOT; 
 typedef struct ioInterrupt  UQ_IPL;
+typedef struct iovec        UQ_IOVEC; // Scatter/gather entry for DMA
 
 struct ioEntry {
 	MAP_IO *Next;        // Linked List
@@ -117,6 +118,10 @@ struct ioCallback {
 	// QBA/UBA Interface Routines
 	int    (*SetMap)(void *, MAP_IO *);      // SetMap Routine
 	int    (*Boot)(UQ_BOOT *, int, char **); // Boot Routine
+
+	// Direct Memory Access Functions (byte-addressed memory only)
+	uint32 (*MapBlock)(void *, uint32, uint32, UQ_IOVEC *, int *);
+	void   (*SyncBlock)(void *, uint32, uint32);
 };
 
 struct ioBootDevice {
@@ -195,7 +195,7 @@ struct rl_Drive {
 	// Drive Flags
 	RL_DEVICE *Device;   // Parent Device (Controller)
 	int       idUnit;    // Unit/Drive Identification
-	int       File;      // File Description
+	VDK_DISK  dpDisk;    // Virtual Disk
 	char      *fileName; // Filename
 	uint32    Flags;     // Drive Flags
 	uint16    rlcs;      // Control and Status Register
@@ -46,6 +46,7 @@
 #define RQ_QTIMER   250       // Queue Timer for MSCP Commands
 #define RQ_BLKSZ    512       // Block Size - 512 bytes
 #define RQ_MAXFR    (1 << 16) // Maximum Data Transfer
+#define RQ_MAXVECS  ((RQ_MAXFR / RQ_BLKSZ) + 1) // Maximum DMA Entries
 
 #define RQ_OK       1         // For DTE and HBE packets
 #define RQ_ERROR    0
@@ -113,7 +114,7 @@ struct rq_Drive {
 	char      *dtName;     // Device Type Name (ie RDD40, RD53, etc.)
 	char      *dtDescrip;  // Device Type Description
 	char      *fileName;   // File Name
-	int       File;        // File Descriptor
+	VDK_DISK  dpDisk;      // Disk Descriptor
 	int32     Flags;       // Drive Flags
 	int32     idUnit;      // Unit Identification
 	int32     idMedia;     // Media Identification
@@ -123,6 +124,9 @@ struct rq_Drive {
 	RQ_PACKET *pktWork;    // Working (Current) Packet
 	RQ_PACKET *pktQueue;   // Packet Queue
 	CLK_QUEUE xfrTimer;    // Data Transfer Timer
+	VDK_IOREQ ioReq;       // Host I/O Request (in progress)
+	uint8     *bufData;    // Data Transfers
+	UQ_IOVEC  ioVec[RQ_MAXVECS]; // Host Memory for Direct Transfers
 };
 
 struct rq_Controller {
@@ -162,7 +166,6 @@ struct rq_Controller {
 	// Disk/Tape Device Units
 	int       nDrives;     // Number of disk/tape drives
 	RQ_DRIVE  *Drives;
-	uint8     *bufData;    // Data Transfers
 
 	// Unibus/Q22-Bus I/O Table
 	MAP_IO    ioMap;
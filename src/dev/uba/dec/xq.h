@@ -182,6 +182,12 @@
 
 // Delay timer
 #define QNA_DELAY  500
+#define QNA_RXDELAY 10  // Receive batch delay (instructions)
+
+// Interrupt coalescing and batched transmit
+#define QNA_TXBATCH   64    // Frames per transmit batch
+#define QNA_IRQFRAMES 8     // Frames per interrupt (default)
+#define QNA_IRQDELAY  1000  // Interrupt delay (default, instructions)
 
 // Register List (Index from CSR Base in 16-bit Words)
 #define nPROM0   0 // Station Address PROM #0
@@ -293,7 +299,9 @@
 
 // FIFO Queue
 #define FIFO_SIZE    8192    // 8K FIFO buffer
-#define QNA_NPKTS    512     // Hold up to 512 ethernet packets
+#define QNA_NPKTS    512     // Receive ring size (default)
+#define QNA_MINPKTS  16      // Receive ring size (minimum)
+#define QNA_MAXPKTS  8192    // Receive ring size (maximum)
 
 // Ethernet packet type for the circular queue.
 #define PKT_INVALID  0  // Invalid Packet
@@ -301,7 +309,7 @@
 #define PKT_LOOPBACK 2  // Loopback Packet
 #define PKT_SETUP    3  // Setup Packet
 
-// OpenTUN function - result code
+// OpenEther function - result code
 #define EPP_TUN_IOERROR -1
 #define EPP_TUN_INVALID -2
 
@@ -334,11 +342,13 @@ struct qna_Buffer {
 	uint16  Status2;   // Status Word #2
 };
 
+// Receive ring slot - frame buffers are owned by
+// the ring (ETH_MAX bytes each in pktBuffer).
 struct qna_Packet {
-	uint32     idPacket;
-	uint32     Type;
-	uint16     Status[2];
-	ETH_PACKET Data;
+	uint32     Type;      // Packet Type
+	uint16     Status[2]; // Receive Status Words
+	int        Len;       // Frame Length
+	uint8      *Data;     // Frame Buffer
 };
 
 struct qna_Device {
@@ -353,17 +363,17 @@ struct qna_Device {
 	// Unibus/Qbus I/O Table
 	MAP_IO    ioMap;
 
-//	DP        dp;          // Device Process Area
-	SOCKET    *World;      // Gateway to the world
+	ETH_DEVICE *World;     // Gateway to the world
 	uint32    Flags;       // Controller Flags
 	uint32    csrAddr;     // CSR Base Address
 	uint16    intVector;   // Interrupt Vector Address
 	int       LED;         // LED Display
-	CLK_QUEUE rxTimer;     // Receive Delay Timer
+	CLK_QUEUE rxTimer;     // Receive Batch Timer
 	CLK_QUEUE txTimer;     // Transmit Delay Timer
+	CLK_QUEUE irqTimer;    // Interrupt Coalescing Timer
 
 	// DEQNA Registers
-	uint8     tunAddr[8];      // TUN/TAP Ethernet Address
+	uint8     tunAddr[8];      // Host Ethernet Address
 	uint8     ownAddr[8];      // PROM Ethernet Address w/Checksum
 	uint32    nAddrs;          // # of Ethernet Addresses
 	uint8     ethAddr[14][8];  // Ethernet Addresses
@@ -373,9 +383,20 @@ struct qna_Device {
 	uint16    csr;             // Control/Status Register
 
 	// Circular Packet Queue Management
+	int        nPkts;     // Number of Ring Slots
 	int        pktHead;   // Current Queue Head
-	int        pktTail;   // Current Queue Tail
+	int        pktTail;   // Next Slot to Fill
 	int        pktCount;  // Packet Queue Count
 	int        pktLoss;   // Packet Loss
-	QNA_PACKET pktList[QNA_NPKTS];
+	QNA_PACKET *pktList;  // Ring Slots
+	uint8      *pktBuffer; // Frame Buffers
+
+	// Interrupt Coalescing and Batched Transmit
+	int        irqFrames;  // Frames per interrupt (0 = Off)
+	int        irqDelay;   // Interrupt delay (instructions)
+	int        irqCount;   // Frames since last interrupt
+	uint16     irqPending; // Pending interrupt bits (RI/XI)
+	int        txCount;    // Frames in transmit batch
+	uint8      *txBuffer;  // Transmit batch buffers
+	struct iovec txFrames[QNA_TXBATCH];
 };
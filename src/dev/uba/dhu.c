@@ -331,7 +331,7 @@ void dhu_TransmitDMA(void *dev)
 
 		// Send good data to outside.
 		if (len) {
-			sock_Print(tty->Socket, (char *)bufData, len);
+			sock_Output(tty->Socket, (char *)bufData, len);
 			hstAddr  += len;
 			cntBytes -= len;
 		}
@@ -386,7 +386,7 @@ void dhu_Transmit(void *dev)
 
 	if (tty->Socket && (TXCH & TXCH_VALID)) {
 		ch = TXCH;
-		sock_Print(tty->Socket, &ch, 1);
+		sock_Output(tty->Socket, &ch, 1);
 
 		// Done, ring host for next transmit.
 		TXCH &= ~TXCH_VALID;
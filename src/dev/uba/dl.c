@@ -284,7 +284,7 @@ void dl_Output(DL_TTY *dl)
 	XCSR &= ~XCSR_RDY;
 	ch = XBUF;
 
-	sock_Print(dl->Socket, &ch, 1);
+	sock_Output(dl->Socket, &ch, 1);
 
 	// Log a character into a log file.
 	if (ch == '\n') {
@@ -396,7 +396,7 @@ void dz_Output(DZ_TTY *tty)
 //	if (tty->Socket && (TXCH & TXCH_VALID)) {
 	if (tty->Socket) {
 		ch = TDR;
-		sock_Print(tty->Socket, &ch, 1);
+		sock_Output(tty->Socket, &ch, 1);
 
 		// Done, ring host for next transmit.
 //		TXCH &= ~TXCH_VALID;
@@ -25,6 +25,7 @@
 // Timothy M Stark.
 
 #include "emu/defs.h"
+#include "emu/vdisk.h"
 #include "dec/rl.h"
 
 #ifdef DEBUG
@@ -73,7 +74,7 @@ void rl_SetDone(RL_DRIVE *drv, uint16 st)
 // Initialize DEC standard 044 bad block table.
 int rl_InitBadBlocks(RL_DRIVE *drv)
 {
-	uint32 dskAddr = drv->totBytes - (RL_NSECS * RL_BSEC);
+	uint32 dskAddr = (drv->totBytes / RL_BSEC) - RL_NSECS;
 	uint16 buf[RL_WSEC];
 	uint32 idx;
 
@@ -85,9 +86,21 @@ int rl_InitBadBlocks(RL_DRIVE *drv)
 	for (idx = 4; idx < RL_WSEC; idx++)
 		buf[idx] = 0177777u;
 
-	lseek(drv->File, dskAddr, SEEK_SET);
 	for (idx = 0; idx < RL_NSECS; idx++)
-		write(drv->File, (char *)buf, RL_BSEC);
+		vdk_WriteBlocks(&drv->dpDisk, dskAddr + idx, (uint8 *)buf, 1, 0);
+}
+
+// Get host error code for VDK error code returned by last call.
+// Only VDK_IOERROR comes with its own error code in vdk->errCode.
+static int32 rl_GetError(VDK_DISK *vdk, int rc)
+{
+	switch (rc) {
+		case VDK_IOERROR: return vdk->errCode ? vdk->errCode : EIO;
+		case VDK_MEMERR:  return ENOMEM;
+		case VDK_WRPROT:  return EROFS;
+		case VDK_ADRERR:  return EINVAL;
+	}
+	return EIO;
 }
 
 void rl_Service(void *dptr)
@@ -95,12 +108,15 @@ void rl_Service(void *dptr)
 	RL_DEVICE *rl      = (RL_DEVICE *)dptr;
 	RL_DRIVE  *drv     = &rl->Drives[GET_DS(rl->rlcs)];
 	uint16    func     = GET_FUNC(rl->rlcs);
+	VDK_DISK  *vdk     = &drv->dpDisk;
+	UQ_CALL   *call    = rl->Callback;
 	uint8     *bufData = &rl->bufData[0];
 	uint8     *bufComp;
 	uint32    dskAddr, hstAddr;
 	uint16    wCount, awCount;
 	int16     xfrCount, maxCount;
 	uint32    idx;
+	int       rc;
 	int32     errCode = 0;
 
 #ifdef DEBUG
@@ -168,7 +184,7 @@ void rl_Service(void *dptr)
 
 			// Get disk address and memory address to
 			// prepare for data transfers.
-			dskAddr = GET_DA(rl->rlda) * RL_BSEC;
+			dskAddr = GET_DA(rl->rlda);
 			hstAddr = (rl->rlbae << 16) + rl->rlba;
 
 			// Get word count and maxize data transfer.
@@ -177,57 +193,53 @@ void rl_Service(void *dptr)
 			if (wCount > maxCount)
 				wCount = maxCount;
 
-			// Now perform data transfers.
-			if (lseek(drv->File, dskAddr, SEEK_SET) < 0) {
-				errCode = errno;
-			} else {
-				UQ_CALL *call = rl->Callback;
-
-				if (func == FUNC_READ) {
-					// Read Data
-					if ((xfrCount = read(drv->File, bufData, (wCount << 1))) < 0)
-						errCode = errno;
-					for (; xfrCount < wCount; xfrCount++)
-						bufData[xfrCount] = 0; // Fill buffer
-					if (xfrCount = call->WriteBlock(rl->System, hstAddr, bufData, wCount << 1, 0)) {
-						rl->rlcs |= (RLCS_ERR|RLCS_NXM);
-						wCount -= xfrCount >> 1;
-					}
+			// Now perform data transfers in whole sectors.
+			// Blocks beyond end of image file are read as zeros.
+			awCount = (wCount + (RL_WSEC - 1)) & ~(RL_WSEC - 1);
+			if (func == FUNC_READ) {
+				// Read Data
+				if (rc = vdk_ReadBlocks(vdk, dskAddr, bufData, awCount / RL_WSEC, 0))
+					errCode = rl_GetError(vdk, rc);
+				if (errCode > 0)
+					wCount = 0;
+				else if (xfrCount = call->WriteBlock(rl->System, hstAddr, bufData, wCount << 1, 0)) {
+					rl->rlcs |= (RLCS_ERR|RLCS_NXM);
+					wCount -= xfrCount >> 1;
+				}
 #ifdef DEBUG
 //					if (dbg_Debug(DBG_IODATA)) {
 //						dbg_Printf("%s: Read Data\n", drv->devName);
 //						PrintDump(0, bufData, wCount << 1);
 //					}
 #endif /* DEBUG */
-				} else if (func == FUNC_WRITE) {
-					// Write Data
-					if (xfrCount = call->ReadBlock(rl->System, hstAddr, bufData, wCount << 1, 0)) {
-						rl->rlcs |= (RLCS_ERR|RLCS_NXM);
-						wCount -= xfrCount >> 1;
-					}
-					if (wCount) {
-						uint16 awCount = (wCount + (RL_WSEC - 1)) & ~(RL_WSEC - 1);
-						uint16 idx;
-
-						for (idx = wCount; idx < awCount; idx++)
-							bufData[idx] = 0; // Fill buffer
-						if (write(drv->File, bufData, (wCount << 1)) < 0)
-							errCode = errno;
+			} else if (func == FUNC_WRITE) {
+				// Write Data
+				if (xfrCount = call->ReadBlock(rl->System, hstAddr, bufData, wCount << 1, 0)) {
+					rl->rlcs |= (RLCS_ERR|RLCS_NXM);
+					wCount -= xfrCount >> 1;
+				}
+				if (wCount) {
+					awCount = (wCount + (RL_WSEC - 1)) & ~(RL_WSEC - 1);
+					memset(&bufData[wCount << 1], 0, (awCount - wCount) << 1);
+					if (rc = vdk_WriteBlocks(vdk, dskAddr, bufData, awCount / RL_WSEC, 0)) {
+						// Nothing was written for sure.
+						errCode = rl_GetError(vdk, rc);
+						wCount  = 0;
 					}
+				}
 #ifdef DEBUG
 //					if (dbg_Debug(DBG_IODATA)) {
 //						dbg_Printf("%s: Write Data\n", drv->devName);
 //						PrintDump(0, bufData, wCount << 1);
 //					}
 #endif /* DEBUG */
-				} else if (func == FUNC_WRCHK) {
-					// Write Check
-					if ((xfrCount = read(drv->File, bufData, wCount << 1)) < 0)
-						errCode = errno;
-					for (; xfrCount < (wCount << 1); xfrCount++)
-						bufData[xfrCount] = 0; // Fill buffer
-					if (errCode > 0)
-						break;
+			} else if (func == FUNC_WRCHK) {
+				// Write Check
+				if (rc = vdk_ReadBlocks(vdk, dskAddr, bufData, awCount / RL_WSEC, 0))
+					errCode = rl_GetError(vdk, rc);
+				if (errCode > 0)
+					wCount = 0;
+				else {
 					bufComp = &rl->bufData[wCount << 1];
 					if (xfrCount = call->ReadBlock(rl->System, hstAddr, bufComp, wCount << 1, 0)) {
 						rl->rlcs |= (RLCS_ERR|RLCS_NXM);
@@ -248,6 +260,11 @@ void rl_Service(void *dptr)
 				}
 			}
 
+			// Host disk failed - Report drive error and
+			// leave registers at first word not transferred.
+			if (errCode > 0)
+				rl->rlcs |= (RLCS_ERR|RLCS_DRE);
+
 #ifdef DEBUG
 			if (dbg_Check(DBG_IODATA) && (errCode > 0))
 //			if (errCode > 0)
@@ -579,25 +596,35 @@ int rl_Attach(MAP_DEVICE *map, int argc, char **argv)
 {
 	RL_DEVICE  *rl  = (RL_DEVICE *)map->Device;
 	RL_DRIVE   *drv = &rl->Drives[map->idUnit];
-	int32      off; // Offset from beginning of file.
+	VDK_DISK   *vdk = &drv->dpDisk;
+	int32      off; // Size of disk image
 
-	if (drv->File) {
+	if (drv->Flags & DFLG_ATTACHED) {
 		printf("%s: Already attached. Please use DETACH first.\n",
 			drv->devName);
 		return EMU_OPENERR;
 	}
 
-	if ((drv->File = open(argv[2], O_RDWR|O_CREAT, 0700)) < 0) {
+	// Set up virtual disk as largest cartridge (RL02)
+	// and then check image size for its drive type.
+	memset(vdk, 0, sizeof(VDK_DISK));
+	vdk->fileName  = argv[2];
+	vdk->fmtName   = "dsk";
+	vdk->Cylinders = RL02_CYL;
+	vdk->Tracks    = RL02_HEAD;
+	vdk->Sectors   = RL_NSECS;
+	vdk->vsBlock   = RL_BSEC;
+
+	if (vdk_OpenDisk(vdk) != VDK_OK) {
 		printf("%s: file '%s' not attached - %s.\n",
-			drv->devName, argv[2], strerror(errno));
+			drv->devName, argv[2], strerror(vdk->errCode));
 		return EMU_OPENERR;
 	}
 
-	if ((off = lseek(drv->File, 0, SEEK_END)) < 0) {
-		printf("%s: file 's': %s\n",
+	if ((off = vdk_GetImageSize(vdk)) < 0) {
+		printf("%s: file '%s': %s\n",
 			drv->devName, argv[2], strerror(errno));
-		close (drv->File);
-		drv->File = 0;
+		vdk_CloseDisk(vdk);
 		return EMU_OPENERR;
 	}
   
@@ -634,11 +661,15 @@ int rl_Attach(MAP_DEVICE *map, int argc, char **argv)
 		// No, this file is not RLO1 or RL02 disk file.
 		printf("%s: file '%s' is not RL01 or RL02 disk file.\n",
 			drv->devName, argv[2]);
-		close (drv->File);
-		drv->File = 0;
+		vdk_CloseDisk(vdk);
 		return EMU_OPENERR;
 	}
 
+	// Limit virtual disk to its drive type.
+	vdk->Cylinders = drv->totCyls;
+	vdk->Blocks    = vdk->Cylinders * vdk->Tracks * vdk->Sectors;
+	vdk->szImage   = vdk->Blocks * vdk->szBlock;
+
 	// Set up drive flags
 	drv->Flags   |= DFLG_ATTACHED;
 	drv->rlcs    |= RLCS_DRDY;
@@ -653,6 +684,7 @@ int rl_Attach(MAP_DEVICE *map, int argc, char **argv)
 		printf("%s: Can't assign the name of '%s' - Not enough memory.\n",
 			drv->fileName, argv[2]);
 	}
+	vdk->fileName = drv->fileName;
 
 	return EMU_OK;
 }
@@ -662,7 +694,7 @@ int rl_Detach(MAP_DEVICE *map, int argc, char **argv)
 	RL_DEVICE  *rl  = (RL_DEVICE *)map->Device;
 	RL_DRIVE   *drv = &rl->Drives[map->idUnit];
 
-	if (drv->File) {
+	if (drv->Flags & DFLG_ATTACHED) {
 		// First, cancel all pending disk operations.
 //		ts10_CancelTimer(&drv->svcTimer);
 
@@ -672,8 +704,7 @@ int rl_Detach(MAP_DEVICE *map, int argc, char **argv)
 		drv->track    = 0;
 
 		// Now close disk file.
-		close(drv->File);
-		drv->File = 0;
+		vdk_CloseDisk(&drv->dpDisk);
 
 		// Tell operator that.
 		printf("%s: file '%s' detached.\n", drv->devName,
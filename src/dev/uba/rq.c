@@ -37,6 +37,7 @@
 // -------------------------------------------------------------------------
 
 #include "emu/defs.h"
+#include "emu/vdisk.h"
 #include "dec/rq.h"
 
 // ********************************************************************
@@ -662,6 +663,7 @@ int rq_MscpAbort(RQ_DEVICE *rq, RQ_PACKET *pkt, uint32 q)
 		tpkt = NULL;
 		if (drv->pktWork && (UQ_GETP32(drv->pktWork, CMD_REFL) == ref)) {
 			ts10_CancelTimer(&drv->xfrTimer);
+			vdk_CancelIO(&drv->ioReq);
 			tpkt = drv->pktWork;
 			drv->pktWork = NULL;
 		} else if (drv->pktQueue &&
@@ -1032,16 +1034,24 @@ int rq_DataDone(RQ_DRIVE *drv, uint32 flg, uint32 sts)
 }
 
 // Read/Write Data Processing during queue timer
+//
+// Host disk transfer is passed to I/O thread, and data transfer
+// continues at rq_DoneData when it is done.  Each drive has own
+// data buffer, so that all drives may have transfers in progress
+// at the same time.  If bus maps whole blocks of host memory,
+// read and write data are transferred directly between disk image
+// and emulated memory instead of data buffer.
 void rq_ProcessData(void *dptr)
 {
 	RQ_DRIVE  *drv     = (RQ_DRIVE *)dptr;
 	RQ_DEVICE *rq      = drv->rqDevice;
 	RQ_PACKET *pkt     = drv->pktWork;
 	UQ_CALL   *call    = rq->Callback;
-	uint8     *bufData = rq->bufData;
+	uint8     *bufData = drv->bufData;
+	VDK_IOREQ *req     = &drv->ioReq;
 	uint32    cmd, hstAddr, cntBytes;
-	uint32    lbnBlock, dskAddr;
-	uint32    wbc, tbc, abc, sts, err;
+	uint32    lbnBlock;
+	uint32    wbc, tbc, abc, sts;
 	int32     rbc;
 
 	// Check if the packet is existing.
@@ -1058,7 +1068,6 @@ void rq_ProcessData(void *dptr)
 	hstAddr  = UQ_GETP32(pkt, RW_WBAL);
 	cntBytes = UQ_GETP32(pkt, RW_WBCL);
 	lbnBlock = UQ_GETP32(pkt, RW_WLBNL);
-	dskAddr  = lbnBlock * RQ_BLKSZ;
 
 	if ((drv->Flags & DFL_ATTACHED) == 0) {
 		// Unit not attached.
@@ -1074,6 +1083,7 @@ void rq_ProcessData(void *dptr)
 
 	// Up to maximum bytes of data transfer each time.
 	tbc = (cntBytes > RQ_MAXFR) ? RQ_MAXFR : cntBytes;
+	wbc = ((tbc + (RQ_BLKSZ - 1)) & ~(RQ_BLKSZ - 1));
 
 	// Check write protection aganist write access first
 	if ((cmd == OP_ERS) || (cmd == OP_WR)) {
@@ -1084,14 +1094,22 @@ void rq_ProcessData(void *dptr)
 		}
 	}
 
-	// Now process data transfers
-	if (cmd == OP_ERS) {
-		wbc = ((tbc + (RQ_BLKSZ - 1)) & ~(RQ_BLKSZ - 1));
-		memset(bufData, 0, wbc);
+	// Map host memory for direct transfers if available.
+	req->nVecs = 0;
+	if (call->MapBlock && (tbc == wbc) && ((cmd == OP_RD) || (cmd == OP_WR))) {
+		int nVecs = RQ_MAXVECS;
+		if (call->MapBlock(rq->System, hstAddr, tbc, drv->ioVec, &nVecs) == tbc) {
+			req->ioVec = drv->ioVec;
+			req->nVecs = nVecs;
+		}
+	}
 
-		// Write a block to virtual disk.
-		if ((err = lseek(drv->File, dskAddr, SEEK_SET)) == 0)
-			err = write(drv->File, bufData, wbc);
+	// Now set up host disk transfer.
+	if (req->nVecs > 0) {
+		req->Func = (cmd == OP_WR) ? VDK_WRITE : VDK_READ;
+	} else if (cmd == OP_ERS) {
+		memset(bufData, 0, wbc);
+		req->Func = VDK_WRITE;
 	} else if (cmd == OP_WR) {
 		// Get a block from host.
 		if (rbc = call->ReadBlock(rq->System, hstAddr, bufData, tbc, 0)) {
@@ -1102,55 +1120,78 @@ void rq_ProcessData(void *dptr)
 				rq_DataDone(drv, EF_LOG, ST_HST|SB_HST_NXM);
 			return;
 		}
+		if (wbc - tbc)
+			memset(&bufData[tbc], 0, wbc - tbc);
+		req->Func = VDK_WRITE;
+	} else
+		req->Func = VDK_READ;
 
-		// Write a block to virtual disk.
-		err = 0;
-		wbc = ((tbc + (RQ_BLKSZ - 1)) & ~(RQ_BLKSZ - 1));
-		if (lseek(drv->File, dskAddr, SEEK_SET) >= 0) {
-			if (wbc - tbc)
-				memset(&bufData[tbc], 0, wbc - tbc);
-			if (write(drv->File, bufData, wbc) < 0)
-				err = errno;
-		} else
-			err = errno;
+	req->dskAddr = lbnBlock;
+	req->Data    = bufData;
+	req->nBlocks = wbc / RQ_BLKSZ;
+	req->Mode    = 0;
+	if (vdk_StartIO(req)) {
+		if (rq_SendDataError(drv, pkt, ST_DRV))
+			rq_DataDone(drv, EF_LOG, ST_DRV);
+	}
 
-#ifdef DEBUG
-		if (dbg_Check(DBG_IODATA))
-			dbg_Printf("%s: LBN = %d  Write %d of %d bytes\n",
-				rq->keyName, lbnBlock, wbc, cntBytes);
-#endif /* DEBUG */
-	} else {
-		if (lseek(drv->File, dskAddr, SEEK_SET) >= 0) {
-			if ((rbc = read(drv->File, bufData, tbc)) >= 0) {
-				for (; rbc < (tbc - 1); rbc++)
-					bufData[rbc] = 0;
-			}
-			err = 0;
-		} else
-			err = errno;
+	return /* TS10_OK */;
+}
+
+// Read/Write Data Completion from I/O thread
+void rq_DoneData(VDK_IOREQ *req)
+{
+	RQ_DRIVE  *drv     = (RQ_DRIVE *)req->Device;
+	RQ_DEVICE *rq      = drv->rqDevice;
+	RQ_PACKET *pkt     = drv->pktWork;
+	UQ_CALL   *call    = rq->Callback;
+	uint8     *bufData = drv->bufData;
+	uint32    cmd, hstAddr, cntBytes;
+	uint32    lbnBlock;
+	uint32    tbc, abc, err;
+	int32     rbc;
+
+	// Check if the packet is existing.
+	if (pkt == NULL)
+		return;
+
+	cmd      = UQ_GETP(pkt, CMD_OPC, OPC);
+	hstAddr  = UQ_GETP32(pkt, RW_WBAL);
+	cntBytes = UQ_GETP32(pkt, RW_WBCL);
+	lbnBlock = UQ_GETP32(pkt, RW_WLBNL);
+	tbc      = (cntBytes > RQ_MAXFR) ? RQ_MAXFR : cntBytes;
+
+	// Blocks beyond end of image file are read as zeros.
+	err = 0;
+	if (req->Result)
+		err = req->errCode ? req->errCode : EIO;
 
 #ifdef DEBUG
-		if (dbg_Check(DBG_IODATA))
-			dbg_Printf("%s: LBN = %d  Read %d of %d bytes\n",
-				rq->keyName, lbnBlock, rbc, cntBytes);
+	if (dbg_Check(DBG_IODATA))
+		dbg_Printf("%s: LBN = %d  %s %d of %d bytes\n",
+			rq->keyName, lbnBlock, (req->Func == VDK_WRITE) ? "Write" : "Read",
+			err ? 0 : req->nBlocks * RQ_BLKSZ, cntBytes);
 #endif /* DEBUG */
 
-		if ((cmd == OP_RD) && !err) {
-			if (rbc = call->WriteBlock(rq->System, hstAddr, bufData, tbc, 0)) {
-				abc = tbc - rbc;
-				UQ_PUTP32(pkt, RW_WBCL, cntBytes - abc);
-				UQ_PUTP32(pkt, RW_WBAL, hstAddr + abc);
-				if (rq_SendHostError(rq, pkt))
-					rq_DataDone(drv, EF_LOG, ST_HST|SB_HST_NXM);
-				return;
-			}
-		} else if ((cmd == OP_CHD) && !err) {
+	if ((cmd == OP_RD) && (req->nVecs > 0)) {
+		// Data were read into host memory directly.
+		if (call->SyncBlock)
+			call->SyncBlock(rq->System, hstAddr, tbc);
+	} else if ((cmd == OP_RD) && !err) {
+		if (rbc = call->WriteBlock(rq->System, hstAddr, bufData, tbc, 0)) {
+			abc = tbc - rbc;
+			UQ_PUTP32(pkt, RW_WBCL, cntBytes - abc);
+			UQ_PUTP32(pkt, RW_WBAL, hstAddr + abc);
+			if (rq_SendHostError(rq, pkt))
+				rq_DataDone(drv, EF_LOG, ST_HST|SB_HST_NXM);
+			return;
+		}
+	} else if ((cmd == OP_CHD) && !err) {
 #ifdef DEBUG
-			if (dbg_Check(DBG_IODATA))
-				dbg_Printf("%s: Compare is not implemented yet.\n",
-					rq->keyName);
+		if (dbg_Check(DBG_IODATA))
+			dbg_Printf("%s: Compare is not implemented yet.\n",
+				rq->keyName);
 #endif /* DEBUG */
-		}
 	}
 
 	if (err != 0) {
@@ -1176,8 +1217,6 @@ void rq_ProcessData(void *dptr)
 		ts10_SetTimer(&drv->xfrTimer);
 	else
 		rq_DataDone(drv, 0, ST_SUC);
-
-	return /* TS10_OK */;
 }
 
 // Format Command (for floppy drives only)
@@ -1427,6 +1466,7 @@ void rq_ResetDevice(RQ_DEVICE *rq)
 	for (idx = 0; idx < rq->nDrives; idx++) {
 		drv = &rq->Drives[idx];
 		ts10_CancelTimer(&drv->xfrTimer);
+		vdk_CancelIO(&drv->ioReq);
 		drv->Flags    &= ~DFL_ONLINE;
 		if (drv->dtInfo)
 			drv->uFlags = drv->dtInfo->Flags | UF_RPL;
@@ -1689,9 +1729,6 @@ void *rq_Create(MAP_DEVICE *newMap, int argc, char **argv)
 		rq->csrAddr    = UQ_IOADDR;
 		rq->intVector  = 0;
 
-		// Create data buffer for data transfers.
-		rq->bufData = (uint8 *)calloc(1, RQ_MAXFR);
-
 		// Set up the new queue timer.
 		newTimer           = &rq->queTimer;
 		newTimer->Next     = NULL;
@@ -1711,6 +1748,13 @@ void *rq_Create(MAP_DEVICE *newMap, int argc, char **argv)
 			drv->idUnit   = idx;
 			drv->rqDevice = rq;
 
+			// Create data buffer and host I/O request
+			// for data transfers.
+			drv->bufData       = (uint8 *)calloc(1, RQ_MAXFR);
+			drv->ioReq.vdk     = &drv->dpDisk;
+			drv->ioReq.Device  = drv;
+			drv->ioReq.Done    = rq_DoneData;
+
 			// Set up the new response timer.
 			newTimer           = &drv->xfrTimer;
 			newTimer->Next     = NULL;
@@ -1812,7 +1856,8 @@ int rq_Attach(MAP_DEVICE *map, int argc, char **argv)
 {
 	RQ_DEVICE *rq  = (RQ_DEVICE *)map->Device;
 	RQ_DRIVE  *drv = &rq->Drives[map->idUnit];
-	uint32    mode = (drv->dtInfo->Flags & UF_WPH) ? O_RDONLY : O_RDWR|O_CREAT;
+	RQ_DTYPE  *dt  = drv->dtInfo;
+	VDK_DISK  *vdk = &drv->dpDisk;
 
 	if (drv->Flags & DFL_ATTACHED) {
 		printf("%s: Already attached.  Please use 'detach %s:' first.\n",
@@ -1820,9 +1865,20 @@ int rq_Attach(MAP_DEVICE *map, int argc, char **argv)
 		return EMU_OK;
 	}
 
-	if ((drv->File = open(argv[2], mode, 0700)) < 0) {
+	// Set up virtual disk for user and RCT blocks.
+	memset(vdk, 0, sizeof(VDK_DISK));
+	vdk->fileName  = argv[2];
+	vdk->fmtName   = "dsk";
+	vdk->devType   = drv->dtName;
+	vdk->Flags     = (dt->Flags & UF_WPH) ? VDK_WRLOCK : 0;
+	vdk->Cylinders = 1;
+	vdk->Tracks    = 1;
+	vdk->Sectors   = dt->lbn + (dt->rcts * (dt->rctc ? dt->rctc : 1));
+	vdk->vsBlock   = RQ_BLKSZ;
+
+	if (vdk_OpenDisk(vdk) != VDK_OK) {
 		printf("%s: File '%s' not attached - %s.\n",
-			drv->devName, argv[2], strerror(errno));
+			drv->devName, argv[2], strerror(vdk->errCode));
 		return EMU_OPENERR;
 	}
 
@@ -1840,6 +1896,7 @@ int rq_Attach(MAP_DEVICE *map, int argc, char **argv)
 		printf("%s: Can't assign the name of '%s' - Not enough memory.\n",
 			map->devName, argv[2]);
 	}
+	vdk->fileName = drv->fileName;
 
 	return EMU_OK;
 }
@@ -1854,12 +1911,17 @@ int rq_Detach(MAP_DEVICE *map, int argc, char **argv)
 		return EMU_OK;
 	}
 
-	close(drv->File);
+	// Wait for host disk transfer in progress.
+	vdk_CancelIO(&drv->ioReq);
+	vdk_CloseDisk(&drv->dpDisk);
 
 	// Clear flags as detached status.
 	drv->Flags  &= ~(DFL_ATTACHED|DFL_ONLINE|DFL_ATNPEND);
 	drv->uFlags &= (UF_RPL|UF_WPH|UF_RMV);
-	drv->File   =  0;
+
+	// Current command will end with offline status.
+	if (drv->pktWork)
+		ts10_SetTimer(&drv->xfrTimer);
 
 	// Tell operator that.
 	printf("%s: file '%s' detached.\n", drv->devName,
@@ -2175,6 +2175,8 @@ int tq_Attach(MAP_DEVICE *map, int argc, char **argv)
 	if (tq->State == CST_UP)
 		drv->Flags |= DF_ATP;
 	drv->uFlags = drv->dtInfo->uFlags;
+	if (vmt->Flags & VMT_WRLOCK)
+		drv->uFlags |= UF_WPH; // Compressed tape is read only.
 
 	// Tell operator that and save it.
 	printf("%s: File '%s' attached.\n", drv->Unit.devName, argv[2]);
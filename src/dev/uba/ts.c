@@ -249,7 +249,7 @@ uint32 ts_Unload(TS_DEVICE *ts)
 		free(vmt->fileName);
 		vmt->fileName = NULL;
 	}
-	ts->Flags &= ~TS_ATTACHED;
+	ts->Flags &= ~(TS_ATTACHED|TS_WLOCK);
 
 	return 0;
 }
@@ -909,6 +909,8 @@ int ts_Attach(MAP_DEVICE *map, int argc, char **argv)
 
 	// Update TS11/TSV05 registers
 	ts->Flags |= TS_ATTACHED;
+	if (vmt->Flags & VMT_WRLOCK)
+		ts->Flags |= TS_WLOCK; // Compressed tape is read only.
 	TSSR &= ~TSSR_OFL;
 	if (!(TSSR & TSSR_NBA) && (wchOpts & WCH_EAI)) {
 		if (ts->Flags & TS_OWNMSG) {
@@ -960,7 +962,7 @@ int ts_Detach(MAP_DEVICE *map, int argc, char **argv)
 	vmt->fmtName = NULL;
 
 	// Update TS11/TSV05 registers
-	ts->Flags &= ~TS_ATTACHED;
+	ts->Flags &= ~(TS_ATTACHED|TS_WLOCK);
 	TSSR |= TSSR_OFL;
 	if (!(TSSR & TSSR_NBA) && (wchOpts & WCH_EAI)) {
 		if (ts->Flags & TS_OWNMSG) {
@@ -130,8 +130,10 @@ void xq_DumpPacket(uchar *pkt, int len)
 }
 #endif /* DEBUG */
 
-void xq_InputWorld(SOCKET *, char *, int);
-void xq_Enqueue(QNA_DEVICE *, int, ETH_PACKET *, uint16 *);
+void xq_InputWorld(void *, uint8 *, int);
+void xq_PostIRQ(QNA_DEVICE *, uint16);
+void xq_SetFilter(QNA_DEVICE *);
+void xq_Enqueue(QNA_DEVICE *, int, uint8 *, int, uint16 *);
 void xq_Dequeue(QNA_DEVICE *);
 void xq_FlushQueue(QNA_DEVICE *);
 int  xq_PutFrame(QNA_DEVICE *, uint8 *, int);
@@ -170,41 +172,37 @@ void xq_MakeChecksum(QNA_DEVICE *qna, uint8 *ethAddr)
 #endif /* DEBUG */
 }
 
-// Usage: create ... <tun|tap>
-SOCKET *xq_OpenTUN(QNA_DEVICE *qna, char *name)
+// Usage: attach ... <tun|tap|packet:<if>|vsw:<name>|proc:<tap|tun>>
+ETH_DEVICE *xq_OpenEther(QNA_DEVICE *qna, char *name)
 {
-	SOCKET *tun;
-	char   tunName[40];
-
-	strcpy(tunName, name);
-	if(tun = sock_Open(tunName, 0, NET_TUN)) {
-		tun->Accept  = NULL;
-		tun->Eof     = NULL;
-		tun->Process = xq_InputWorld;
-		tun->Device  = qna;
-		qna->World   = tun;
-
-		// Get Ethernet Address from TUN/TAP connection.
-		SockGetEtherAddr(tun->Name, qna->tunAddr);
+	ETH_DEVICE *eth;
+
+	if (eth = OpenEther(name, qna, xq_InputWorld)) {
+		qna->World = eth;
+
+		// Get Ethernet Address from that connection.
+		memcpy(qna->tunAddr, eth->hostAddr, sizeof(ETH_MAC));
+		if (qna->nAddrs)
+			xq_SetFilter(qna);
 		xq_MakeChecksum(qna, qna->tunAddr);
 
 		// Tell operator that.
-		printf("%s: Opening TUN connection: %s (%s).\n",
-			qna->Unit.devName, tunName,
-			eth_FormatAddress(qna->tunAddr, NULL));
-		return tun;
+		printf("%s: Opening %s connection: %s (%s).\n",
+			qna->Unit.devName, eth->Type->name, eth->ifName,
+			eth_FormatAddress((ETH_MAC *)qna->tunAddr, NULL));
+		return eth;
 	}
 
-	printf("%s: Can't open TUN connection (%s) - Aborted.\n",
-		qna->Unit.devName, tunName);
+	printf("%s: Can't open Ethernet connection (%s) - Aborted.\n",
+		qna->Unit.devName, name);
 	return NULL;
 }
 
-void xq_InputWorld(SOCKET *tun, char *pkt, int len)
+void xq_InputWorld(void *dev, uint8 *pkt, int len)
 {
-	QNA_DEVICE *qna = (QNA_DEVICE *)tun->Device;
-	ETH_PACKET epkt;
+	QNA_DEVICE *qna = (QNA_DEVICE *)dev;
 	uint16     status[2];
+	int        rlen;
 
 #ifdef DEBUG
 	if (dbg_Check(DBG_IODATA))
@@ -222,21 +220,14 @@ void xq_InputWorld(SOCKET *tun, char *pkt, int len)
 		return;
 	}
 
-	// Convert raw packet to ETH_PACKET entry.
-	// Remove that later when Ethernet support
-	// routines is implemented in ts10 core.
-	memcpy(epkt.msg, pkt, len);
-	epkt.len = len;
-
 	// Report that status for this packet.
-	if (len < ETH_MIN)
-		len = ETH_MIN;
-	status[0]  = (len - ETH_MIN) & RSW_RBLH;
-	status[1]  = (len - ETH_MIN) & RSW_RBLL;
+	rlen = (len < ETH_MIN) ? ETH_MIN : len;
+	status[0]  = (rlen - ETH_MIN) & RSW_RBLH;
+	status[1]  = (rlen - ETH_MIN) & RSW_RBLL;
 	status[1] |= (status[1] << 8);
 
-	// Enqueue a packet with status into the circular queue.
-	xq_Enqueue(qna, PKT_NORMAL, &epkt, status);
+	// Put that frame with status directly into the receive ring.
+	xq_Enqueue(qna, PKT_NORMAL, pkt, len, status);
 
 #ifdef DEBUG
 	if (dbg_Check(DBG_IODATA))
@@ -244,23 +235,18 @@ void xq_InputWorld(SOCKET *tun, char *pkt, int len)
 			qna->Unit.devName, status[0], status[1]);
 #endif /* DEBUG */
 
-	// Tell host systems that incoming packets are here.
-	xq_FlushQueue(qna);
+	// Frames received by the same poll or read are
+	// flushed into host memory together later.
+	if ((qna->rxTimer.Flags & CLK_PENDING) == 0)
+		ts10_SetTimer(&qna->rxTimer);
 }
 
 void xq_ProcessLoopback(QNA_DEVICE *qna, int type, uint8 *frame, int len)
 {
-	ETH_PACKET pkt;
 	uint16     status[2];
 
-	if (type == EPP_ELOOP)
-		SockSendPacket(qna->World, frame, len);
-
-	// Convert raw packet to ETH_PACKET entry.
-	// Remove that later when Ethernet support
-	// routines is implemented in ts10 core.
-	memcpy(pkt.msg, frame, len);
-	pkt.len = len;
+	if ((type == EPP_ELOOP) && qna->World)
+		SendEther(qna->World, frame, len);
 
 	// Check its frame length and set up
 	// results of RSTATUS words.
@@ -277,7 +263,7 @@ void xq_ProcessLoopback(QNA_DEVICE *qna, int type, uint8 *frame, int len)
 	}
 
 	// Enqueue a packet with status into the circular queue.
-	xq_Enqueue(qna, PKT_LOOPBACK, &pkt, status);
+	xq_Enqueue(qna, PKT_LOOPBACK, frame, len, status);
 
 	// Tell host systems that loopback packets are here.
 //	xq_FlushQueue(qna);
@@ -285,6 +271,26 @@ void xq_ProcessLoopback(QNA_DEVICE *qna, int type, uint8 *frame, int len)
 
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 
+// Give addresses from setup packet to host-side filter, so that
+// frames not addressed to us are dropped before being queued.
+void xq_SetFilter(QNA_DEVICE *qna)
+{
+	ETH_MAC addrs[14];
+	uint32  flags = 0;
+	int     idx;
+
+	if (qna->World == NULL)
+		return;
+
+	for (idx = 0; idx < qna->nAddrs; idx++)
+		memcpy(addrs[idx], qna->ethAddr[idx], sizeof(ETH_MAC));
+	if (qna->Flags & CFLG_PROMISC)
+		flags |= ETH_PROMISC;
+	if (qna->Flags & CFLG_ALLMULTI)
+		flags |= ETH_ALLMULTI;
+	SetEtherFilter(qna->World, flags, addrs, qna->nAddrs);
+}
+
 void xq_ParseSetup(QNA_DEVICE *qna, uint8 *frame, int len)
 {
 	int   a, b, c;
@@ -311,6 +317,7 @@ void xq_ParseSetup(QNA_DEVICE *qna, uint8 *frame, int len)
 		}
 	}
 	qna->nAddrs = nAddrs;
+	xq_SetFilter(qna);
 
 #ifdef DEBUG
 //	if (dbg_Check(DBG_IODATA)) {
@@ -336,7 +343,6 @@ void xq_ParseSetup(QNA_DEVICE *qna, uint8 *frame, int len)
 
 void xq_ProcessSetup(QNA_DEVICE *qna, uint8 *frame, int len)
 {
-	ETH_PACKET pkt;
 	uint16 status[2];
 
 	if (len <= 0400) {
@@ -351,33 +357,71 @@ void xq_ProcessSetup(QNA_DEVICE *qna, uint8 *frame, int len)
 	}
 	status[1] = (len & RSW_RBLL) | ((len & RSW_RBLL) << 8);
 
-	// Convert raw packet to ETH_PACKET entry.
-	// Remove that later when Ethernet support
-	// routines is implemented in ts10 core.
-	memcpy(pkt.msg, frame, len);
-	pkt.len = len;
-
 	// Enqueue a packet with status into the circular queue.
 	// (Send a SETUP packet back to host system).
-	xq_Enqueue(qna, PKT_SETUP, &pkt, status);
+	xq_Enqueue(qna, PKT_SETUP, frame, len, status);
 
 	// Tell host system that setup packet is here.
 //	xq_FlushQueue(qna);
 }
 
+// Send all frames in transmit batch.
+void xq_FlushTransmit(QNA_DEVICE *qna)
+{
+	int rc;
+
+	if (qna->txCount == 0)
+		return;
+
+	// Detached - drop them.
+	if (qna->World == NULL) {
+		qna->txCount = 0;
+		return;
+	}
+
+	if ((rc = SendEtherBatch(qna->World, qna->txFrames, qna->txCount)) < qna->txCount) {
+#ifdef DEBUG
+		if (dbg_Check(DBG_IODATA))
+			dbg_Printf("%s: Send Batch Error: %d of %d frames sent: %s\n",
+				qna->Unit.devName, (rc < 0 ? 0 : rc), qna->txCount,
+				strerror(errno));
+#endif /* DEBUG */
+	}
+	qna->txCount = 0;
+}
+
 void xq_WriteFrame(QNA_DEVICE *qna, int type, uint8 *frame, int len)
 {
 	uint16 status[2]; // Transmit Status Words
 	int    rc;
 
-	// Send XSTATUS to host system.
-	status[0] = 0;
+	// Send XSTATUS to host system.  Frames for the wire
+	// are lost without connection.
+	if ((qna->World == NULL) && ((type == EPP_TRANSMIT) || (type == EPP_ELOOP)))
+		status[0] = TSW_ERROR|TSW_LOSS|TSW_NOCAR;
+	else
+		status[0] = 0;
 	status[1] = 0140 + (len * 010);
 	xq_PutStatus(qna, EPP_XSTATUS, (uint8 *)status);
 
+	// Keep order of frames with transmit batch.
+	if ((type != EPP_TRANSMIT) && qna->txCount)
+		xq_FlushTransmit(qna);
+
 	switch (type) {
 		case EPP_TRANSMIT:
-			if ((rc = SockSendPacket(qna->World, frame, len)) < 0) {
+			if (qna->World == NULL)
+				break;
+
+			// In coalescing mode, put frame into transmit batch.
+			if (qna->txBuffer) {
+				memcpy(qna->txFrames[qna->txCount].iov_base, frame, len);
+				qna->txFrames[qna->txCount].iov_len = len;
+				if (++qna->txCount == QNA_TXBATCH)
+					xq_FlushTransmit(qna);
+				break;
+			}
+			if ((rc = SendEther(qna->World, frame, len)) < 0) {
 #ifdef DEBUG
 				if (dbg_Check(DBG_IODATA))
 					dbg_Printf("%s: Send Packet Error: %s\n",
@@ -408,31 +452,31 @@ void xq_WriteFrame(QNA_DEVICE *qna, int type, uint8 *frame, int len)
 // ***************************************************************
 
 // Enter a packet entry into the circular queue.
-void xq_Enqueue(QNA_DEVICE *qna, int type, ETH_PACKET *pkt, uint16 *Status)
+void xq_Enqueue(QNA_DEVICE *qna, int type, uint8 *frame, int len, uint16 *Status)
 {
-	QNA_PACKET *qpkt = &qna->pktList[qna->pktHead++];
-
-	// If queue is empty, start with new head/tail pointers.
-	if (qna->pktCount == 0) {
-		qna->pktHead = 0;
-		qna->pktTail = -1;
-	}
+	QNA_PACKET *qpkt;
 
-	// Get new tail queue to enqueue.
-	if (++qna->pktTail == QNA_NPKTS)
-		qna->pktTail = 0;
-	if (++qna->pktCount >= QNA_NPKTS) {
-		qna->pktCount = QNA_NPKTS;
-		// Oldest packet is lost.
-		if (++qna->pktHead == QNA_NPKTS)
+	// If queue is full, oldest packet is lost.
+	if (qna->pktCount == qna->nPkts) {
+		if (++qna->pktHead == qna->nPkts)
 			qna->pktHead = 0;
+		qna->pktCount--;
 		qna->pktLoss++;
 	}
 
-	// Insert Ethernet Packet into Queue.
+	// Get new tail slot to enqueue.
 	qpkt = &qna->pktList[qna->pktTail];
-	memcpy(qpkt->Data.msg, pkt->msg, pkt->len);
-	qpkt->Data.len  = pkt->len;
+	if (++qna->pktTail == qna->nPkts)
+		qna->pktTail = 0;
+	qna->pktCount++;
+
+	// Copy frame into its own buffer of that slot.  That is the only
+	// copy on receive: packet and switch backends hand over frames in
+	// place from their shared rings, which must be given back at once.
+	if (len > ETH_MAX)
+		len = ETH_MAX;
+	memcpy(qpkt->Data, frame, len);
+	qpkt->Len       = len;
 	qpkt->Type      = type;
 	qpkt->Status[0] = Status[0];
 	qpkt->Status[1] = Status[1];
@@ -449,30 +493,37 @@ void xq_Dequeue(QNA_DEVICE *qna)
 		pkt->Type = PKT_INVALID;
 
 		// Finally, remove the packet.
-		if (++qna->pktHead == QNA_NPKTS)
+		if (++qna->pktHead == qna->nPkts)
 			qna->pktHead = 0;
 		qna->pktCount--;
 	}
 }
 
+// Put all pending frames into host memory through receive
+// BDL list.  Frames are kept in the queue while receive list
+// is invalid and will be flushed when host gives a new list.
 void xq_FlushQueue(QNA_DEVICE *qna)
 {
 	QNA_PACKET *pkt;
 
-	while (qna->pktCount) {
+	while (qna->pktCount && ((qna->csr & CSR_RL) == 0)) {
 		pkt = &qna->pktList[qna->pktHead];
 
 		// Put a frame into host memory.
-		if ((qna->csr & CSR_RL) == 0) {
-			xq_PutFrame(qna, pkt->Data.msg, pkt->Data.len);
-			xq_PutStatus(qna, EPP_RSTATUS, (uint8 *)pkt->Status);
-		}
+		xq_PutFrame(qna, pkt->Data, pkt->Len);
+		xq_PutStatus(qna, EPP_RSTATUS, (uint8 *)pkt->Status);
 
 		// Remove old entry from the circular queue.
 		xq_Dequeue(qna);
 	}
 }
 
+// Receive batch timer - flush frames received since last call.
+void xq_ReceiveFrames(void *dptr)
+{
+	xq_FlushQueue((QNA_DEVICE *)dptr);
+}
+
 inline void xq_DoIRQ(QNA_DEVICE *qna, uint16 bit)
 {
 	MAP_IO *io = &qna->ioMap;
@@ -490,6 +541,43 @@ inline void xq_DoIRQ(QNA_DEVICE *qna, uint16 bit)
 	}
 }
 
+// Ring host's doorbell for all coalesced interrupts.
+void xq_FlushIRQ(QNA_DEVICE *qna)
+{
+	uint16 bits = qna->irqPending;
+
+	qna->irqPending = 0;
+	qna->irqCount   = 0;
+	if (qna->irqTimer.Flags & CLK_PENDING)
+		ts10_CancelTimer(&qna->irqTimer);
+
+	if (bits & CSR_XI)
+		xq_DoIRQ(qna, CSR_XI);
+	if (bits & CSR_RI)
+		xq_DoIRQ(qna, CSR_RI);
+}
+
+void xq_ExpireIRQ(void *dptr)
+{
+	xq_FlushIRQ((QNA_DEVICE *)dptr);
+}
+
+// Post an interrupt for a completed frame.  In coalescing mode,
+// one interrupt is raised after a number of frames or a delay.
+void xq_PostIRQ(QNA_DEVICE *qna, uint16 bit)
+{
+	if (qna->irqFrames == 0) {
+		xq_DoIRQ(qna, bit);
+		return;
+	}
+
+	qna->irqPending |= bit;
+	if (++qna->irqCount >= qna->irqFrames)
+		xq_FlushIRQ(qna);
+	else if ((qna->irqTimer.Flags & CLK_PENDING) == 0)
+		ts10_SetTimer(&qna->irqTimer);
+}
+
 #ifdef DEBUG
 
 inline void xq_DumpDesc(QNA_DEVICE *qna, uint32 addr, QNA_BDL *desc,
@@ -522,7 +610,8 @@ int xq_GetData(QNA_DEVICE *qna, uint32 addr, void *data, uint32 size)
 
 	if (call->ReadBlock(uq, addr, data, size, 0)) {
 		qna->csr |= (CSR_XL|CSR_RL|CSR_NI);
-		xq_DoIRQ(qna, CSR_XI);
+		qna->irqPending |= CSR_XI;
+		xq_FlushIRQ(qna);
 		return QNA_NXM;
 	}
 
@@ -537,7 +626,8 @@ int xq_PutData(QNA_DEVICE *qna, uint32 addr, void *data, uint32 size)
 
 	if (call->WriteBlock(uq, addr, data, size, 0)) {
 		qna->csr |= (CSR_XL|CSR_RL|CSR_NI);
-		xq_DoIRQ(qna, CSR_XI);
+		qna->irqPending |= CSR_XI;
+		xq_FlushIRQ(qna);
 		return QNA_NXM;
 	}
 
@@ -694,7 +784,7 @@ int xq_PutStatus(QNA_DEVICE *qna, int type, uint8 *sts)
 				qna->txBDLAddr += BDL_SIZE;
 
 				// Ring host's doorbell.
-				xq_DoIRQ(qna, CSR_XI);
+				xq_PostIRQ(qna, CSR_XI);
 			}
 			return QNA_OK;
 
@@ -705,7 +795,7 @@ int xq_PutStatus(QNA_DEVICE *qna, int type, uint8 *sts)
 				qna->rxBDLAddr += BDL_SIZE;
 
 				// Ring host's doorbell.
-				xq_DoIRQ(qna, CSR_RI);
+				xq_PostIRQ(qna, CSR_RI);
 			}
 			return QNA_OK;
 
@@ -804,16 +894,92 @@ int xq_SendFrame(QNA_DEVICE *qna)
 void xq_ProcessFrames(void *dptr)
 {
 	QNA_DEVICE *qna = (QNA_DEVICE *)dptr;
+	int        idx;
 
 	if (qna->pktCount && ((qna->csr & CSR_RL) == 0))
 		xq_FlushQueue(qna);
 	if (qna->csr & CSR_XL)
 		return;
+
+	// In coalescing mode, walk transmit BDL list through
+	// in one call and send all frames together.
+	if (qna->irqFrames) {
+		for (idx = 0; idx < QNA_TXBATCH; idx++) {
+			if (xq_SendFrame(qna)) {
+				xq_FlushTransmit(qna);
+				return;
+			}
+			if (qna->csr & CSR_XL)
+				break;
+		}
+		xq_FlushTransmit(qna);
+		if ((qna->csr & CSR_XL) == 0)
+			ts10_SetTimer(&qna->txTimer);
+		return;
+	}
+
 	if (xq_SendFrame(qna))
 		return;
 	ts10_SetTimer(&qna->txTimer);
 }
 
+// Usage: set <device> coalesce <off|<frames> [delay]>
+int xq_SetCoalesce(void *dptr, int argc, char **argv)
+{
+	QNA_DEVICE *qna = (QNA_DEVICE *)dptr;
+	int        nFrames = QNA_IRQFRAMES;
+	int        nDelay  = QNA_IRQDELAY;
+	int        idx;
+
+	if (argc < 4) {
+		printf("Usage: %s %s %s <off|on|<frames> [delay]>\n",
+			argv[0], argv[1], argv[2]);
+		printf("%s: Coalescing: %d frames, %d instructions\n",
+			qna->Unit.devName, qna->irqFrames, qna->irqDelay);
+		return EMU_OK;
+	}
+
+	if (!strcasecmp(argv[3], "off"))
+		nFrames = 0;
+	else if (strcasecmp(argv[3], "on")) {
+		if ((sscanf(argv[3], "%d", &nFrames) != 1) ||
+		    ((argc > 4) && (sscanf(argv[4], "%d", &nDelay) != 1)) ||
+		    (nFrames < 1) || (nDelay < 1)) {
+			printf("%s: Invalid coalescing settings.\n",
+				qna->Unit.devName);
+			return EMU_ARG;
+		}
+	}
+
+	// Send all pending frames and interrupts first.
+	xq_FlushTransmit(qna);
+	xq_FlushIRQ(qna);
+
+	if (nFrames && (qna->txBuffer == NULL)) {
+		if ((qna->txBuffer = (uint8 *)malloc(QNA_TXBATCH * ETH_MAX)) == NULL)
+			return EMU_MEMERR;
+		for (idx = 0; idx < QNA_TXBATCH; idx++)
+			qna->txFrames[idx].iov_base = &qna->txBuffer[idx * ETH_MAX];
+	} else if ((nFrames == 0) && qna->txBuffer) {
+		free(qna->txBuffer);
+		qna->txBuffer = NULL;
+	}
+
+	qna->irqFrames         = nFrames;
+	qna->irqDelay          = nFrames ? nDelay : 0;
+	qna->irqTimer.outTimer = nDelay;
+	qna->irqTimer.nxtTimer = nDelay;
+
+	printf("%s: Coalescing: %s\n", qna->Unit.devName,
+		nFrames ? "on" : "off");
+	return EMU_OK;
+}
+
+COMMAND xq_SetCommands[] = {
+	{ "coalesce", "<off|on|<frames> [delay]>", xq_SetCoalesce },
+	{ NULL, NULL, NULL }
+};
+
 // ***************************************************************
 
 inline void xq_ResetEther(QNA_DEVICE *qna)
@@ -832,10 +998,15 @@ inline void xq_ResetEther(QNA_DEVICE *qna)
 	memset(&qna->ethAddr, 0, 14*8);
 
 	// Initialize circular packet queue management
-	memset(&qna->pktList[0], 0, sizeof(QNA_PACKET) * QNA_NPKTS);
-	for (idx = 0; idx < QNA_NPKTS; idx++)
-		qna->pktList[0].idPacket = idx;
+	for (idx = 0; idx < qna->nPkts; idx++)
+		qna->pktList[idx].Type = PKT_INVALID;
 	qna->pktHead = qna->pktTail = qna->pktCount = qna->pktLoss = 0;
+
+	// Discard pending interrupts and transmit batch.
+	if (qna->irqTimer.Flags & CLK_PENDING)
+		ts10_CancelTimer(&qna->irqTimer);
+	qna->irqPending = qna->irqCount = 0;
+	qna->txCount = 0;
 }
 
 inline void xq_UpdateCSR(QNA_DEVICE *qna, uint16 ncsr)
@@ -981,12 +1152,24 @@ int xq_WriteIO(void *dptr, uint32 pAddr, uint16 data, uint32 acc)
 // ****************************************************************
 
 // Create/Initialize QNA device.
-// Usage: create <device> <qna|lqa|sqa> ...
+// Usage: create <device> <qna|lqa|sqa> [<receive ring size>]
 void *xq_Create(MAP_DEVICE *newMap, int argc, char **argv)
 {
 	QNA_DEVICE *qna = NULL;
 	CLK_QUEUE  *newTimer;
 	MAP_IO     *io;
+	int        nPkts = QNA_NPKTS;
+	int        idx;
+
+	// Get size of receive ring.
+	if (argc > 3) {
+		if ((sscanf(argv[3], "%d", &nPkts) != 1) ||
+		    (nPkts < QNA_MINPKTS) || (nPkts > QNA_MAXPKTS)) {
+			printf("%s: Receive ring must be %d to %d frames.\n",
+				newMap->devName, QNA_MINPKTS, QNA_MAXPKTS);
+			return NULL;
+		}
+	}
 
 	if (qna = (QNA_DEVICE *)calloc(1, sizeof(QNA_DEVICE))) {
 		// First, set up its description,
@@ -1009,12 +1192,21 @@ void *xq_Create(MAP_DEVICE *newMap, int argc, char **argv)
 			return NULL;
 		}
 
-#if 0
-		// Initialize Communication/Doorbell Area
-		dp_Create(&qna->dp, sizeof(DPC), 0, SIGUSR1, 1600, 0, SIGUSR1, 1600);
-		if (qna->dp.dpc)
-			dp_Start(&qna->dp.dpc);
-#endif
+		// Set up receive ring with its frame buffers.
+		qna->nPkts     = nPkts;
+		qna->pktList   = (QNA_PACKET *)calloc(nPkts, sizeof(QNA_PACKET));
+		qna->pktBuffer = (uint8 *)malloc(nPkts * ETH_MAX);
+		if ((qna->pktList == NULL) || (qna->pktBuffer == NULL)) {
+			printf("%s: Not enough memory for receive ring.\n",
+				qna->Unit.devName);
+			free(qna->pktList);
+			free(qna->pktBuffer);
+			free(qna);
+			return NULL;
+		}
+		for (idx = 0; idx < nPkts; idx++)
+			qna->pktList[idx].Data = &qna->pktBuffer[idx * ETH_MAX];
+
 		// Controller Flags
 		qna->csrAddr    = QNA_IOADDR;
 
@@ -1048,6 +1240,20 @@ void *xq_Create(MAP_DEVICE *newMap, int argc, char **argv)
 		newTimer->Device   = qna;
 		newTimer->Execute  = xq_ProcessFrames;
 
+		newTimer           = &qna->rxTimer;
+		newTimer->Next     = NULL;
+		newTimer->outTimer = QNA_RXDELAY;
+		newTimer->nxtTimer = QNA_RXDELAY;
+		newTimer->Device   = qna;
+		newTimer->Execute  = xq_ReceiveFrames;
+
+		newTimer           = &qna->irqTimer;
+		newTimer->Next     = NULL;
+		newTimer->outTimer = QNA_IRQDELAY;
+		newTimer->nxtTimer = QNA_IRQDELAY;
+		newTimer->Device   = qna;
+		newTimer->Execute  = xq_ExpireIRQ;
+
 		// Power-up Initialization
 		xq_ResetEther(qna);
 
@@ -1069,20 +1275,31 @@ int xq_Attach(MAP_DEVICE *map, int argc, char **argv)
 		return EMU_OK;
 	}
 
-	if (xq_OpenTUN(qna, argv[2]) == NULL) {
+	if (xq_OpenEther(qna, argv[2]) == NULL) {
 		printf("%s: Can't attach ethernet interface.\n",
 			qna->Unit.devName);
 		return EMU_OK;
 	}
 
-	// Set up own ethernet address.
-	qna->ownAddr[0] = 0x00;
-	qna->ownAddr[1] = 0xFF;
-	qna->ownAddr[2] = 0x10;
-	qna->ownAddr[3] = 0x20;
-	qna->ownAddr[4] = 0x30;
-	qna->ownAddr[5] = 0x40;
+	// Set up own ethernet address.  Virtual switch gives
+	// a station address for each port.
+	if (qna->World->Flags & ETH_STATION) {
+		memcpy(qna->ownAddr, qna->World->hostAddr, sizeof(ETH_MAC));
+	} else {
+		qna->ownAddr[0] = 0x00;
+		qna->ownAddr[1] = 0xFF;
+		qna->ownAddr[2] = 0x10;
+		qna->ownAddr[3] = 0x20;
+		qna->ownAddr[4] = 0x30;
+		qna->ownAddr[5] = 0x40;
+	}
 	xq_MakeChecksum(qna, qna->ownAddr);
+	qna->csr |= CSR_OK;
+
+	// Resume transmit list stopped by detach.
+	if (((qna->csr & CSR_XL) == 0) &&
+	    ((qna->txTimer.Flags & CLK_PENDING) == 0))
+		ts10_SetTimer(&qna->txTimer);
 
 	return EMU_OK;
 }
@@ -1091,6 +1308,23 @@ int xq_Detach(MAP_DEVICE *map, int argc, char **argv)
 {
 	QNA_DEVICE *qna = (QNA_DEVICE *)map->Device;
 
+	if (qna->World) {
+		// Finish pending frames and interrupts, and stop
+		// timers before connection goes away.
+		xq_FlushTransmit(qna);
+		if (qna->txTimer.Flags & CLK_PENDING)
+			ts10_CancelTimer(&qna->txTimer);
+		if (qna->rxTimer.Flags & CLK_PENDING)
+			ts10_CancelTimer(&qna->rxTimer);
+		if (qna->pktCount && ((qna->csr & CSR_RL) == 0))
+			xq_FlushQueue(qna);
+		xq_FlushIRQ(qna);
+
+		CloseEther(qna->World);
+		qna->World = NULL;
+		qna->csr &= ~CSR_OK;
+	}
+
 	return EMU_OK;
 }
 
@@ -1101,7 +1335,12 @@ int xq_Info(MAP_DEVICE *map, int argc, char **argv)
 
 	printf("\nDevice:           %s  Type: %s\n",
 		qna->Unit.devName, qna->Unit.keyName);
-	printf("TUN/TAP Address:  %02X:%02X:%02X:%02X:%02X:%02X\n",
+	if (qna->World)
+		printf("Connection:       %s %s  Sent: %u  Received: %u  Dropped: %u  Filtered: %u\n",
+			qna->World->Type->name, qna->World->ifName,
+			qna->World->nSent, qna->World->nRecv, qna->World->nDrops,
+			qna->World->nFiltered);
+	printf("Host Address:     %02X:%02X:%02X:%02X:%02X:%02X\n",
 		qna->tunAddr[0], qna->tunAddr[1], qna->tunAddr[2],
 		qna->tunAddr[3], qna->tunAddr[4], qna->tunAddr[5]);
 	printf("PROM Address:     %02X:%02X:%02X:%02X:%02X:%02X  %02X:%02X\n",
@@ -1109,6 +1348,11 @@ int xq_Info(MAP_DEVICE *map, int argc, char **argv)
 		qna->ownAddr[3], qna->ownAddr[4], qna->ownAddr[5],
 		qna->ownAddr[6], qna->ownAddr[7]);
 
+	printf("Receive Ring:     %d frames  Queued: %d  Lost: %d\n",
+		qna->nPkts, qna->pktCount, qna->pktLoss);
+	if (qna->irqFrames)
+		printf("Coalescing:       %d frames or %d instructions per interrupt\n",
+			qna->irqFrames, qna->irqDelay);
 	printf("Ethernet Address: (%d Entries)\n", qna->nAddrs);
 	for (idx = 0; idx < qna->nAddrs; idx++) {
 		uint8 *ethAddr = qna->ethAddr[idx];
@@ -1132,7 +1376,7 @@ DEVICE qna_Device =
 	DT_NETWORK,   // Device Type
 
 	NULL,         // Commands
-	NULL,         // Set Commands
+	xq_SetCommands, // Set Commands
 	NULL,         // Show Commands
 
 	xq_Create,    // Create Routine
@@ -1161,7 +1405,7 @@ DEVICE lqa_Device =
 	DT_NETWORK,   // Device Type
 
 	NULL,         // Commands
-	NULL,         // Set Commands
+	xq_SetCommands, // Set Commands
 	NULL,         // Show Commands
 
 	xq_Create,    // Create Routine
@@ -1190,7 +1434,7 @@ DEVICE lqat_Device =
 	DT_NETWORK,   // Device Type
 
 	NULL,         // Commands
-	NULL,         // Set Commands
+	xq_SetCommands, // Set Commands
 	NULL,         // Show Commands
 
 	xq_Create,    // Create Routine
@@ -194,6 +194,7 @@ COMMAND ts10_Commands[] =
 	{ "break",     "[switch] <address> [action]", CmdBreak },
 #endif /* DEBUG */
 	{ "boot",      "<device> ...", CmdBoot    },
+	{ "compress",  "<file> <image>", CmdCompress },
 	{ "configure", "<device> ...", CmdConfigure },
 	{ "continue",  "",             CmdRun     },
 	{ "create",    "<device> <type> ...", CmdCreate },
@@ -217,6 +218,7 @@ COMMAND ts10_Commands[] =
 #ifdef DEBUG
 	{ "nobreak",   "[switch] <address>", CmdNoBreak },
 #endif /* DEBUG */
+	{ "overlay",   "<file> <base image>", CmdOverlay },
 	{ "quit",      "",             CmdQuit    },
 	{ "run",       "",             CmdRun     },
 	{ "select",    "[system|none]",    CmdSelect },
@@ -234,11 +236,13 @@ COMMAND ts10_Commands[] =
 
 COMMAND ts10_SetCommands[] =
 {
+	{ "cache",   "<size>[k|m|g] [through|back]", CmdSetCache },
 	{ NULL }
 };
 
 COMMAND ts10_ShowCommands[] =
 {
+	{ "cache",   "", CmdShowCache },
 	{ "device",  "", CmdShowDevice },
 	{ NULL }
 };
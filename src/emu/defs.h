@@ -66,6 +66,7 @@ typedef union {
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <ctype.h>
 #include <fcntl.h>
 #include <setjmp.h>
@@ -152,6 +153,11 @@ struct ClockQueue {
 	int32     nxtTimer;           // Next Timer if available
 	void      *Device;            // User-defined device unit
 	void      (*Execute)(void *); // Execute (Action) Routine
+
+	// Simulation clock queue (heap) - used by timer.c only
+	int32     qIndex;             // Position within clock heap
+	uint32    qOrder;             // Order of arrival for equal times
+	uint64    qDue;               // Due time (in interval counts)
 };
 
 // Command table
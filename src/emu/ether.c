@@ -34,16 +34,555 @@
   -------------------------------------------------------------------------
 */
 
+#ifdef __linux__
+#define _GNU_SOURCE // For sendmmsg
+#endif /* __linux__ */
+
 #include "emu/defs.h"
+#include "emu/socket.h"
 #include "emu/ether.h"
+#include <signal.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#endif /* __linux__ */
+
+// Ethernet Backends
+//
+// Ethernet devices talk to the world through OpenEther with a name
+// as "<type>:<argument>" (or just 'tap' or 'tun').  Each backend
+// delivers incoming frames to Receive routine of that device.
+//
+//   tap, tun      - TAP/TUN connection (needs root), read by socket
+//                   I/O thread.
+//   packet:<if>   - Raw packet socket on host interface with
+//                   PACKET_MMAP receive ring (needs CAP_NET_RAW).
+//   vsw:<name>    - Virtual switch in shared memory, which connects
+//                   emulators on same host without root access.
+//                   Packet and vsw are only built on Linux hosts.
+//   proc:<tap|tun> - TAP/TUN connection owned by a device process
+//                   (dev/dp), so that host I/O never blocks emulator.
+//
+// Packet ring and switch ports are polled by a timer every
+// ETH_POLLTIME instructions, so that no system calls are needed
+// for receiving frames.
+//
+// Devices may set a destination address filter (SetEtherFilter)
+// like their hardware does, so that frames not addressed to them
+// are dropped before they are copied.  Packet socket also gets
+// a BPF program, so that kernel drops them first.
+
+static CLK_QUEUE  eth_PollTimer;
+static ETH_DEVICE *eth_PollList = NULL;
+
+// Hash bit for Ethernet address (filter)
+static __inline__ uint64 eth_HashAddr(uint8 *addr)
+{
+	return 1ULL << ((addr[0] ^ addr[1] ^ addr[2] ^
+		addr[3] ^ addr[4] ^ addr[5]) & 63);
+}
+
+// Check destination address of incoming frame with filter.
+static __inline__ int eth_Accept(ETH_DEVICE *eth, uint8 *frame)
+{
+	int idx;
+
+	if ((eth->Flags & (ETH_FILTER|ETH_PROMISC)) != ETH_FILTER)
+		return TRUE;
+	if ((frame[0] & 1) && (eth->Flags & ETH_ALLMULTI))
+		return TRUE;
+	if (eth->fltHash & eth_HashAddr(frame))
+		for (idx = 0; idx < eth->nFilter; idx++)
+			if (!memcmp(frame, eth->fltAddr[idx], sizeof(ETH_MAC)))
+				return TRUE;
+	eth->nFiltered++;
+	return FALSE;
+}
+
+// ********************************************************************
+
+// TAP/TUN Connection
+
+static void eth_TapInput(SOCKET *tun, char *pkt, int len)
+{
+	ETH_DEVICE *eth = (ETH_DEVICE *)tun->Device;
+
+	if ((len < sizeof(ETH_MAC)) || !eth_Accept(eth, (uint8 *)pkt))
+		return;
+	eth->nRecv++;
+	eth->Receive(eth->Device, (uint8 *)pkt, len);
+}
+
+static int eth_TapOpen(ETH_DEVICE *eth, char *arg)
+{
+	SOCKET *tun;
+
+	// Kernel gives a new name of TAP/TUN interface.
+	strcpy(eth->ifName, eth->Type->name);
+	if ((tun = sock_Open(eth->ifName, 0, NET_TUN)) == NULL)
+		return -1;
+	tun->Accept  = NULL;
+	tun->Eof     = NULL;
+	tun->Process = eth_TapInput;
+	tun->Device  = eth;
+	eth->Socket  = tun;
+
+	// Get Ethernet Address from TUN/TAP connection.
+	SockGetEtherAddr(tun->Name, eth->hostAddr);
+
+	return 0;
+}
+
+static void eth_TapClose(ETH_DEVICE *eth)
+{
+	if (eth->Socket)
+		sock_Close(eth->Socket);
+	eth->Socket = NULL;
+}
+
+static int eth_TapSend(ETH_DEVICE *eth, uint8 *frame, int len)
+{
+	return SockSendPacket(eth->Socket, frame, len);
+}
+
+// ********************************************************************
+
+#ifdef __linux__
+
+// Raw Packet Socket (AF_PACKET with PACKET_MMAP receive ring)
+
+static int eth_PacketOpen(ETH_DEVICE *eth, char *ifName)
+{
+	struct tpacket_req req;
+	struct sockaddr_ll sll;
+	struct packet_mreq mr;
+	int    ver = TPACKET_V2;
+	int    fd, idx;
+
+	if ((ifName == NULL) || (*ifName == '\0') ||
+	    (strlen(ifName) >= sizeof(eth->ifName))) {
+		printf("ETH: Invalid interface name.\n");
+		return -1;
+	}
+	strcpy(eth->ifName, ifName);
+	if ((idx = if_nametoindex(ifName)) == 0) {
+		perror("ETH: Error (Interface)");
+		return -1;
+	}
+
+	if ((fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL))) < 0) {
+		perror("ETH: Error (Packet Socket)");
+		return -1;
+	}
+
+	// Set up receive ring and map it into memory.
+	req.tp_block_size = ETH_BLOCKSZ;
+	req.tp_block_nr   = ETH_NBLOCKS;
+	req.tp_frame_size = ETH_FRAMESZ;
+	req.tp_frame_nr   = (ETH_BLOCKSZ / ETH_FRAMESZ) * ETH_NBLOCKS;
+	if ((setsockopt(fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof(ver)) < 0) ||
+	    (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)) {
+		perror("ETH: Error (Packet Ring)");
+		close(fd);
+		return -1;
+	}
+	eth->szRing  = ETH_BLOCKSZ * ETH_NBLOCKS;
+	eth->nFrames = req.tp_frame_nr;
+	eth->Ring    = (uint8 *)mmap(NULL, eth->szRing, PROT_READ|PROT_WRITE,
+		MAP_SHARED, fd, 0);
+	if (eth->Ring == MAP_FAILED) {
+		perror("ETH: Error (mmap)");
+		eth->Ring = NULL;
+		close(fd);
+		return -1;
+	}
+
+	// Bind it to that interface in promiscuous mode.
+	memset(&sll, 0, sizeof(sll));
+	sll.sll_family   = AF_PACKET;
+	sll.sll_protocol = htons(ETH_P_ALL);
+	sll.sll_ifindex  = idx;
+	memset(&mr, 0, sizeof(mr));
+	mr.mr_ifindex = idx;
+	mr.mr_type    = PACKET_MR_PROMISC;
+	if ((bind(fd, (SOCKADDR *)&sll, sizeof(sll)) < 0) ||
+	    (setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mr, sizeof(mr)) < 0)) {
+		perror("ETH: Error (bind)");
+		munmap(eth->Ring, eth->szRing);
+		eth->Ring = NULL;
+		close(fd);
+		return -1;
+	}
+
+	eth->idSocket = fd;
+	eth->idxFrame = 0;
+	SockGetEtherAddr(ifName, eth->hostAddr);
+
+	return 0;
+}
+
+static void eth_PacketClose(ETH_DEVICE *eth)
+{
+	if (eth->Ring)
+		munmap(eth->Ring, eth->szRing);
+	eth->Ring = NULL;
+	close(eth->idSocket);
+	eth->idSocket = -1;
+}
+
+static int eth_PacketSend(ETH_DEVICE *eth, uint8 *frame, int len)
+{
+	return send(eth->idSocket, frame, len, 0);
+}
+
+// Send a number of frames by one system call.
+static int eth_PacketSendBatch(ETH_DEVICE *eth, struct iovec *frames, int nFrames)
+{
+	struct mmsghdr msgs[ETH_NBATCH];
+	int    idx, n, rc, nSent = 0;
+
+	while (nSent < nFrames) {
+		n = nFrames - nSent;
+		if (n > ETH_NBATCH)
+			n = ETH_NBATCH;
+		memset(msgs, 0, n * sizeof(struct mmsghdr));
+		for (idx = 0; idx < n; idx++) {
+			msgs[idx].msg_hdr.msg_iov    = &frames[nSent + idx];
+			msgs[idx].msg_hdr.msg_iovlen = 1;
+		}
+		if ((rc = sendmmsg(eth->idSocket, msgs, n, 0)) <= 0)
+			return nSent ? nSent : rc;
+		nSent += rc;
+	}
+
+	return nSent;
+}
+
+// Load a BPF program into packet socket for destination filter.
+static int eth_PacketFilter(ETH_DEVICE *eth)
+{
+	struct sock_filter prog[4 + (ETH_NFILTER * 4)];
+	struct sock_fprog  fprog;
+	uint8              *addr;
+	int                nInsts = 0, nLeft, idx;
+
+	// Accept all frames in promiscuous mode.
+	if ((eth->Flags & (ETH_FILTER|ETH_PROMISC)) != ETH_FILTER) {
+		prog[nInsts++] = (struct sock_filter)BPF_STMT(BPF_RET|BPF_K, 0xFFFFFFFF);
+	} else {
+		// Number of instructions left to accept statement.
+		nLeft = (eth->nFilter * 4) + 1;
+
+		// Multicast bit of destination address.
+		if (eth->Flags & ETH_ALLMULTI) {
+			prog[nInsts++] = (struct sock_filter)BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 0);
+			prog[nInsts++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JSET|BPF_K, 1, nLeft, 0);
+		}
+
+		// Each destination address in filter
+		for (idx = 0; idx < eth->nFilter; idx++) {
+			addr   = eth->fltAddr[idx];
+			nLeft -= 4;
+			prog[nInsts++] = (struct sock_filter)BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 2);
+			prog[nInsts++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K,
+				(addr[2] << 24) | (addr[3] << 16) | (addr[4] << 8) | addr[5], 0, 2);
+			prog[nInsts++] = (struct sock_filter)BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 0);
+			prog[nInsts++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K,
+				(addr[0] << 8) | addr[1], nLeft, 0);
+		}
+		prog[nInsts++] = (struct sock_filter)BPF_STMT(BPF_RET|BPF_K, 0);
+		prog[nInsts++] = (struct sock_filter)BPF_STMT(BPF_RET|BPF_K, 0xFFFFFFFF);
+	}
+
+	fprog.len    = nInsts;
+	fprog.filter = prog;
+	if (setsockopt(eth->idSocket, SOL_SOCKET, SO_ATTACH_FILTER,
+	    &fprog, sizeof(fprog)) < 0) {
+		perror("ETH: Error (Packet Filter)");
+		return -1;
+	}
+
+	return 0;
+}
+
+// Take all received frames from ring.
+static void eth_PacketPoll(ETH_DEVICE *eth)
+{
+	struct tpacket2_hdr *hdr;
+	struct sockaddr_ll  *sll;
+	uint8               *frame;
+
+	for (;;) {
+		hdr = (struct tpacket2_hdr *)(eth->Ring + (eth->idxFrame * ETH_FRAMESZ));
+		if ((hdr->tp_status & TP_STATUS_USER) == 0)
+			break;
+		__sync_synchronize();
+
+		// Drop frames sent by this host, and frames which
+		// were truncated or too long for emulated devices.
+		sll = (struct sockaddr_ll *)((uint8 *)hdr +
+			TPACKET_ALIGN(sizeof(struct tpacket2_hdr)));
+		frame = (uint8 *)hdr + hdr->tp_mac;
+		if ((hdr->tp_snaplen < hdr->tp_len) || (hdr->tp_len > ETH_MAX))
+			eth->nDrops++;
+		else if ((sll->sll_pkttype != PACKET_OUTGOING) && eth_Accept(eth, frame)) {
+			eth->nRecv++;
+			eth->Receive(eth->Device, frame, hdr->tp_snaplen);
+		}
+
+		// Give that frame back to kernel.
+		__sync_synchronize();
+		hdr->tp_status = TP_STATUS_KERNEL;
+		if (++eth->idxFrame == eth->nFrames)
+			eth->idxFrame = 0;
+	}
+}
+
+// ********************************************************************
+
+// Virtual Switch
+//
+// Switch is a shared memory object (/ts10-vsw-<name>) with a number
+// of ports.  Each emulated device takes a free port and receives
+// frames from its own ring.  Senders put frames directly into rings
+// of other ports: to all ports for broadcast, multicast or unknown
+// destination, or to that port which has learned destination address.
+// Senders are serialized by a spin lock of that port, which holds
+// process ID of its sender.  A full ring, or a lock that can't be
+// taken in a short while, drops frames like a busy Ethernet.  Locks
+// and ports of dead processes are taken again.
+
+typedef struct {
+	uint32 Len;              // Frame Length
+	uint8  Data[ETH_MAX];    // Frame Data
+} VSW_FRAME;
+
+typedef struct {
+	volatile int32  Owner;   // Process ID (0 = free)
+	volatile int32  Lock;    // Lock for senders (Process ID)
+	volatile uint32 Head;    // Next frame to fill (senders)
+	volatile uint32 Tail;    // Next frame to take (owner)
+	ETH_MAC         Addr;    // Learned Ethernet Address
+	uint8           Pad[2];
+	VSW_FRAME       Frames[VSW_NFRAMES];
+} VSW_PORT;
+
+typedef struct {
+	char     Magic[8];       // Magic ("TS10VSW")
+	uint32   Version;        // Format Version
+	uint32   nPorts;         // Number of Ports
+	VSW_PORT Ports[VSW_NPORTS];
+} VSW_SWITCH;
+
+static int eth_SwitchOpen(ETH_DEVICE *eth, char *name)
+{
+	VSW_SWITCH *vsw;
+	VSW_PORT   *port;
+	char       shmName[64];
+	int32      pid = getpid(), owner;
+	int        fd, idx;
+
+	if ((name == NULL) || (*name == '\0') || strchr(name, '/') ||
+	    (strlen(name) >= sizeof(eth->ifName))) {
+		printf("ETH: Invalid switch name.\n");
+		return -1;
+	}
+	strcpy(eth->ifName, name);
+	sprintf(shmName, "/ts10-vsw-%s", name);
+
+	// Create or attach that switch.
+	if ((fd = shm_open(shmName, O_RDWR|O_CREAT, 0600)) < 0) {
+		perror("ETH: Error (shm_open)");
+		return -1;
+	}
+	if (ftruncate(fd, sizeof(VSW_SWITCH)) < 0) {
+		perror("ETH: Error (ftruncate)");
+		close(fd);
+		return -1;
+	}
+	vsw = (VSW_SWITCH *)mmap(NULL, sizeof(VSW_SWITCH), PROT_READ|PROT_WRITE,
+		MAP_SHARED, fd, 0);
+	close(fd);
+	if (vsw == MAP_FAILED) {
+		perror("ETH: Error (mmap)");
+		return -1;
+	}
+	eth->Ring   = (uint8 *)vsw;
+	eth->szRing = sizeof(VSW_SWITCH);
+
+	// New switch is all zeros.
+	if (vsw->Version == 0) {
+		strcpy(vsw->Magic, VSW_MAGIC);
+		vsw->nPorts  = VSW_NPORTS;
+		vsw->Version = VSW_VERSION;
+	} else if ((vsw->Version != VSW_VERSION) || strcmp(vsw->Magic, VSW_MAGIC)) {
+		printf("ETH: Switch '%s' has wrong version.\n", name);
+		munmap(eth->Ring, eth->szRing);
+		eth->Ring = NULL;
+		return -1;
+	}
+
+	// Take a free port.
+	for (idx = 0; idx < VSW_NPORTS; idx++) {
+		port  = &vsw->Ports[idx];
+		owner = port->Owner;
+		if (owner && ((kill(owner, 0) == 0) || (errno != ESRCH)))
+			continue;
+		if (__sync_bool_compare_and_swap(&port->Owner, owner, pid))
+			break;
+	}
+	if (idx == VSW_NPORTS) {
+		printf("ETH: Switch '%s' is full.\n", name);
+		munmap(eth->Ring, eth->szRing);
+		eth->Ring = NULL;
+		return -1;
+	}
+	memset(port->Addr, 0, sizeof(ETH_MAC));
+	port->Tail = port->Head;
+	eth->idxFrame = idx;
+
+	// Give a station address by port number (DEC prefix).
+	eth->hostAddr[0] = 0x08;
+	eth->hostAddr[1] = 0x00;
+	eth->hostAddr[2] = 0x2B;
+	eth->hostAddr[3] = 0xFE;
+	eth->hostAddr[4] = 0x00;
+	eth->hostAddr[5] = idx + 1;
+	eth->Flags |= ETH_STATION;
+
+	return 0;
+}
+
+static void eth_SwitchClose(ETH_DEVICE *eth)
+{
+	VSW_SWITCH *vsw = (VSW_SWITCH *)eth->Ring;
+
+	if (vsw) {
+		vsw->Ports[eth->idxFrame].Owner = 0;
+		munmap(eth->Ring, eth->szRing);
+	}
+	eth->Ring = NULL;
+}
+
+// Put a frame into receive ring of that port.
+static void eth_SwitchPut(ETH_DEVICE *eth, VSW_PORT *port, uint8 *frame, int len)
+{
+	VSW_FRAME *vf;
+	int32     pid = getpid(), owner;
+	int       spin;
+
+	for (spin = 0; !__sync_bool_compare_and_swap(&port->Lock, 0, pid); spin++) {
+		if (spin < VSW_SPINS)
+			continue;
+
+		// Take lock from dead sender, otherwise drop it.
+		owner = port->Lock;
+		if (owner && (kill(owner, 0) < 0) && (errno == ESRCH) &&
+		    __sync_bool_compare_and_swap(&port->Lock, owner, pid))
+			break;
+		eth->nDrops++;
+		return;
+	}
+
+	if ((port->Head - port->Tail) < VSW_NFRAMES) {
+		vf = &port->Frames[port->Head & (VSW_NFRAMES-1)];
+		memcpy(vf->Data, frame, len);
+		vf->Len = len;
+		__sync_synchronize();
+		port->Head++;
+	} else
+		eth->nDrops++;
+	__sync_synchronize();
+	port->Lock = 0;
+}
+
+static int eth_SwitchSend(ETH_DEVICE *eth, uint8 *frame, int len)
+{
+	VSW_SWITCH *vsw = (VSW_SWITCH *)eth->Ring;
+	VSW_PORT   *own = &vsw->Ports[eth->idxFrame];
+	VSW_PORT   *port;
+	int        idx;
+
+	if ((len < 12) || (len > ETH_MAX)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	// Learn source address of this port.
+	if (memcmp(own->Addr, &frame[6], sizeof(ETH_MAC)))
+		memcpy(own->Addr, &frame[6], sizeof(ETH_MAC));
+
+	// Send it to that port which has destination address.
+	if ((frame[0] & 1) == 0) {
+		for (idx = 0; idx < VSW_NPORTS; idx++) {
+			port = &vsw->Ports[idx];
+			if ((port != own) && port->Owner &&
+			    !memcmp(port->Addr, frame, sizeof(ETH_MAC))) {
+				eth_SwitchPut(eth, port, frame, len);
+				return len;
+			}
+		}
+	}
+
+	// Otherwise, send it to all other ports.
+	for (idx = 0; idx < VSW_NPORTS; idx++) {
+		port = &vsw->Ports[idx];
+		if ((port != own) && port->Owner)
+			eth_SwitchPut(eth, port, frame, len);
+	}
+
+	return len;
+}
+
+// Take all frames from receive ring of this port.
+static void eth_SwitchPoll(ETH_DEVICE *eth)
+{
+	VSW_SWITCH *vsw  = (VSW_SWITCH *)eth->Ring;
+	VSW_PORT   *port = &vsw->Ports[eth->idxFrame];
+	VSW_FRAME  *vf;
+	uint32     len;
+
+	while (port->Tail != port->Head) {
+		__sync_synchronize();
+		vf = &port->Frames[port->Tail & (VSW_NFRAMES-1)];
+
+		// Other processes can write anything there.
+		if ((len = vf->Len) > ETH_MAX)
+			len = ETH_MAX;
+		if (eth_Accept(eth, vf->Data)) {
+			eth->nRecv++;
+			eth->Receive(eth->Device, vf->Data, len);
+		}
+		__sync_synchronize();
+		port->Tail++;
+	}
+}
+
+#endif /* __linux__ */
+
+// ********************************************************************
 
 ETH_TYPE EtherTypes[] = {
-	{ "tun", "TAP/TUN Connection" },
-	{ "tap", "TAP/TUN Connection" },
+	{ "tun",    "TAP/TUN Connection",
+		eth_TapOpen, eth_TapClose, eth_TapSend, NULL, NULL, NULL },
+	{ "tap",    "TAP/TUN Connection",
+		eth_TapOpen, eth_TapClose, eth_TapSend, NULL, NULL, NULL },
+#ifdef __linux__
+	{ "packet", "Raw Packet Socket (PACKET_MMAP)",
+		eth_PacketOpen, eth_PacketClose, eth_PacketSend, eth_PacketPoll,
+		eth_PacketFilter, eth_PacketSendBatch },
+	{ "vsw",    "Virtual Switch (Shared Memory)",
+		eth_SwitchOpen, eth_SwitchClose, eth_SwitchSend, eth_SwitchPoll,
+		NULL, NULL },
+#endif /* __linux__ */
+	{ "proc",   "TAP/TUN Connection on Device Process",
+		epp_Open, epp_Close, epp_Send, epp_Poll, NULL, NULL },
 	{ NULL } // Null Terminator
 };
 
-
 // Get Ethernet Address in Printable Format
 char *eth_FormatAddress(ETH_MAC *mac, char *str)
 {
@@ -93,10 +632,69 @@ void TraceEtherPacket(ETH_PACKET *pkt)
 }
 #endif /* DEBUG */
 
+// Poll all polled devices for incoming frames.
+static void eth_PollAll(void *dptr)
+{
+	ETH_DEVICE *eth;
+
+	for (eth = eth_PollList; eth; eth = eth->Next)
+		eth->Type->Poll(eth);
+	if (eth_PollList)
+		ts10_SetTimer(&eth_PollTimer);
+}
+
 // Open Ethernet Connection
-ETH_DEVICE *OpenEther(char *name)
+ETH_DEVICE *OpenEther(char *name, void *dev, void (*recv)(void *, uint8 *, int))
 {
 	ETH_DEVICE *eth;
+	char       typeName[16], *arg;
+	int        len, idx;
+
+	// Get backend type and argument from name.
+	if (arg = strchr(name, ':')) {
+		len = arg++ - name;
+	} else
+		len = strlen(name);
+	if (len >= sizeof(typeName)) {
+		printf("ETH: Unknown type - %s\n", name);
+		return NULL;
+	}
+	strncpy(typeName, name, len);
+	typeName[len] = '\0';
+
+	for (idx = 0; EtherTypes[idx].name; idx++)
+		if (!strcasecmp(typeName, EtherTypes[idx].name))
+			break;
+	if (EtherTypes[idx].name == NULL) {
+		printf("ETH: Unknown type - %s\n", typeName);
+		return NULL;
+	}
+
+	if ((eth = (ETH_DEVICE *)calloc(1, sizeof(ETH_DEVICE))) == NULL)
+		return NULL;
+	eth->Type     = &EtherTypes[idx];
+	eth->Device   = dev;
+	eth->Receive  = recv;
+	eth->idSocket = -1;
+	if (eth->Type->Open(eth, arg)) {
+		free(eth);
+		return NULL;
+	}
+
+	// Start polling for incoming frames.
+	if (eth->Type->Poll) {
+		if (eth_PollList == NULL) {
+			eth_PollTimer.Name     = "ETH";
+			eth_PollTimer.Flags    = 0;
+			eth_PollTimer.outTimer = ETH_POLLTIME;
+			eth_PollTimer.nxtTimer = ETH_POLLTIME;
+			eth_PollTimer.Device   = NULL;
+			eth_PollTimer.Execute  = eth_PollAll;
+		}
+		eth->Next    = eth_PollList;
+		eth_PollList = eth;
+		ts10_SetTimer(&eth_PollTimer);
+	}
 
 	return eth;
 }
@@ -104,4 +702,78 @@ ETH_DEVICE *OpenEther(char *name)
 // Close Ethernet Connection
 void CloseEther(ETH_DEVICE *eth)
 {
+	ETH_DEVICE **peth;
+
+	for (peth = &eth_PollList; *peth; peth = &(*peth)->Next)
+		if (*peth == eth) {
+			*peth = eth->Next;
+			break;
+		}
+	if ((eth_PollList == NULL) && (eth_PollTimer.Flags & CLK_PENDING))
+		ts10_CancelTimer(&eth_PollTimer);
+
+	eth->Type->Close(eth);
+	free(eth);
+}
+
+// Send a frame to the world.
+int SendEther(ETH_DEVICE *eth, uint8 *frame, int len)
+{
+	int rc;
+
+	if ((rc = eth->Type->Send(eth, frame, len)) >= 0)
+		eth->nSent++;
+	return rc;
+}
+
+// Send a batch of frames (one frame per iovec entry).
+// Return number of frames sent, or -1 if none sent.
+int SendEtherBatch(ETH_DEVICE *eth, struct iovec *frames, int nFrames)
+{
+	int idx, rc;
+
+	if (eth->Type->SendBatch) {
+		if ((rc = eth->Type->SendBatch(eth, frames, nFrames)) > 0)
+			eth->nSent += rc;
+		return rc;
+	}
+
+	for (idx = 0; idx < nFrames; idx++)
+		if (SendEther(eth, frames[idx].iov_base, frames[idx].iov_len) < 0)
+			return idx ? idx : -1;
+	return nFrames;
+}
+
+// Give an incoming frame to device (for backends outside).
+void eth_Receive(ETH_DEVICE *eth, uint8 *frame, int len)
+{
+	if ((len < sizeof(ETH_MAC)) || !eth_Accept(eth, frame))
+		return;
+	eth->nRecv++;
+	eth->Receive(eth->Device, frame, len);
+}
+
+// Set destination address filter for incoming frames.
+//   Flags: ETH_PROMISC  - Accept all frames
+//          ETH_ALLMULTI - Accept all multicast frames
+int SetEtherFilter(ETH_DEVICE *eth, uint32 flags, ETH_MAC *addrs, int nAddrs)
+{
+	int idx;
+
+	if (nAddrs > ETH_NFILTER)
+		nAddrs = ETH_NFILTER;
+
+	eth->Flags   = (eth->Flags & ~(ETH_PROMISC|ETH_ALLMULTI)) |
+		(flags & (ETH_PROMISC|ETH_ALLMULTI)) | ETH_FILTER;
+	eth->fltHash = 0;
+	for (idx = 0; idx < nAddrs; idx++) {
+		memcpy(eth->fltAddr[idx], addrs[idx], sizeof(ETH_MAC));
+		eth->fltHash |= eth_HashAddr(addrs[idx]);
+	}
+	eth->nFilter = nAddrs;
+
+	// Let backend filter them on host side too.
+	if (eth->Type->Filter)
+		return eth->Type->Filter(eth);
+	return 0;
 }
@@ -38,6 +38,29 @@
 #define ETH_MAX  1536  // Maximum Ethernet Packet Size
 #define ETH_SIZE ETH_MAX
 
+#define ETH_POLLTIME 2000  // Receive poll interval (instructions)
+
+// Ethernet Device Flags
+#define ETH_STATION  0x0001  // Host address is station address to use
+#define ETH_FILTER   0x0002  // Filter incoming frames by destination
+#define ETH_PROMISC  0x0004  //   Promiscuous mode (accept all frames)
+#define ETH_ALLMULTI 0x0008  //   Accept all multicast frames
+
+#define ETH_NFILTER  16  // Addresses in destination filter
+#define ETH_NBATCH   64  // Frames per sendmmsg call
+
+// PACKET_MMAP receive ring (AF_PACKET)
+#define ETH_FRAMESZ  2048         // Size of ring frame
+#define ETH_BLOCKSZ  (64 * 1024)  // Size of ring block
+#define ETH_NBLOCKS  8            // Number of ring blocks
+
+// Virtual switch (shared memory)
+#define VSW_MAGIC    "TS10VSW"
+#define VSW_VERSION  1
+#define VSW_NPORTS   32  // Ports per switch
+#define VSW_NFRAMES  64  // Receive ring per port (power of two)
+#define VSW_SPINS    1000 // Tries for port lock before dropping frame
+
 typedef uint8 ETH_MAC[6];              // MAC Address (6 bytes)
 typedef struct EtherPacket ETH_PACKET; // Ethernet Packet Message
 typedef struct EtherType   ETH_TYPE;   // Ethernet Type
@@ -51,7 +74,59 @@ struct EtherPacket {
 struct EtherType {
 	char   *name;   // Ethernet Type Name
 	char   *desc;   //   Description
+
+	// Backend Function Calls
+	int    (*Open)(ETH_DEVICE *, char *);
+	void   (*Close)(ETH_DEVICE *);
+	int    (*Send)(ETH_DEVICE *, uint8 *, int);
+	void   (*Poll)(ETH_DEVICE *); // Polled for input (or NULL)
+	int    (*Filter)(ETH_DEVICE *); // Set host filter (or NULL)
+	int    (*SendBatch)(ETH_DEVICE *, struct iovec *, int); // (or NULL)
 };
 
 struct EtherDevice {
+	ETH_DEVICE *Next;        // Next polled device
+	ETH_TYPE   *Type;        // Backend Type
+	uint32     Flags;        // Device Flags
+	char       ifName[40];   // Interface or Switch Name
+	ETH_MAC    hostAddr;     // Host Ethernet Address
+
+	// User-defined device and receive routine
+	void       *Device;
+	void       (*Receive)(void *, uint8 *, int);
+
+	// Backend Data
+	SOCKET     *Socket;      // TAP/TUN connection
+	int        idSocket;     // Packet socket
+	uint8      *Ring;        // Packet receive ring (or switch)
+	uint32     szRing;       // Size of ring (or switch)
+	uint32     nFrames;      // Number of frames in ring
+	uint32     idxFrame;     // Next frame in ring (or switch port)
+	void       *Process;     // Device process (proc)
+
+	// Destination Address Filter
+	int        nFilter;                // Number of Addresses
+	uint64     fltHash;                // Hash Set (One bit per address)
+	ETH_MAC    fltAddr[ETH_NFILTER];   // Addresses
+
+	// Statistics
+	uint32     nSent;        // Frames sent
+	uint32     nRecv;        // Frames received
+	uint32     nDrops;       // Frames dropped (switch full)
+	uint32     nFiltered;    // Frames rejected by filter
 };
+
+// Prototype definitions
+char       *eth_FormatAddress(ETH_MAC *, char *);
+ETH_DEVICE *OpenEther(char *, void *, void (*)(void *, uint8 *, int));
+void       CloseEther(ETH_DEVICE *);
+int        SendEther(ETH_DEVICE *, uint8 *, int);
+int        SendEtherBatch(ETH_DEVICE *, struct iovec *, int);
+int        SetEtherFilter(ETH_DEVICE *, uint32, ETH_MAC *, int);
+void       eth_Receive(ETH_DEVICE *, uint8 *, int);
+
+// dev/dp/epp_tun.c - TUN/TAP on device process
+int        epp_Open(ETH_DEVICE *, char *);
+void       epp_Close(ETH_DEVICE *);
+int        epp_Send(ETH_DEVICE *, uint8 *, int);
+void       epp_Poll(ETH_DEVICE *);
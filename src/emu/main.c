@@ -34,6 +34,8 @@
 
 #include "emu/defs.h"
 #include "emu/socket.h"
+#include "emu/vdisk.h"
+#include "emu/vzip.h"
 
 void (*emu_IOTrap)(void) = NULL;
 int  emu_State;
@@ -91,8 +93,12 @@ void emu_BadMemory(int s)
 
 void emu_IO(int s)
 {
+	// Socket handler may raise interrupts.
+	ts10_EnterSignal();
 	if (emu_IOTrap)
 		emu_IOTrap();
+	ts10_LeaveSignal();
+	ts10_Wakeup();
 
 #ifndef HAVE_SIGACTION
 	signal(SIGIO,  emu_IO);
@@ -107,6 +113,8 @@ void ts10_Exit(char *Reason)
 	sprintf(outReason, "\r\nTS10 Emulator Exit (Reason: %s)\r\n", Reason);
 	sock_Send(1, outReason, 0);
 	sock_CloseAll(outReason);
+	vdk_FlushCache(NULL);
+	vzp_FlushAll();
 	CleanupControlPanel();
 
 #ifdef DEBUG
@@ -146,6 +154,11 @@ int main(int argc, char **argv)
 	signal(SIGURG,  emu_IO);
 #endif /* HAVE_SIGACTION */
 
+	// Writes to closed pipes and sockets (like doorbells of
+	// dead device processes) must fail with EPIPE instead.
+	signal(SIGPIPE, SIG_IGN);
+
+	ts10_OpenWakeup();  // Open Wakeup for Idle Processor
 	InitSystem();       // Initialize Emulator System
 	InitSockets();      // Initialize Socket Handler
 	InitControlPanel(); // Initialize Panel Control Handler
@@ -186,7 +199,7 @@ int main(int argc, char **argv)
 				printf("Please type 'select <device>' first.\n");
 			emu_State = EMU_CONSOLE;
 		}
-		pause();
+		sock_Wait();
 	}
 
 	ts10_Exit("Exit");
@@ -45,6 +45,11 @@ int    ts10_StartTimer(void);
 int    ts10_StopTimer(void);
 int    ts10_SetAlarm(void (*)(int));
 void   ts10_TickRealTimer(int);
+int    ts10_OpenWakeup(void);
+void   ts10_Wakeup(void);
+int    ts10_WaitWakeup(int);
+int    ts10_AddIOPoll(void (*)(void));
+void   ts10_RemoveIOPoll(void (*)(void));
 void   ts10_SetRealTimer(CLK_QUEUE *);
 uint32 ts10_GetGlobalTime(void);
 void   ts10_InitTimer(void);
@@ -52,6 +57,10 @@ void   ts10_SetTimer(CLK_QUEUE *);
 void   ts10_CancelRealTimer(CLK_QUEUE *);
 void   ts10_CancelTimer(CLK_QUEUE *);
 void   ts10_ExecuteTimer(void);
+int32  ts10_SkipTimer(void);
+void   ts10_CutBatch(void);
+void   ts10_EnterSignal(void);
+void   ts10_LeaveSignal(void);
 
 // panel.c
 void       InitControlPanel(void);
@@ -79,6 +88,14 @@ int   CmdShow2(void *, int, char **);
 int   CmdShowDevice(void *, int, char **);
 int   CmdListDevice(void *, int, char **);
 
+// vdisk.c
+int   CmdOverlay(void *, int, char **);
+int   CmdSetCache(void *, int, char **);
+int   CmdShowCache(void *, int, char **);
+
+// vzip.c
+int   CmdCompress(void *, int, char **);
+
 // Utilities - emu/utils.c
 void  RemoveSpaces(register char *);
 char  *SplitChar(register char **, register char);
@@ -38,6 +38,13 @@
 
 #include "emu/defs.h"
 #include "emu/socket.h"
+#include <sys/uio.h>
+
+#ifdef SOCK_EPOLL
+#include <signal.h>
+#include <sys/epoll.h>
+#include "emu/pthread.h"
+#endif /* SOCK_EPOLL */
 
 static SOCKET Sockets[NET_MAXSOCKETS];
 
@@ -45,9 +52,253 @@ static fd_set fdsRead;
 static fd_set fdsWrite;
 
 static int sock_Error = NET_OK;
+static int sock_Serial = 0;
+
+static SOCKET    *sockOutList = NULL; // Sockets with pending output
+static CLK_QUEUE sockOutTimer;        // Output flush timer
 
 extern void (*emu_IOTrap)();
 
+#ifdef SOCK_EPOLL
+
+// I/O Thread
+//
+// I/O thread waits for socket, TUN/TAP and standard input activities
+// through epoll and reads data into the I/O queue, then wakes up
+// emulator thread.  Emulator thread drains that queue by sock_Poll
+// at next batch boundary, and calls socket callback functions from
+// there.  The queue has a single
+// producer and a single consumer so that no locks are needed for
+// passing data.  Listen and OWNIO sockets are only noticed to the
+// emulator thread, which accepts or reads them itself.
+//
+// Each descriptor is armed as one-shot, so that I/O thread never
+// sees it again until its data is queued (or the emulator thread
+// is done with it).  sockLock keeps sock_Close from closing any
+// descriptor while I/O thread is reading it.
+//
+// If the queue is full, I/O thread sleeps on sockDrain until emulator
+// thread has taken some entries.  sockFull tells emulator thread that
+// it has to signal.
+
+#define NET_MAXEVENTS  64   // Maximum number of events per wait
+#define NET_NQUEUE     256  // Size of I/O queue (power of two)
+
+#define SQ_DATA        0    // Incoming data
+#define SQ_EOF         1    // End of file or error
+#define SQ_NOTIFY      2    // Activity on listen/OWNIO socket
+
+typedef struct {
+	int   idSlot;               // Socket slot
+	int   ioSerial;             // Socket serial number
+	int   Type;                 // Type of entry
+	int   nBytes;               // Number of bytes (or read status)
+	int   nError;               // Error code
+	uchar Data[NET_MAXBUF+1];   // Incoming data
+} SOCKQUEUE;
+
+static SOCKQUEUE       sockQueue[NET_NQUEUE];
+static volatile uint32 sockHead = 0;  // Next entry to fill (I/O thread)
+static volatile uint32 sockTail = 0;  // Next entry to drain (emulator)
+static int             sockPoll = -1; // epoll descriptor
+static pthread_t       sockThread;
+static pthread_mutex_t sockLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t sockWait = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  sockDrain = PTHREAD_COND_INITIALIZER;
+static volatile int    sockFull = 0;  // I/O thread waits for room
+
+// Arm or re-arm that socket for next activity.
+static void sock_Arm(SOCKET *Socket, int op)
+{
+	struct epoll_event ev;
+
+	ev.events   = EPOLLIN | EPOLLONESHOT;
+	ev.data.u64 = ((uint64)(uint32)Socket->ioSerial << 32) |
+		(uint32)(Socket - Sockets);
+	if (epoll_ctl(sockPoll, op, Socket->idSocket, &ev) < 0) {
+#ifdef DEBUG
+		if (dbg_Check(DBG_SOCKERR))
+			dbg_Printf("SCK: *** Error (epoll_ctl): %s\n", strerror(errno));
+#endif /* DEBUG */
+	}
+}
+
+static void *sock_IOThread(void *arg)
+{
+	struct epoll_event evs[NET_MAXEVENTS];
+	SOCKQUEUE *qptr;
+	SOCKET    *pSocket;
+	int       nEvents, nBytes;
+	int       idx;
+
+	for (;;) {
+		if ((nEvents = epoll_wait(sockPoll, evs, NET_MAXEVENTS, -1)) < 0) {
+			if (errno == EINTR)
+				continue;
+#ifdef DEBUG
+			if (dbg_Check(DBG_SOCKERR))
+				dbg_Printf("SCK: *** Error (epoll_wait): %s\n", strerror(errno));
+#endif /* DEBUG */
+			break;
+		}
+
+		for (idx = 0; idx < nEvents; idx++) {
+			// Wait for emulator thread to drain queue if full.
+			if ((sockHead - sockTail) >= NET_NQUEUE) {
+				ts10_Wakeup();
+				pthread_mutex_lock(&sockWait);
+				sockFull = 1;
+				__sync_synchronize();
+				while ((sockHead - sockTail) >= NET_NQUEUE)
+					pthread_cond_wait(&sockDrain, &sockWait);
+				sockFull = 0;
+				pthread_mutex_unlock(&sockWait);
+			}
+			qptr = &sockQueue[sockHead & (NET_NQUEUE-1)];
+
+			pthread_mutex_lock(&sockLock);
+			pSocket = &Sockets[(uint32)evs[idx].data.u64];
+			if (((pSocket->Flags & SCK_OPENED) == 0) ||
+			    (pSocket->ioSerial != (int)(evs[idx].data.u64 >> 32))) {
+				// Socket was closed already.
+				pthread_mutex_unlock(&sockLock);
+				continue;
+			}
+
+			qptr->idSlot   = pSocket - Sockets;
+			qptr->ioSerial = pSocket->ioSerial;
+			if (pSocket->Flags & (SCK_LISTEN|SCK_OWNIO)) {
+				// Emulator thread will re-arm it.
+				qptr->Type = SQ_NOTIFY;
+			} else {
+				// Attempt to read a packet from Internet.
+				nBytes = read(pSocket->idSocket, qptr->Data, NET_MAXBUF);
+				qptr->nBytes = nBytes;
+				qptr->nError = errno;
+				if (nBytes > 0) {
+					qptr->Type = SQ_DATA;
+					sock_Arm(pSocket, EPOLL_CTL_MOD);
+				} else if ((nBytes < 0) && (errno == EAGAIN)) {
+					sock_Arm(pSocket, EPOLL_CTL_MOD);
+					pthread_mutex_unlock(&sockLock);
+					continue;
+				} else
+					qptr->Type = SQ_EOF;
+			}
+			pthread_mutex_unlock(&sockLock);
+
+			// Pass that entry to emulator thread.
+			__sync_synchronize();
+			sockHead++;
+		}
+
+		// Wake up emulator thread if it is waiting.
+		ts10_Wakeup();
+	}
+
+	return NULL;
+}
+
+// Process all entries from I/O thread.  Called by emulator thread.
+void sock_Poll(void)
+{
+	SOCKQUEUE *qptr;
+	SOCKET    *pSocket;
+
+	while (sockTail != sockHead) {
+		__sync_synchronize();
+		qptr    = &sockQueue[sockTail & (NET_NQUEUE-1)];
+		pSocket = &Sockets[qptr->idSlot];
+
+		if ((pSocket->Flags & SCK_OPENED) &&
+		    (pSocket->ioSerial == qptr->ioSerial)) {
+			switch (qptr->Type) {
+				case SQ_NOTIFY:
+					if (pSocket->Flags & SCK_LISTEN)
+						pSocket->Accept(pSocket);
+					else
+						pSocket->OwnIO(pSocket);
+					if ((pSocket->Flags & SCK_OPENED) &&
+					    (pSocket->ioSerial == qptr->ioSerial))
+						sock_Arm(pSocket, EPOLL_CTL_MOD);
+					break;
+
+				case SQ_DATA:
+					// Socket successfully is connected.
+					if (pSocket->Flags & SCK_CONNECT)
+						pSocket->Flags &= ~SCK_CONNECT;
+#ifdef DEBUG
+					if (dbg_Check(DBG_SOCKETS))
+						sock_Dump(pSocket->idSocket, qptr->Data,
+							qptr->nBytes, "Input");
+#endif /* DEBUG */
+					pSocket->Process(pSocket, (char *)qptr->Data, qptr->nBytes);
+					break;
+
+				case SQ_EOF:
+#ifdef DEBUG
+					if ((qptr->nBytes < 0) && dbg_Check(DBG_SOCKERR))
+						dbg_Printf("SCK: *** Error (read): %s\n",
+							strerror(qptr->nError));
+#endif /* DEBUG */
+					pSocket->Eof(pSocket, qptr->nBytes, qptr->nError);
+					break;
+			}
+		}
+
+		__sync_synchronize();
+		sockTail++;
+	}
+
+	// Let I/O thread go on if it waits for room.
+	__sync_synchronize();
+	if (sockFull) {
+		pthread_mutex_lock(&sockWait);
+		pthread_cond_signal(&sockDrain);
+		pthread_mutex_unlock(&sockWait);
+	}
+}
+
+// Wait for any activities in console mode.
+void sock_Wait(void)
+{
+	// Send all pending output before waiting.
+	sock_FlushAll();
+
+	// Interrupted by any signal as well.
+	if (sockTail == sockHead)
+		ts10_WaitWakeup(-1);
+	sock_Poll();
+}
+
+#else /* SOCK_EPOLL */
+
+void sock_Poll(void)
+{
+}
+
+void sock_Wait(void)
+{
+	sock_FlushAll();
+	pause();
+}
+
+#endif /* SOCK_EPOLL */
+
+// Set I/O async for that descriptor.
+static void sock_SetAsync(int newSocket)
+{
+	int flags;
+
+	flags = fcntl(newSocket, F_GETFL, 0);
+#ifdef SOCK_EPOLL
+	fcntl(newSocket, F_SETFL, flags | FNDELAY);
+#else
+	fcntl(newSocket, F_SETFL, flags | FASYNC|FNDELAY);
+	fcntl(newSocket, F_SETOWN, getpid());
+#endif /* SOCK_EPOLL */
+}
+
 // Default unconfigured functions for each new socket.
 SOCKTYPE SocketDefault;
 void SocketAccept(SOCKET *);
@@ -55,6 +306,8 @@ void SocketEof(SOCKET *, int, int);
 void SocketProcess(SOCKET *, char *, int);
 void SocketStatus(SOCKET *);
 
+static void sock_OutFlush(void *);
+
 // Initialize Socket Handler
 void InitSockets(void)
 {
@@ -65,12 +318,44 @@ void InitSockets(void)
 	// Initialize socket table.
 	memset(&Sockets, 0, sizeof(SOCKET) * NET_MAXSOCKETS);
 
+	// Set up output flush timer.
+	sockOutTimer.Name     = "SCK";
+	sockOutTimer.Flags    = 0;
+	sockOutTimer.outTimer = NET_FLUSHTIME;
+	sockOutTimer.nxtTimer = NET_FLUSHTIME;
+	sockOutTimer.Device   = NULL;
+	sockOutTimer.Execute  = sock_OutFlush;
+
+#ifdef SOCK_EPOLL
+	{
+		sigset_t allSigs, oldSigs;
+
+		if ((sockPoll = epoll_create(NET_MAXSOCKETS)) < 0) {
+			perror("Socket Error (epoll)");
+			return;
+		}
+
+		// Start I/O thread with all signals blocked so that
+		// emulator thread still receives all signals.
+		sigfillset(&allSigs);
+		pthread_sigmask(SIG_BLOCK, &allSigs, &oldSigs);
+		if (pthread_create(&sockThread, NULL, sock_IOThread, NULL))
+			perror("Socket Error (pthread)");
+		pthread_sigmask(SIG_SETMASK, &oldSigs, NULL);
+
+		ts10_AddIOPoll(sock_Poll);
+	}
+#else
 	emu_IOTrap = SocketHandler;
+#endif /* SOCK_EPOLL */
 }
 
 void sock_Cleanup(void)
 {
 	emu_IOTrap = NULL;
+#ifdef SOCK_EPOLL
+	ts10_RemoveIOPoll(sock_Poll);
+#endif /* SOCK_EPOLL */
 }
 
 #ifdef DEBUG
@@ -134,9 +419,7 @@ SOCKET *sock_Open(char *sockName, int newPort, int mode)
 			newSocket = newPort;
 
 			// Now set I/O async for socket stream.
-			flags = fcntl(newSocket, F_GETFL, 0);
-			fcntl(newSocket, F_SETFL, flags | FASYNC|FNDELAY);
-			fcntl(newSocket, F_SETOWN, getpid());
+			sock_SetAsync(newSocket);
 
 			flags = SCK_STDIO;
 			break;
@@ -182,9 +465,7 @@ SOCKET *sock_Open(char *sockName, int newPort, int mode)
 			strcpy(sockName, ifr.ifr_name);
 
 			// Now set I/O async for TUN/TAP stream.
-			flags = fcntl(newSocket, F_GETFL, 0);
-			fcntl(newSocket, F_SETFL, flags | FASYNC|FNDELAY);
-			fcntl(newSocket, F_SETOWN, getpid());
+			sock_SetAsync(newSocket);
 
 			// Set flags for Ethernet packets.
 			flags = SCK_PACKET;
@@ -199,9 +480,7 @@ SOCKET *sock_Open(char *sockName, int newPort, int mode)
 			}
 
 			// Now set I/O async for socket stream.
-			flags = fcntl(newSocket, F_GETFL, 0);
-			fcntl(newSocket, F_SETFL, flags | FASYNC|FNDELAY);
-			fcntl(newSocket, F_SETOWN, getpid());
+			sock_SetAsync(newSocket);
 			setsockopt(newSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
 
 			// Give socket a local name;
@@ -226,6 +505,9 @@ SOCKET *sock_Open(char *sockName, int newPort, int mode)
 	}
 
 	// Initialize a socket slot for new socket.
+#ifdef SOCK_EPOLL
+	pthread_mutex_lock(&sockLock);
+#endif /* SOCK_EPOLL */
 	if (sockName) {
 		Socket->Name = malloc(strlen(sockName)+1);
 		strcpy(Socket->Name, sockName);
@@ -233,6 +515,7 @@ SOCKET *sock_Open(char *sockName, int newPort, int mode)
 	Socket->idSocket = newSocket;
 	Socket->locAddr  = locAddr;
 	Socket->remAddr  = remAddr;
+	Socket->ioSerial = ++sock_Serial;
 	Socket->Flags    |= (flags | SCK_OPENED); // Now occupied.
 
 	// Set up unconfigured functions so that TS10 will not
@@ -243,8 +526,15 @@ SOCKET *sock_Open(char *sockName, int newPort, int mode)
 	Socket->Eof     = SocketEof;
 	Socket->Process = SocketProcess;
 
+#ifdef SOCK_EPOLL
+	// Server sockets are armed when listening.
+	if ((mode != NET_FILE) && (mode != NET_SERVER))
+		sock_Arm(Socket, EPOLL_CTL_ADD);
+	pthread_mutex_unlock(&sockLock);
+#else
 	if (mode != NET_FILE)
 		FD_SET(newSocket, &fdsRead);
+#endif /* SOCK_EPOLL */
 
 	return Socket;
 }
@@ -253,7 +543,26 @@ int sock_Close(SOCKET *Socket)
 {
 	SOCKET *srvSocket = Socket->Server;
 	int oldSocket     = Socket->idSocket;
-
+	SOCKET **pSocket;
+
+	// Send pending output and release output buffer.
+	if (Socket->Flags & SCK_OUTPUT) {
+		sock_Flush(Socket);
+		for (pSocket = &sockOutList; *pSocket; pSocket = &(*pSocket)->outNext)
+			if (*pSocket == Socket) {
+				*pSocket = Socket->outNext;
+				break;
+			}
+	}
+	if (Socket->outBuf)
+		free(Socket->outBuf);
+
+#ifdef SOCK_EPOLL
+	// Keep I/O thread off that descriptor while closing.
+	pthread_mutex_lock(&sockLock);
+	if ((Socket->Flags & SCK_FILE) == 0)
+		epoll_ctl(sockPoll, EPOLL_CTL_DEL, oldSocket, NULL);
+#endif /* SOCK_EPOLL */
 	if (Socket->Flags & SCK_SOCKET)
 		shutdown(oldSocket, SHUT_RDWR);
 	FD_CLR(oldSocket, &fdsRead);
@@ -270,12 +579,16 @@ int sock_Close(SOCKET *Socket)
 
 	// Clear all slot.
 	memset(Socket, 0, sizeof(SOCKET));
+#ifdef SOCK_EPOLL
+	pthread_mutex_unlock(&sockLock);
+#endif /* SOCK_EPOLL */
 }
 
 void sock_CloseAll(char *outReason)
 {
 	int idx;
 
+	sock_FlushAll();
 	for (idx = 0; idx < NET_MAXSOCKETS; idx++) {
 		if ((Sockets[idx].Flags & SCK_OPENED) &&
 		    ((Sockets[idx].Flags & SCK_STDIO) == 0)) {
@@ -301,6 +614,9 @@ int sock_Listen(SOCKET *Socket, int backlog)
 		return NET_SOCKERR;
 	}
 	Socket->Flags |= SCK_LISTEN;
+#ifdef SOCK_EPOLL
+	sock_Arm(Socket, EPOLL_CTL_ADD);
+#endif /* SOCK_EPOLL */
 
 	return NET_OK;
 }
@@ -311,7 +627,7 @@ SOCKET *sock_Accept(SOCKET *srvSocket)
 	SOCKADDRIN remAddr;
 	uint32 lenAddr = sizeof(remAddr);
 	int newSocket;
-	int flags, idx;
+	int idx;
 
 	if (srvSocket == NULL)
 		return NULL;
@@ -325,10 +641,10 @@ SOCKET *sock_Accept(SOCKET *srvSocket)
 	}
 
 	// Now set I/O async for socket stream.
-	flags = fcntl(newSocket, F_GETFL, 0);
-	fcntl(newSocket, F_SETFL, flags | FASYNC|FNDELAY);
-	fcntl(newSocket, F_SETOWN, getpid());
+	sock_SetAsync(newSocket);
+#ifndef SOCK_EPOLL
 	FD_SET(newSocket, &fdsRead);
+#endif /* SOCK_EPOLL */
 
 	// Find a empty slot for the incoming connection.
 	Socket = NULL; // Assume that slots are full.
@@ -356,17 +672,32 @@ SOCKET *sock_Accept(SOCKET *srvSocket)
 	}
 
 	// Set up a new socket slot.
+#ifdef SOCK_EPOLL
+	pthread_mutex_lock(&sockLock);
+#endif /* SOCK_EPOLL */
 	Socket->Server   = srvSocket;
 	Socket->idSocket = newSocket;
+	Socket->ioSerial = ++sock_Serial;
 	Socket->Flags    = SCK_OPENED|SCK_CONNECT|SCK_SOCKET;
 	Socket->locAddr  = srvSocket->locAddr;
 	Socket->remAddr  = remAddr;
+#ifdef SOCK_EPOLL
+	sock_Arm(Socket, EPOLL_CTL_ADD);
+	pthread_mutex_unlock(&sockLock);
+#endif /* SOCK_EPOLL */
 
 	return Socket;
 }
 
 int sock_Send(int idSocket, char *str, int len)
 {
+	SOCKET *pSocket;
+
+	// Keep pending output of that descriptor in order.
+	for (pSocket = sockOutList; pSocket; pSocket = pSocket->outNext)
+		if (pSocket->idSocket == idSocket)
+			sock_Flush(pSocket);
+
 	if (str && *str) {
 		if (len == 0)
 			len = strlen(str);
@@ -388,6 +719,10 @@ int SockSendPacket(SOCKET *Socket, uint8 *pkt, uint32 len)
 
 int sock_Print(SOCKET *Socket, char *str, int len)
 {
+	// Keep pending output in order.
+	if (Socket->outCount)
+		sock_Flush(Socket);
+
 	if (str && *str) {
 		if (len == 0)
 			len = strlen(str);
@@ -412,9 +747,132 @@ int SockPrintf(SOCKET *Socket, cchar *Format, ...)
 	va_end(Args);
 
 	// Send it away and return.
+	if (Socket->outCount)
+		sock_Flush(Socket);
 	return write(Socket->idSocket, tmpBuffer, len);
 }
 
+// Output Buffer
+//
+// Terminal lines send characters one at a time, so that they are
+// put into output buffer of that socket instead of being written
+// at once.  All pending output is written by flush timer every
+// NET_FLUSHTIME instructions, when buffer is full, or before
+// emulator waits in console mode.  Buffer is a ring, so that each
+// flush takes one writev call.  Data not taken by a non-blocking
+// socket are kept for next flush.
+
+// Put data into output buffer of that socket.
+int sock_Output(SOCKET *Socket, char *str, int len)
+{
+	int idx, pos, cnt;
+
+	if ((str == NULL) || (*str == '\0'))
+		return 0;
+	if (len == 0)
+		len = strlen(str);
+
+	if ((Socket->outBuf == NULL) &&
+	    ((Socket->outBuf = (char *)malloc(NET_MAXOUT)) == NULL))
+		return sock_Print(Socket, str, len);
+
+	for (idx = 0; idx < len; idx += cnt) {
+		if (Socket->outCount == NET_MAXOUT) {
+			// Buffer is full - write it now.
+			sock_Flush(Socket);
+			if (Socket->outCount == NET_MAXOUT)
+				break;
+		}
+		pos = (Socket->outHead + Socket->outCount) & (NET_MAXOUT-1);
+		cnt = NET_MAXOUT - Socket->outCount;
+		if (cnt > (NET_MAXOUT - pos))
+			cnt = NET_MAXOUT - pos;
+		if (cnt > (len - idx))
+			cnt = len - idx;
+		memcpy(&Socket->outBuf[pos], &str[idx], cnt);
+		Socket->outCount += cnt;
+	}
+
+	// Put that socket on pending list and start flush timer.
+	if (Socket->outCount && !(Socket->Flags & SCK_OUTPUT)) {
+		Socket->Flags   |= SCK_OUTPUT;
+		Socket->outNext  = sockOutList;
+		sockOutList      = Socket;
+		ts10_SetTimer(&sockOutTimer);
+	}
+
+	return idx;
+}
+
+// Write all pending output of that socket.
+void sock_Flush(SOCKET *Socket)
+{
+	struct iovec iov[2];
+	int          nVecs = 1, rc;
+
+	if (Socket->outCount == 0)
+		return;
+
+	iov[0].iov_base = &Socket->outBuf[Socket->outHead];
+	iov[0].iov_len  = Socket->outCount;
+	if ((Socket->outHead + Socket->outCount) > NET_MAXOUT) {
+		// Data wrap around end of buffer.
+		iov[0].iov_len  = NET_MAXOUT - Socket->outHead;
+		iov[1].iov_base = Socket->outBuf;
+		iov[1].iov_len  = Socket->outCount - iov[0].iov_len;
+		nVecs = 2;
+	}
+
+#ifdef DEBUG
+	if (dbg_Check(DBG_SOCKETS)) {
+		sock_Dump(Socket->idSocket, iov[0].iov_base, iov[0].iov_len, "Output");
+		if (nVecs > 1)
+			sock_Dump(Socket->idSocket, iov[1].iov_base, iov[1].iov_len, "Output");
+	}
+#endif /* DEBUG */
+
+	if ((rc = writev(Socket->idSocket, iov, nVecs)) < 0) {
+		if ((errno == EAGAIN) || (errno == EINTR))
+			return;
+#ifdef DEBUG
+		if (dbg_Check(DBG_SOCKERR))
+			dbg_Printf("SCK: *** Error (writev): %s\n", strerror(errno));
+#endif /* DEBUG */
+		// Output is lost.
+		rc = Socket->outCount;
+	}
+	Socket->outHead   = (Socket->outHead + rc) & (NET_MAXOUT-1);
+	Socket->outCount -= rc;
+	if (Socket->outCount == 0)
+		Socket->outHead = 0;
+}
+
+// Write all pending output of all sockets.
+void sock_FlushAll(void)
+{
+	SOCKET **pSocket = &sockOutList;
+	SOCKET *Socket;
+
+	while (Socket = *pSocket) {
+		sock_Flush(Socket);
+		if (Socket->outCount == 0) {
+			*pSocket = Socket->outNext;
+			Socket->outNext = NULL;
+			Socket->Flags &= ~SCK_OUTPUT;
+		} else
+			pSocket = &Socket->outNext;
+	}
+}
+
+static void sock_OutFlush(void *dptr)
+{
+	sock_FlushAll();
+
+	// Try again later if any sockets are busy.
+	if (sockOutList)
+		ts10_SetTimer(&sockOutTimer);
+}
+
 // Process telnet codes and filter them out of data stream.
 int sock_ProcessTelnet(uchar *str, int len)
 {
@@ -54,6 +54,14 @@
 
 #define NET_MAXSOCKETS  256  // Maximum number of open sockets.
 #define NET_MAXBUF      2048  // Manimum number of bytes of buffer.
+#define NET_MAXOUT      4096  // Size of output buffer (power of two).
+#define NET_FLUSHTIME   10000 // Output flush interval (instructions).
+
+// Sockets are served by a separate I/O thread on Linux (epoll)
+// instead of SIGIO signal handler.  Define NO_EPOLL to use SIGIO.
+#if defined(linux) && !defined(NO_EPOLL)
+#define SOCK_EPOLL
+#endif /* linux && !NO_EPOLL */
 
 typedef struct sockaddr    SOCKADDR;
 typedef struct sockaddr_in SOCKADDRIN;
@@ -83,6 +91,13 @@ struct Socket {
 	SOCKADDRIN  locAddr;  // Local Internet Address/Port
 	SOCKADDRIN  remAddr;  // Remote Internet Address/Port
 	SOCKTYPE    *Type;    // Socket Type
+	int         ioSerial; // Serial number for I/O thread
+
+	// Output buffer (ring) for sock_Output
+	SOCKET      *outNext; // Next socket with pending output
+	char        *outBuf;  // Output buffer
+	int         outHead;  // Oldest character in buffer
+	int         outCount; // Number of characters in buffer
 
 	// User-defined variables;
 	void        *Device;  // User-defined Device
@@ -106,6 +121,7 @@ struct Socket {
 #define SCK_FILE      0x02000000 // Socket is file I/O
 #define SCK_PACKET    0x01000000 // Socket is packet type.
 #define SCK_OWNIO     0x00800000 // Own I/O process
+#define SCK_OUTPUT    0x00400000 // Output is pending in buffer
 
 // Socket mode defintions - Server, Client, or Connected.
 #define NET_SERVER   1 // Socket's Server role
@@ -155,11 +171,16 @@ int    sock_Listen(SOCKET *, int);
 SOCKET *sock_Accept(SOCKET *);
 int    sock_Send(int, char *, int);
 int    sock_Print(SOCKET *, char *, int);
+int    sock_Output(SOCKET *, char *, int);
+void   sock_Flush(SOCKET *);
+void   sock_FlushAll(void);
 void   SockGetEtherAddr(char *, uint8 *);
 int    SockSendPacket(SOCKET *, uint8 *, uint32);
 int    SockPrintf(SOCKET *, cchar *, ...);
 int    sock_ProcessTelnet(uchar *, int);
 void   SocketHandler(int);
+void   sock_Poll(void);
+void   sock_Wait(void);
 void   sock_ShowList(void);
 
 #endif /* _SOCKET_H */
@@ -35,6 +35,7 @@
 
 #include <sys/time.h>
 #include <signal.h>
+#include <poll.h>
 
 #include "emu/defs.h"
 
@@ -57,17 +58,213 @@ static struct itimerval stopTimer =
 static struct itimerval oldTimer;
 
 #define  NOQUEUE_WAIT 10000
+#define  CLK_MAXBATCH 10000 // Maximum batch length (interval counts)
+#define  CLK_HEAPSIZE 64
 
 uint32    ts10_GlobalTime  = 0;
 int32     ts10_ClkInterval = 0;
-int32     ts10_NoqueueTime = 0;
-CLK_QUEUE *ts10_SimClock   = NULL; // Simulation Clock Queue
+int32     ts10_ClkCut      = 0;    // Interval count set aside by batch cut
+int32     ts10_BatchCut    = 0;    // Current batch was cut short
+CLK_QUEUE *ts10_SimClock   = NULL; // Next Simulation Clock Entry
 CLK_QUEUE *ts10_RealClock  = NULL; // Real Clock Queue
 
-static __inline__ void UpdateTime(uint32 *tmr)
+// Requests from signal handlers.  Only signal side writes them.
+volatile sig_atomic_t ts10_AlarmTicks = 0; // Host timer ticks
+volatile sig_atomic_t ts10_AlarmCuts  = 0; // Batch cut requests
+
+static volatile sig_atomic_t inSignal = 0; // Running signal handlers
+static void (*alarmHandler)(int) = NULL;   // Alarm handler
+static sig_atomic_t tickDone = 0;          // Host timer ticks processed
+static sig_atomic_t cutDone  = 0;          // Batch cut requests processed
+
+// I/O Polls
+//
+// I/O threads never touch interval counts either.  They pass their
+// results through their own queues and call ts10_Wakeup, which marks
+// I/O pending and wakes idle processor.  Processor runs all poll
+// routines at next batch boundary, or at once if it was idle.
+
+#define CLK_MAXPOLL 8
+
+static void (*ioPoll[CLK_MAXPOLL])(void);
+static int  ioCount = 0;
+static volatile sig_atomic_t ioWake = 0; // I/O pending
+
+// Simulation Clock Queue
+//
+// Pending entries are kept in a binary heap ordered by due time
+// (in interval counts), so that setting a timer takes O(log n)
+// time and cancelling one takes O(log n) time through its heap
+// index instead of walking the whole queue.  Entries due at the
+// same time are executed in order of arrival.  ts10_SimClock
+// points to the earliest entry, or NULL if the queue is empty.
+
+static uint64    clkTime  = 0;    // Current simulation time
+static int32     clkLoad  = 0;    // Interval count loaded at last update
+static uint32    clkOrder = 0;    // Order of arrival for next entry
+static CLK_QUEUE **clkHeap = NULL; // Clock heap (earliest at top)
+static int32     clkCount = 0;    // Number of pending entries
+static int32     clkSize  = 0;    // Size of clock heap
+
+// Instruction Batches
+//
+// Processors run batches of instructions between timer events.
+// ts10_ClkInterval counts instructions left until next event, and
+// it is the only check done for each instruction.  Interrupt, trap
+// and trace requests call ts10_CutBatch to end current batch at
+// next instruction.  That sets aside remaining count so that the
+// processor enters ts10_ExecuteTimer at once and checks requests
+// there, and timer events still occur at the same time.
+//
+// Interval counts belong to processor thread only.  Signal handlers
+// never touch them.  Host timer ticks and batch cuts requested from
+// signal handlers are counted into ts10_AlarmTicks/ts10_AlarmCuts
+// instead, and processor folds them in at next batch boundary.
+// Batches are limited to CLK_MAXBATCH counts so that boundary
+// comes soon enough even if next event is far away.
+
+// Account interval counts executed since last update.
+static __inline__ void UpdateTime(void)
+{
+	int32 left = ts10_ClkInterval + ts10_ClkCut;
+
+	ts10_GlobalTime += (clkLoad - left);
+	clkTime         += (int64)(clkLoad - left);
+	clkLoad          = left;
+}
+
+// Load interval count for next event.
+static __inline__ void LoadTime(void)
+{
+	CLK_QUEUE *qptr;
+
+	if (clkCount > 0) {
+		qptr = clkHeap[0];
+		ts10_ClkInterval = (qptr->qDue > clkTime)
+			? (int32)(qptr->qDue - clkTime) : 0;
+		if (ts10_ClkInterval > CLK_MAXBATCH)
+			ts10_ClkInterval = CLK_MAXBATCH;
+		ts10_SimClock    = qptr;
+	} else {
+		ts10_ClkInterval = NOQUEUE_WAIT;
+		ts10_SimClock    = NULL;
+	}
+	clkLoad = ts10_ClkInterval;
+}
+
+// Return non-zero if entry A is due before entry B.
+static __inline__ int IsBefore(CLK_QUEUE *aptr, CLK_QUEUE *bptr)
+{
+	if (aptr->qDue != bptr->qDue)
+		return aptr->qDue < bptr->qDue;
+	return (int32)(aptr->qOrder - bptr->qOrder) < 0;
+}
+
+// Move entry up from that hole toward top of heap.
+static void SiftUp(int32 idx, CLK_QUEUE *qptr)
+{
+	CLK_QUEUE *pptr;
+	int32     up;
+
+	while (idx > 0) {
+		up   = (idx - 1) >> 1;
+		pptr = clkHeap[up];
+		if (!IsBefore(qptr, pptr))
+			break;
+		clkHeap[idx] = pptr;
+		pptr->qIndex = idx;
+		idx = up;
+	}
+	clkHeap[idx] = qptr;
+	qptr->qIndex = idx;
+}
+
+// Move entry down from that hole toward bottom of heap.
+static void SiftDown(int32 idx, CLK_QUEUE *qptr)
+{
+	int32 dn;
+
+	while ((dn = (idx << 1) + 1) < clkCount) {
+		if (((dn + 1) < clkCount) && IsBefore(clkHeap[dn + 1], clkHeap[dn]))
+			dn++;
+		if (!IsBefore(clkHeap[dn], qptr))
+			break;
+		clkHeap[idx] = clkHeap[dn];
+		clkHeap[idx]->qIndex = idx;
+		idx = dn;
+	}
+	clkHeap[idx] = qptr;
+	qptr->qIndex = idx;
+}
+
+static int InsertHeap(CLK_QUEUE *qptr)
 {
-	ts10_GlobalTime += (*tmr - ts10_ClkInterval);
-	*tmr = ts10_ClkInterval;
+	CLK_QUEUE **newHeap;
+	int32     newSize;
+
+	// Enlarge clock heap if full.
+	if (clkCount == clkSize) {
+		newSize = clkSize ? (clkSize << 1) : CLK_HEAPSIZE;
+		newHeap = (CLK_QUEUE **)realloc(clkHeap, newSize * sizeof(CLK_QUEUE *));
+		if (newHeap == NULL) {
+			printf("TIMER: Can't add entry '%s' - Not enough memory.\n",
+				qptr->Name ? qptr->Name : "(None)");
+			return EMU_MEMERR;
+		}
+		clkHeap = newHeap;
+		clkSize = newSize;
+	}
+
+	SiftUp(clkCount++, qptr);
+	return EMU_OK;
+}
+
+static void RemoveHeap(CLK_QUEUE *qptr)
+{
+	int32     idx  = qptr->qIndex;
+	CLK_QUEUE *lptr = clkHeap[--clkCount];
+
+	// Fill that hole with last entry.
+	clkHeap[clkCount] = NULL;
+	qptr->qIndex      = -1;
+	if (lptr != qptr) {
+		if ((idx > 0) && IsBefore(lptr, clkHeap[(idx - 1) >> 1]))
+			SiftUp(idx, lptr);
+		else
+			SiftDown(idx, lptr);
+	}
+}
+
+// Put count set aside by batch cut back into interval count.
+// Return non-zero if current batch was cut.
+static __inline__ int32 MergeBatch(void)
+{
+	int32 cut = ts10_BatchCut;
+
+	if (cut) {
+		ts10_ClkInterval += ts10_ClkCut;
+		ts10_ClkCut       = 0;
+		ts10_BatchCut     = 0;
+	}
+	return cut;
+}
+
+// End current batch of instructions after
+// current instruction has been completed.
+void ts10_CutBatch(void)
+{
+	// Called from signal handler - Processor
+	// picks it up at next batch boundary.
+	if (inSignal) {
+		ts10_AlarmCuts++;
+		return;
+	}
+
+	// Count is negative at batch boundary.  Keep that
+	// too so that current instruction is still counted.
+	ts10_ClkCut     += ts10_ClkInterval;
+	ts10_ClkInterval = 0;
+	ts10_BatchCut    = 1;
 }
 
 int ts10_StartTimer(void)
@@ -80,14 +277,36 @@ int ts10_StopTimer(void)
 	setitimer(ITIMER_REAL, &stopTimer, &oldTimer);
 }
 
+// Signal handlers run between these, so that any
+// ts10_CutBatch calls made by them are only posted
+// as requests.  Signal handlers may nest.
+void ts10_EnterSignal(void)
+{
+	inSignal++;
+}
+
+void ts10_LeaveSignal(void)
+{
+	inSignal--;
+}
+
+// SIGALRM handler.
+static void ts10_Alarm(int sig)
+{
+	ts10_EnterSignal();
+	alarmHandler(sig);
+	ts10_LeaveSignal();
+}
+
 int ts10_SetAlarm(void (*handler)(int))
 {
+	alarmHandler = handler;
 #ifdef HAVE_SIGACTION
-	sigTimer.sa_handler = handler;
+	sigTimer.sa_handler = ts10_Alarm;
 	sigTimer.sa_flags   = 0;
 	sigaction(SIGALRM, &sigTimer, NULL);
 #else
-	signal(SIGALRM, handler);
+	signal(SIGALRM, ts10_Alarm);
 #endif /* HAVE_SIGACTION */
 	return EMU_OK;
 }
@@ -117,7 +336,124 @@ void ts10_CancelRealTimer(CLK_QUEUE *qptr)
 	}
 }
 
+// Host Wakeup
+//
+// Idle processor sleeps on wakeup pipe until next host timer tick
+// or until any I/O thread has something for it.  Writing to pipe is
+// async-signal-safe, and wakeups sent before processor begins to
+// wait stay in pipe so that none of them can be lost.
+
+static int wakePipe[2] = { -1, -1 };
+
+int ts10_OpenWakeup(void)
+{
+	int idx;
+
+	if (wakePipe[0] >= 0)
+		return EMU_OK;
+	if (pipe(wakePipe) < 0) {
+		perror("TIMER: Can't open wakeup pipe");
+		return EMU_OPENERR;
+	}
+	for (idx = 0; idx < 2; idx++) {
+		fcntl(wakePipe[idx], F_SETFL, O_NONBLOCK);
+		fcntl(wakePipe[idx], F_SETFD, FD_CLOEXEC);
+	}
+	return EMU_OK;
+}
+
+// Wake up processor.  Called by signal handlers and I/O threads.
+void ts10_Wakeup(void)
+{
+	char one = 1;
+
+	// Make queued results visible first.
+	__sync_synchronize();
+	ioWake = 1;
+
+	// Pipe is full - wakeup is pending already.
+	if (wakePipe[1] >= 0)
+		write(wakePipe[1], &one, sizeof(one));
+}
+
+// Add poll routine for I/O thread results.
+int ts10_AddIOPoll(void (*poll)(void))
+{
+	int idx;
+
+	for (idx = 0; idx < ioCount; idx++)
+		if (ioPoll[idx] == poll)
+			return EMU_OK;
+	if (ioCount == CLK_MAXPOLL)
+		return EMU_MEMERR;
+	ioPoll[ioCount++] = poll;
+	ioWake = 1;
+	return EMU_OK;
+}
+
+void ts10_RemoveIOPoll(void (*poll)(void))
+{
+	int idx;
+
+	for (idx = 0; idx < ioCount; idx++)
+		if (ioPoll[idx] == poll) {
+			ioPoll[idx] = ioPoll[--ioCount];
+			return;
+		}
+}
+
+// Run all poll routines if any I/O thread woke processor up.
+static __inline__ void RunIOPoll(void)
+{
+	int idx;
+
+	if (ioWake && __sync_lock_test_and_set(&ioWake, 0)) {
+		for (idx = 0; idx < ioCount; idx++)
+			ioPoll[idx]();
+	}
+}
+
+// Wait up to 'msec' milliseconds (or forever if negative) for
+// wakeup or signal.  Return non-zero if woken up.
+int ts10_WaitWakeup(int msec)
+{
+	struct pollfd pfd;
+	char   buf[64];
+	int    rc;
+
+	if (wakePipe[0] < 0) {
+		if (msec < 0)
+			pause();
+		else
+			usleep(msec * 1000);
+		return 0;
+	}
+
+	pfd.fd      = wakePipe[0];
+	pfd.events  = POLLIN;
+	pfd.revents = 0;
+	rc = poll(&pfd, 1, msec);
+
+	// Clear all pending wakeups.
+	while (read(wakePipe[0], buf, sizeof(buf)) > 0)
+		continue;
+
+	return rc > 0;
+}
+
+// Host timer tick.  Called from alarm handler, so that
+// only count that tick and wake up processor.
 void ts10_TickRealTimer(int sig)
+{
+	ts10_AlarmTicks++;
+
+	// Wake up idle processor.
+	ts10_Wakeup();
+}
+
+// Execute real timer entries for one host timer tick.
+// Called by processor thread.
+static void RunRealTimer(void)
 {
 	CLK_QUEUE *qptr, *pptr;
 
@@ -142,6 +478,23 @@ void ts10_TickRealTimer(int sig)
 	}
 }
 
+// Fold in host timer ticks and batch cuts
+// requested by alarm handler since last batch.
+static __inline__ void FoldAlarm(void)
+{
+	sig_atomic_t ticks = ts10_AlarmTicks;
+	sig_atomic_t cuts  = ts10_AlarmCuts;
+
+	while (tickDone != ticks) {
+		tickDone++;
+		RunRealTimer();
+	}
+	if (cutDone != cuts) {
+		cutDone = cuts;
+		ts10_CutBatch();
+	}
+}
+
 //****************************************************************
 //****************************************************************
 //****************************************************************
@@ -149,10 +502,7 @@ void ts10_TickRealTimer(int sig)
 uint32 ts10_GetGlobalTime(void)
 {
 	// Update current global time.
-	if (ts10_SimClock)
-		UpdateTime(&ts10_SimClock->outTimer);
-	else
-		UpdateTime(&ts10_NoqueueTime);
+	UpdateTime();
 
 	// Return latest global time.
 	return ts10_GlobalTime;
@@ -160,16 +510,31 @@ uint32 ts10_GetGlobalTime(void)
 
 void ts10_InitTimer(void)
 {
+	int32 idx;
+
+	// Release all pending entries.
+	for (idx = 0; idx < clkCount; idx++) {
+		clkHeap[idx]->Flags  &= ~CLK_PENDING;
+		clkHeap[idx]->qIndex  = -1;
+		clkHeap[idx]          = NULL;
+	}
+	clkCount = 0;
+	clkOrder = 0;
+	clkTime  = 0;
+	clkLoad  = 0;
+
 	ts10_SimClock    = NULL;
 	ts10_GlobalTime  = 0;
 	ts10_ClkInterval = 0;
-	ts10_NoqueueTime = 0;
+	ts10_ClkCut      = 0;
+	ts10_BatchCut    = 0;
+	tickDone         = ts10_AlarmTicks;
+	cutDone          = ts10_AlarmCuts;
 }
 
 void ts10_SetTimer(CLK_QUEUE *qptr)
 {
-	CLK_QUEUE *cptr, *pptr = NULL;
-	int adjTimer = 0;
+	int cut;
 
 	// First, check if this unit already is activated.
 	if (qptr->Flags & CLK_PENDING) {
@@ -193,57 +558,34 @@ void ts10_SetTimer(CLK_QUEUE *qptr)
 		return;
 	}
 
-	if (ts10_ClkInterval < 0) {
-#ifdef DEBUG
-		dbg_Printf("TIMER: *** Negative Clock Interval: %d\n",
-			ts10_ClkInterval);
-#endif /* DEBUG */
-		ts10_ClkInterval = 0;
-	}
-
-	qptr->outTimer =  qptr->nxtTimer;
-	qptr->Flags    |= CLK_PENDING;
+	// Update current time and put that entry on the clock queue.
+	cut = MergeBatch();
+	UpdateTime();
 
-	if (ts10_SimClock == NULL) {
-		// Put that entry on the empty clock queue.
-		UpdateTime(&ts10_NoqueueTime);
-		qptr->Next    = NULL;
-		ts10_SimClock = qptr;
-	} else {
-		// Update first entry for latest interval count.
-		UpdateTime(&ts10_SimClock->outTimer);
-		ts10_SimClock->outTimer = ts10_ClkInterval;
-
-		// Find that entry between their timer by ascending.
-		for (cptr = ts10_SimClock; cptr; cptr = cptr->Next) {
-			if (qptr->outTimer < (cptr->outTimer + adjTimer))
-				break;
-			adjTimer += cptr->outTimer;
-			pptr = cptr;
-		}
-
-		// Insert that entry on elsewhere within the clock queue.
-		qptr->outTimer -= adjTimer;
-		if (cptr == ts10_SimClock) {
-			qptr->Next = ts10_SimClock;
-			ts10_SimClock = qptr;
-		} else {
-			qptr->Next =  pptr->Next;
-			pptr->Next =  qptr;
-		}
+	qptr->outTimer = qptr->nxtTimer;
+	qptr->qDue     = clkTime + qptr->nxtTimer;
+	qptr->qOrder   = clkOrder++;
+	if (InsertHeap(qptr) != EMU_OK) {
+		if (cut)
+			ts10_CutBatch();
+		return;
 	}
+	qptr->Flags |= CLK_PENDING;
 
-	// Set latest next interval count
-	ts10_ClkInterval = ts10_SimClock->outTimer;
+	// Set latest next interval count.  Sooner
+	// event ends current batch of instructions.
+	LoadTime();
+	if (cut)
+		ts10_CutBatch();
 
 #ifdef DEBUG
 	if (dbg_Check(DBG_TIMER)) {
 		CLK_QUEUE *nptr = ts10_SimClock;
 		dbg_Printf("TIMER: That Entry: %s  Interval Count: %d\n",
-			qptr->Name ? qptr->Name : "(None)", qptr->outTimer + adjTimer);
+			qptr->Name ? qptr->Name : "(None)", qptr->outTimer);
 		if (qptr != nptr) {
 			dbg_Printf("TIMER: Next Entry: %s  Interval Count: %d\n",
-				nptr->Name ? nptr->Name : "(None)", nptr->outTimer);
+				nptr->Name ? nptr->Name : "(None)", clkLoad);
 		}
 	}
 #endif /* DEBUG */
@@ -251,88 +593,96 @@ void ts10_SetTimer(CLK_QUEUE *qptr)
 
 void ts10_CancelTimer(CLK_QUEUE *qptr)
 {
-	CLK_QUEUE *cptr, *nptr = NULL;
+	int cut;
 
-	if (ts10_SimClock == NULL)
+	if ((qptr->Flags & CLK_PENDING) == 0)
 		return;
-	UpdateTime(&ts10_SimClock->outTimer);
+	cut = MergeBatch();
+	UpdateTime();
 
-	// Remove that entry from the timer queue.
-	if (ts10_SimClock == qptr) {
-		nptr = ts10_SimClock = qptr->Next;
-	} else {
-		for (cptr = ts10_SimClock; cptr; cptr = cptr->Next) {
-			if (cptr->Next == qptr) {
-				nptr = cptr->Next = qptr->Next;
-				break;
-			}
-		}
-	}
+	// Remove that entry from the clock queue.
+	RemoveHeap(qptr);
+	qptr->Flags &= ~CLK_PENDING;
+	qptr->Next   = NULL;
 
 	// Update timer alarm.
-	qptr->Flags &= ~CLK_PENDING;
-	if (nptr != NULL)
-		nptr->outTimer += qptr->outTimer;
+	LoadTime();
+	if (cut)
+		ts10_CutBatch();
+}
 
-//	ts10_ClkInterval = ts10_SimClock
-//		? ts10_SimClock->outTimer : NOQUEUE_WAIT;
-	if (ts10_SimClock) {
-		ts10_ClkInterval = ts10_SimClock->outTimer;
-	} else {
-		ts10_ClkInterval = NOQUEUE_WAIT;
-		ts10_NoqueueTime = NOQUEUE_WAIT;
-	}
+// Skip idle time forward to next timer event, and account
+// skipped interval count into global time.  Next countdown
+// check will execute that event.  Return number of counts
+// skipped.
+int32 ts10_SkipTimer(void)
+{
+	int32 skip;
+
+	MergeBatch();
+	UpdateTime();
+	if ((clkCount == 0) || (clkHeap[0]->qDue <= clkTime))
+		return 0;
 
-	qptr->Next = NULL;
+	skip = (int32)(clkHeap[0]->qDue - clkTime);
+	ts10_GlobalTime  += skip;
+	clkTime          += skip;
+	ts10_ClkInterval  = 0;
+	clkLoad           = 0;
+
+	return skip;
 }
 
 void ts10_ExecuteTimer(void)
 {
 	CLK_QUEUE *qptr;
 
-	if (ts10_SimClock == NULL) {
-		UpdateTime(&ts10_NoqueueTime);
-		ts10_NoqueueTime = NOQUEUE_WAIT;
-		ts10_ClkInterval = NOQUEUE_WAIT;
-	} else {
-//		do {
-			// Remove that entry from the queue.
-			qptr = ts10_SimClock;
-			ts10_SimClock = qptr->Next;
+	// Fold in requests from alarm handler.
+	FoldAlarm();
+
+	// Process results from I/O threads.
+	RunIOPoll();
+
+	// Batch was cut short for processor to check
+	// requests, timer event is not due yet.
+	if (MergeBatch() && (ts10_ClkInterval >= 0))
+		return;
+
+	// Batch was limited, timer event is not due yet.
+	UpdateTime();
+	if ((clkCount == 0) || (clkHeap[0]->qDue > clkTime)) {
+		LoadTime();
+		return;
+	}
+
+	// Remove earliest entry from the queue.
+	qptr = clkHeap[0];
+	RemoveHeap(qptr);
 
 #ifdef DEBUG
-			if (dbg_Check(DBG_TIMER)) {
-				CLK_QUEUE *nptr;
-				dbg_Printf("TIMER: Entry: %s - Now Executing.\n",
-					qptr->Name ? qptr->Name : "(None)");
-				if (nptr = qptr->Next) {
-					dbg_Printf("TIMER: Next Entry: %s  Interval Count: %d\n",
-						nptr->Name ? nptr->Name : "(None)", nptr->outTimer);
-				}
-			}
+	if (dbg_Check(DBG_TIMER)) {
+		dbg_Printf("TIMER: Entry: %s - Now Executing.\n",
+			qptr->Name ? qptr->Name : "(None)");
+		if (clkCount > 0) {
+			CLK_QUEUE *nptr = clkHeap[0];
+			dbg_Printf("TIMER: Next Entry: %s  Interval Count: %d\n",
+				nptr->Name ? nptr->Name : "(None)",
+				(nptr->qDue > clkTime) ? (int32)(nptr->qDue - clkTime) : 0);
+		}
+	}
 #endif /* DEBUG */
 
-			// Reset that entry or put it back to the queue.
-			qptr->Flags &= ~CLK_PENDING;
-			if (qptr->Flags & CLK_REACTIVE)
-				ts10_SetTimer(qptr);
-			else
-				qptr->Next = NULL;
-
-			// Update timer alarm.
-//			ts10_ClkInterval = ts10_SimClock
-//				? ts10_SimClock->outTimer : NOQUEUE_WAIT;
-			if (ts10_SimClock) {
-				ts10_ClkInterval = ts10_SimClock->outTimer;
-			} else {
-				ts10_ClkInterval = NOQUEUE_WAIT;
-				ts10_NoqueueTime = NOQUEUE_WAIT;
-			}
+	// Reset that entry or put it back to the queue.
+	qptr->Flags &= ~CLK_PENDING;
+	if (qptr->Flags & CLK_REACTIVE)
+		ts10_SetTimer(qptr);
+	else
+		qptr->Next = NULL;
 
-			// Now execute that entry.
-			if (qptr->Execute != NULL)
-				qptr->Execute(qptr->Device);
-//		} while (ts10_ClkInterval == 0);
-	}
-}
+	// Update timer alarm.
+	LoadTime();
 
+	// Now execute that entry.
+	if (qptr->Execute != NULL)
+		qptr->Execute(qptr->Device);
+}
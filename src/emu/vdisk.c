@@ -26,6 +26,8 @@
 
 #include "emu/defs.h"
 #include "emu/vdisk.h"
+#include "emu/pthread.h"
+#include <signal.h>
 
 // ********************************************************************
 
@@ -95,6 +97,761 @@ VDK_FORMAT vdk_Formats[] =
 
 // ********************************************************************
 
+// Copy-on-write Overlay
+//
+// Overlay file holds changed blocks for a read-only base image so
+// that many emulator instances can share one base image.  Overlay
+// file begins with a header (one 512-byte block), followed by an
+// allocation bitmap (one bit per block) and then block data.  Each
+// block has its own place within the data area, so that overlay
+// file is sparse on host file systems.  Header is made by 'overlay'
+// command with geometry left zero, and it is set by first open.
+
+#define OVL_MAGIC   "TS10OVL"
+#define OVL_VERSION 1
+#define OVL_HDRSZ   512
+
+typedef struct {
+	char   Magic[8];  // Magic ("TS10OVL")
+	uint32 Version;   // Format Version
+	uint32 szBlock;   // Physical Block Size
+	uint32 Blocks;    // Total Blocks
+	uint32 mapPos;    // Position of Allocation Bitmap
+	uint32 dataPos;   // Position of Block Data
+	char   baseName[OVL_HDRSZ - 28]; // Base Image Name
+} VDK_OVLHDR;
+
+#define OVL_TEST(vdk, blk) ((vdk)->ovlMap[(blk) >> 3] & (1u << ((blk) & 7)))
+#define OVL_SET(vdk, blk)  ((vdk)->ovlMap[(blk) >> 3] |= (1u << ((blk) & 7)))
+
+// Read data from file at that position.  Short reads are
+// finished by reading the rest again until end of file.
+// Return number of bytes read, or -1 with errno set.
+static ssize_t vdk_GetData(int fd, uint8 *data, uint32 szData, off_t pos)
+{
+	ssize_t rc, cnt = 0;
+
+	while (cnt < szData) {
+		if ((rc = pread(fd, data + cnt, szData - cnt, pos + cnt)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (rc == 0)
+			break;
+		cnt += rc;
+	}
+	return cnt;
+}
+
+// Same as above but into scatter/gather list.  Data beyond end
+// of file are zeros.  Return zero, otherwise return error code.
+static int vdk_GetVector(int fd, struct iovec *iov, int nVecs, off_t pos)
+{
+	struct iovec vec[nVecs];
+	ssize_t      rc;
+	int          idx = 0;
+
+	memcpy(vec, iov, nVecs * sizeof(struct iovec));
+	while (idx < nVecs) {
+		if ((rc = preadv(fd, &vec[idx], nVecs - idx, pos)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		if (rc == 0)
+			break;
+		pos += rc;
+
+		// Skip all vectors read, and rest of partial one.
+		while ((idx < nVecs) && (rc >= vec[idx].iov_len))
+			rc -= vec[idx++].iov_len;
+		if (idx < nVecs) {
+			vec[idx].iov_base  = (uint8 *)vec[idx].iov_base + rc;
+			vec[idx].iov_len  -= rc;
+		}
+	}
+
+	// End of file - zero the rest.
+	for (; idx < nVecs; idx++)
+		memset(vec[idx].iov_base, 0, vec[idx].iov_len);
+	return 0;
+}
+
+// Read blocks in disk format from image file (or base image).
+// Blocks beyond end of image file are zeros.  Image files are
+// locked by vdk->Lock, because cache write-backs for that disk
+// may come from I/O threads of other disks.
+static int vdk_ReadFile(VDK_DISK *vdk, uint32 dskAddr, uint8 *raw, uint32 nBlocks)
+{
+	uint32   szBlock = vdk->szBlock;
+	uint32   idx, cnt, szData;
+	off_t    pos;
+	VZP_FILE *zp;
+	int      inOvl, fd, rc;
+
+	pthread_mutex_lock(&vdk->Lock);
+	for (idx = 0; idx < nBlocks; idx += cnt) {
+		if (vdk->Flags & VDK_OVERLAY) {
+			// Find a run of blocks from same file.
+			inOvl = OVL_TEST(vdk, dskAddr + idx) != 0;
+			for (cnt = 1; (idx + cnt) < nBlocks; cnt++)
+				if ((OVL_TEST(vdk, dskAddr + idx + cnt) != 0) != inOvl)
+					break;
+			fd  = inOvl ? vdk->dpFile : vdk->dpBase;
+			zp  = inOvl ? NULL : vdk->zpBase;
+			pos = (off_t)(dskAddr + idx) * szBlock + (inOvl ? vdk->ovlData : 0);
+		} else {
+			cnt = nBlocks;
+			fd  = vdk->dpFile;
+			zp  = vdk->zpFile;
+			pos = (off_t)dskAddr * szBlock;
+		}
+
+		szData = cnt * szBlock;
+		if (zp)
+			rc = vzp_Read(zp, &raw[idx * szBlock], szData, pos);
+		else
+			rc = vdk_GetData(fd, &raw[idx * szBlock], szData, pos);
+		if (rc < 0) {
+			vdk->errCode = errno;
+			pthread_mutex_unlock(&vdk->Lock);
+			return VDK_IOERROR;
+		}
+		// Only end of file comes up short here.
+		if (rc < szData)
+			memset(&raw[(idx * szBlock) + rc], 0, szData - rc);
+	}
+	pthread_mutex_unlock(&vdk->Lock);
+
+	return VDK_OK;
+}
+
+// Write all data to file at that position.  Short writes are
+// finished by writing the rest again.  Return zero if all data
+// were written, otherwise return error code.
+static int vdk_PutData(int fd, uint8 *data, uint32 szData, off_t pos)
+{
+	ssize_t rc;
+
+	while (szData > 0) {
+		if ((rc = pwrite(fd, data, szData, pos)) <= 0) {
+			if ((rc < 0) && (errno == EINTR))
+				continue;
+			return (rc < 0) ? errno : ENOSPC;
+		}
+		data   += rc;
+		szData -= rc;
+		pos    += rc;
+	}
+	return 0;
+}
+
+// Same as above but from scatter/gather list.
+static int vdk_PutVector(int fd, struct iovec *iov, int nVecs, off_t pos)
+{
+	struct iovec vec[nVecs];
+	ssize_t      rc;
+	int          idx = 0;
+
+	memcpy(vec, iov, nVecs * sizeof(struct iovec));
+	while (idx < nVecs) {
+		if ((rc = pwritev(fd, &vec[idx], nVecs - idx, pos)) <= 0) {
+			if ((rc < 0) && (errno == EINTR))
+				continue;
+			return (rc < 0) ? errno : ENOSPC;
+		}
+		pos += rc;
+
+		// Skip all vectors written, and rest of partial one.
+		while ((idx < nVecs) && (rc >= vec[idx].iov_len))
+			rc -= vec[idx++].iov_len;
+		if (idx < nVecs) {
+			vec[idx].iov_base  = (uint8 *)vec[idx].iov_base + rc;
+			vec[idx].iov_len  -= rc;
+		}
+	}
+	return 0;
+}
+
+// Write blocks in disk format to image file (or overlay file).
+// Error code (errno) is returned in *errCode, which is not
+// vdk->errCode for write-backs from other threads.
+static int vdk_WriteFile(VDK_DISK *vdk, uint32 dskAddr, uint8 *raw, uint32 nBlocks,
+	int *errCode)
+{
+	uint32 szBlock = vdk->szBlock;
+	uint32 idx, first, last;
+	off_t  pos = (off_t)dskAddr * szBlock;
+	int    rc = 0;
+
+	if (vdk->Flags & VDK_OVERLAY)
+		pos += vdk->ovlData;
+
+	pthread_mutex_lock(&vdk->Lock);
+	if (vdk->zpFile) {
+		if (vzp_Write(vdk->zpFile, raw, nBlocks * szBlock, pos) < 0)
+			rc = errno;
+	} else
+		rc = vdk_PutData(vdk->dpFile, raw, nBlocks * szBlock, pos);
+
+	if ((rc == 0) && (vdk->Flags & VDK_OVERLAY)) {
+		// Mark those blocks as in overlay file
+		// and update allocation bitmap.
+		for (idx = 0; idx < nBlocks; idx++)
+			OVL_SET(vdk, dskAddr + idx);
+		first = dskAddr >> 3;
+		last  = (dskAddr + nBlocks - 1) >> 3;
+		rc = vdk_PutData(vdk->dpFile, &vdk->ovlMap[first], (last - first) + 1,
+			(off_t)vdk->ovlMapPos + first);
+	}
+	pthread_mutex_unlock(&vdk->Lock);
+
+	if (rc) {
+		*errCode = rc;
+		return VDK_IOERROR;
+	}
+	return VDK_OK;
+}
+
+// Check overlay header and load its allocation bitmap.
+static int vdk_OpenOverlay(VDK_DISK *vdk, VDK_OVLHDR *hdr)
+{
+	uint32 szMap;
+	int    rc;
+
+	if (hdr->Blocks == 0) {
+		// New overlay file - set its geometry now.
+		hdr->szBlock = vdk->szBlock;
+		hdr->Blocks  = vdk->Blocks;
+		hdr->mapPos  = OVL_HDRSZ;
+		hdr->dataPos = OVL_HDRSZ +
+			((((hdr->Blocks + 7) >> 3) + (OVL_HDRSZ - 1)) & ~(OVL_HDRSZ - 1));
+		if (pwrite(vdk->dpFile, hdr, OVL_HDRSZ, 0) != OVL_HDRSZ) {
+			vdk->errCode = errno;
+			return VDK_OPENERR;
+		}
+	} else if ((hdr->szBlock != vdk->szBlock) || (hdr->Blocks < vdk->Blocks)) {
+		// Overlay was made for another drive type.
+		vdk->errCode = EINVAL;
+		return VDK_OPENERR;
+	}
+
+	// Load allocation bitmap.
+	szMap = (hdr->Blocks + 7) >> 3;
+	if ((vdk->ovlMap = (uint8 *)malloc(szMap)) == NULL) {
+		vdk->errCode = ENOMEM;
+		return VDK_MEMERR;
+	}
+	if ((rc = pread(vdk->dpFile, vdk->ovlMap, szMap, hdr->mapPos)) < 0) {
+		vdk->errCode = errno;
+		return VDK_OPENERR;
+	}
+	if (rc < szMap)
+		memset(&vdk->ovlMap[rc], 0, szMap - rc);
+
+	vdk->ovlMapPos = hdr->mapPos;
+	vdk->ovlData   = hdr->dataPos;
+
+	return VDK_OK;
+}
+
+// Create an empty overlay file on that base image.
+int vdk_CreateOverlay(char *fileName, char *baseName)
+{
+	VDK_OVLHDR hdr;
+	int        fd;
+
+	if (strlen(baseName) >= sizeof(hdr.baseName))
+		return VDK_NONAME;
+	if (access(baseName, R_OK) < 0)
+		return VDK_OPENERR;
+	if ((fd = open(fileName, O_RDWR|O_CREAT|O_EXCL, 0700)) < 0)
+		return VDK_OPENERR;
+
+	memset(&hdr, 0, sizeof(hdr));
+	strcpy(hdr.Magic, OVL_MAGIC);
+	hdr.Version = OVL_VERSION;
+	strcpy(hdr.baseName, baseName);
+	if (write(fd, &hdr, OVL_HDRSZ) != OVL_HDRSZ) {
+		close(fd);
+		unlink(fileName);
+		return VDK_IOERROR;
+	}
+	close(fd);
+
+	return VDK_OK;
+}
+
+// Return size of disk image in bytes (base image for overlay).
+int32 vdk_GetImageSize(VDK_DISK *vdk)
+{
+	struct stat st;
+
+	if (vdk->zpBase)
+		return vzp_GetSize(vdk->zpBase);
+	if (vdk->zpFile)
+		return vzp_GetSize(vdk->zpFile);
+	if (fstat((vdk->Flags & VDK_OVERLAY) ? vdk->dpBase : vdk->dpFile, &st) < 0)
+		return -1;
+	return st.st_size;
+}
+
+// ********************************************************************
+
+// Block Cache
+//
+// Disk blocks (in disk format) are kept in one cache shared by
+// all open disk images and replaced by least recently used.  Size
+// of cache is set by 'set cache <size>' and it is off by default.
+// In write-through mode, blocks are written to the image file
+// and kept in the cache.  In write-back mode, dirty blocks are
+// written when they are replaced, when the image is closed, or
+// when the emulator exits.
+//
+// I/O threads share the cache with emulator thread.  vdk_CacheLock
+// is held only to look up or insert blocks, and image files are
+// read and written without it.  Dirty blocks being replaced are
+// moved to write-back queue, where readers still find them until
+// vdk_CacheWriteBack writes them.  vdk_BackLock keeps write-backs
+// in order of replacement.
+
+typedef struct vdk_CacheBlock VDK_CBLOCK;
+
+struct vdk_CacheBlock {
+	VDK_CBLOCK *hNext;   // Next block in hash chain (or write-back queue)
+	VDK_CBLOCK *lNext;   // Next block in LRU list (older)
+	VDK_CBLOCK *lPrev;   // Previous block in LRU list (newer)
+	VDK_DISK   *vdk;     // Disk image
+	uint32     dskAddr;  // Disk address in blocks
+	uint32     szBlock;  // Size of block data
+	int        Dirty;    // Not written to image file yet
+	uint8      Data[1];  // Block data (in disk format)
+};
+
+#define VDK_CBLKSZ(sz) (sizeof(VDK_CBLOCK) + (sz) - 1)
+
+static struct {
+	uint32     szCache;  // Size of cache (0 = off)
+	uint32     szUsed;   // Size used by cached blocks
+	int        Mode;     // Write mode
+	uint32     nHash;    // Number of hash chains (power of 2)
+	VDK_CBLOCK **Hash;   // Hash chains
+	VDK_CBLOCK *lHead;   // Most recently used block
+	VDK_CBLOCK *lTail;   // Least recently used block
+	uint32     nBlocks;  // Number of cached blocks
+	VDK_CBLOCK *wbHead;  // Write-back queue (oldest first)
+	VDK_CBLOCK *wbTail;
+
+	// Statistics
+	uint32     nHits;    // Cache hits
+	uint32     nMisses;  // Cache misses
+	uint32     nWrites;  // Blocks written by emulator
+	uint32     nBacks;   // Dirty blocks written back
+	uint32     nBackErrs; // Write-back errors
+	uint32     nEvicts;  // Blocks replaced
+} vdk_Cache;
+
+static pthread_mutex_t vdk_CacheLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t vdk_BackLock  = PTHREAD_MUTEX_INITIALIZER;
+
+static __inline__ uint32 vdk_CacheHash(VDK_DISK *vdk, uint32 dskAddr)
+{
+	return ((((uint32)(long)vdk >> 4) ^ dskAddr) * 2654435761U) &
+		(vdk_Cache.nHash - 1);
+}
+
+static VDK_CBLOCK *vdk_CacheLookup(VDK_DISK *vdk, uint32 dskAddr)
+{
+	VDK_CBLOCK *cb;
+
+	for (cb = vdk_Cache.Hash[vdk_CacheHash(vdk, dskAddr)]; cb; cb = cb->hNext)
+		if ((cb->vdk == vdk) && (cb->dskAddr == dskAddr))
+			return cb;
+	return NULL;
+}
+
+// Find latest copy of that block in write-back queue.
+static VDK_CBLOCK *vdk_CachePending(VDK_DISK *vdk, uint32 dskAddr)
+{
+	VDK_CBLOCK *cb, *last = NULL;
+
+	for (cb = vdk_Cache.wbHead; cb; cb = cb->hNext)
+		if ((cb->vdk == vdk) && (cb->dskAddr == dskAddr))
+			last = cb;
+	return last;
+}
+
+// Put that block at the end of write-back queue.
+static void vdk_CacheQueue(VDK_CBLOCK *cb)
+{
+	cb->hNext = NULL;
+	if (vdk_Cache.wbTail)
+		vdk_Cache.wbTail->hNext = cb;
+	else
+		vdk_Cache.wbHead = cb;
+	vdk_Cache.wbTail = cb;
+}
+
+// Move that block to the front of LRU list.
+static void vdk_CacheTouch(VDK_CBLOCK *cb)
+{
+	if (vdk_Cache.lHead == cb)
+		return;
+
+	// Unlink it first.
+	cb->lPrev->lNext = cb->lNext;
+	if (cb->lNext)
+		cb->lNext->lPrev = cb->lPrev;
+	else
+		vdk_Cache.lTail = cb->lPrev;
+
+	// Put it at the front.
+	cb->lPrev = NULL;
+	cb->lNext = vdk_Cache.lHead;
+	vdk_Cache.lHead->lPrev = cb;
+	vdk_Cache.lHead = cb;
+}
+
+// Write all queued blocks back to their image files.  Called
+// without vdk_CacheLock held.  Blocks stay in the queue until
+// written, and nobody else changes them meanwhile.  A failed
+// block is reported now and its disk keeps the error until
+// vdk_FlushCache or vdk_CloseDisk returns it.
+static int vdk_CacheWriteBack(void)
+{
+	VDK_CBLOCK *cb;
+	int        rc = VDK_OK, err;
+
+	pthread_mutex_lock(&vdk_BackLock);
+	for (;;) {
+		pthread_mutex_lock(&vdk_CacheLock);
+		cb = vdk_Cache.wbHead;
+		pthread_mutex_unlock(&vdk_CacheLock);
+		if (cb == NULL)
+			break;
+
+		err = 0;
+		if (vdk_WriteFile(cb->vdk, cb->dskAddr, cb->Data, 1, &err)) {
+			printf("VDK: Write-back error on %s block %d: %s\n",
+				cb->vdk->fileName, cb->dskAddr, strerror(err));
+			cb->vdk->wbError = err;
+			rc = VDK_IOERROR;
+		}
+
+		// Written - readers may use image file now.
+		pthread_mutex_lock(&vdk_CacheLock);
+		if ((vdk_Cache.wbHead = cb->hNext) == NULL)
+			vdk_Cache.wbTail = NULL;
+		if (err)
+			vdk_Cache.nBackErrs++;
+		else
+			vdk_Cache.nBacks++;
+		pthread_mutex_unlock(&vdk_CacheLock);
+		free(cb);
+	}
+	pthread_mutex_unlock(&vdk_BackLock);
+
+	return rc;
+}
+
+// Remove that block from the cache.  Free it, or queue it
+// for write-back if it is dirty.
+static void vdk_CacheRemove(VDK_CBLOCK *cb)
+{
+	VDK_CBLOCK **pcb;
+
+	// Unlink it from its hash chain.
+	for (pcb = &vdk_Cache.Hash[vdk_CacheHash(cb->vdk, cb->dskAddr)];
+	     *pcb != cb; pcb = &(*pcb)->hNext);
+	*pcb = cb->hNext;
+
+	// Unlink it from LRU list.
+	if (cb->lPrev)
+		cb->lPrev->lNext = cb->lNext;
+	else
+		vdk_Cache.lHead = cb->lNext;
+	if (cb->lNext)
+		cb->lNext->lPrev = cb->lPrev;
+	else
+		vdk_Cache.lTail = cb->lPrev;
+
+	vdk_Cache.szUsed -= cb->szBlock;
+	vdk_Cache.nBlocks--;
+	if (cb->Dirty)
+		vdk_CacheQueue(cb);
+	else
+		free(cb);
+}
+
+// Put that block data into the cache.  Return non-zero
+// if it can't be cached.
+static int vdk_CacheInsert(VDK_DISK *vdk, uint32 dskAddr, uint8 *data, int dirty)
+{
+	VDK_CBLOCK *cb;
+	uint32     hash;
+
+	if (cb = vdk_CacheLookup(vdk, dskAddr)) {
+		// Already cached - update it.
+		memcpy(cb->Data, data, cb->szBlock);
+		cb->Dirty = dirty;
+		vdk_CacheTouch(cb);
+		return VDK_OK;
+	}
+
+	// Replace least recently used blocks to make room.
+	if (vdk->szBlock > vdk_Cache.szCache)
+		return VDK_MEMERR;
+	while ((vdk_Cache.szUsed + vdk->szBlock) > vdk_Cache.szCache) {
+		vdk_CacheRemove(vdk_Cache.lTail);
+		vdk_Cache.nEvicts++;
+	}
+
+	if ((cb = (VDK_CBLOCK *)malloc(VDK_CBLKSZ(vdk->szBlock))) == NULL)
+		return VDK_MEMERR;
+	cb->vdk     = vdk;
+	cb->dskAddr = dskAddr;
+	cb->szBlock = vdk->szBlock;
+	cb->Dirty   = dirty;
+	memcpy(cb->Data, data, cb->szBlock);
+
+	// Link it into hash chain and LRU list.
+	hash = vdk_CacheHash(vdk, dskAddr);
+	cb->hNext = vdk_Cache.Hash[hash];
+	vdk_Cache.Hash[hash] = cb;
+	cb->lPrev = NULL;
+	if (cb->lNext = vdk_Cache.lHead)
+		vdk_Cache.lHead->lPrev = cb;
+	else
+		vdk_Cache.lTail = cb;
+	vdk_Cache.lHead = cb;
+
+	vdk_Cache.szUsed += cb->szBlock;
+	vdk_Cache.nBlocks++;
+
+	return VDK_OK;
+}
+
+// Write back queued blocks, and return VDK_IOERROR if any
+// write-back for that disk image (or this one if NULL) failed.
+static int vdk_CacheWriteError(VDK_DISK *vdk)
+{
+	int rc = vdk_CacheWriteBack();
+
+	if (vdk == NULL)
+		return rc;
+
+	pthread_mutex_lock(&vdk_BackLock);
+	if (rc = vdk->wbError ? VDK_IOERROR : VDK_OK) {
+		vdk->errCode = vdk->wbError;
+		vdk->wbError = 0;
+	}
+	pthread_mutex_unlock(&vdk_BackLock);
+
+	return rc;
+}
+
+// Write all dirty blocks for that disk image back (or all
+// disk images if NULL).
+int vdk_FlushCache(VDK_DISK *vdk)
+{
+	VDK_CBLOCK *cb, *nb, *wb;
+
+	pthread_mutex_lock(&vdk_CacheLock);
+	for (cb = vdk_Cache.lHead; cb; cb = nb) {
+		nb = cb->lNext;
+		if ((cb->Dirty == 0) || ((vdk != NULL) && (cb->vdk != vdk)))
+			continue;
+
+		// Queue a copy and keep that block cached.
+		if (wb = (VDK_CBLOCK *)malloc(VDK_CBLKSZ(cb->szBlock))) {
+			memcpy(wb, cb, VDK_CBLKSZ(cb->szBlock));
+			cb->Dirty = 0;
+			vdk_CacheQueue(wb);
+		} else
+			vdk_CacheRemove(cb);
+	}
+	pthread_mutex_unlock(&vdk_CacheLock);
+
+	return vdk_CacheWriteError(vdk);
+}
+
+// Remove all blocks for that disk image (or all disk images
+// if NULL) from the cache.
+static int vdk_PurgeCache(VDK_DISK *vdk)
+{
+	VDK_CBLOCK *cb, *nb;
+
+	pthread_mutex_lock(&vdk_CacheLock);
+	for (cb = vdk_Cache.lHead; cb; cb = nb) {
+		nb = cb->lNext;
+		if ((vdk == NULL) || (cb->vdk == vdk))
+			vdk_CacheRemove(cb);
+	}
+	pthread_mutex_unlock(&vdk_CacheLock);
+
+	return vdk_CacheWriteError(vdk);
+}
+
+// Set size of cache in bytes (0 = off) and write mode.
+int vdk_SetCache(uint64 szCache, int mode)
+{
+	VDK_CBLOCK **newHash;
+	uint32     nHash;
+
+	if (szCache > VDK_MAXCACHE)
+		return VDK_MEMERR;
+
+	// Write back all dirty blocks and empty the cache.
+	if (vdk_Cache.Hash)
+		vdk_PurgeCache(NULL);
+
+	// One hash chain per two 512-byte blocks.
+	for (nHash = 256; (nHash << 10) < szCache; nHash <<= 1);
+
+	pthread_mutex_lock(&vdk_CacheLock);
+	if (szCache && (nHash != vdk_Cache.nHash)) {
+		if ((newHash = (VDK_CBLOCK **)calloc(nHash, sizeof(VDK_CBLOCK *))) == NULL) {
+			pthread_mutex_unlock(&vdk_CacheLock);
+			return VDK_MEMERR;
+		}
+		if (vdk_Cache.Hash)
+			free(vdk_Cache.Hash);
+		vdk_Cache.Hash  = newHash;
+		vdk_Cache.nHash = nHash;
+	} else if (szCache == 0) {
+		if (vdk_Cache.Hash)
+			free(vdk_Cache.Hash);
+		vdk_Cache.Hash  = NULL;
+		vdk_Cache.nHash = 0;
+	}
+
+	vdk_Cache.szCache = szCache;
+	vdk_Cache.Mode    = mode;
+	vdk_Cache.nHits   = 0;
+	vdk_Cache.nMisses = 0;
+	vdk_Cache.nWrites = 0;
+	vdk_Cache.nBacks  = 0;
+	vdk_Cache.nBackErrs = 0;
+	vdk_Cache.nEvicts = 0;
+	pthread_mutex_unlock(&vdk_CacheLock);
+
+	return VDK_OK;
+}
+
+// Read blocks in disk format through the cache.
+static int vdk_ReadRaw(VDK_DISK *vdk, uint32 dskAddr, uint8 *raw, uint32 nBlocks)
+{
+	VDK_CBLOCK *cb;
+	uint32     szBlock = vdk->szBlock;
+	uint32     idx, cnt, blk;
+	int        rc, back;
+
+	if (vdk_Cache.szCache == 0)
+		return vdk_ReadFile(vdk, dskAddr, raw, nBlocks);
+
+	pthread_mutex_lock(&vdk_CacheLock);
+	for (idx = 0, rc = VDK_OK; idx < nBlocks; idx += cnt) {
+		cnt = 1;
+		if (cb = vdk_CacheLookup(vdk, dskAddr + idx)) {
+			memcpy(&raw[idx * szBlock], cb->Data, szBlock);
+			vdk_CacheTouch(cb);
+			vdk_Cache.nHits++;
+			continue;
+		}
+		if (cb = vdk_CachePending(vdk, dskAddr + idx)) {
+			memcpy(&raw[idx * szBlock], cb->Data, szBlock);
+			vdk_Cache.nHits++;
+			continue;
+		}
+
+		// Read a run of missing blocks at once.
+		for (; (idx + cnt) < nBlocks; cnt++)
+			if (vdk_CacheLookup(vdk, dskAddr + idx + cnt) ||
+			    vdk_CachePending(vdk, dskAddr + idx + cnt))
+				break;
+		pthread_mutex_unlock(&vdk_CacheLock);
+		rc = vdk_ReadFile(vdk, dskAddr + idx, &raw[idx * szBlock], cnt);
+		pthread_mutex_lock(&vdk_CacheLock);
+		if (rc)
+			break;
+
+		vdk_Cache.nMisses += cnt;
+		for (blk = 0; blk < cnt; blk++) {
+			// Cached while being read - that one is newer.
+			if (cb = vdk_CacheLookup(vdk, dskAddr + idx + blk))
+				memcpy(&raw[(idx + blk) * szBlock], cb->Data, szBlock);
+			else
+				vdk_CacheInsert(vdk, dskAddr + idx + blk,
+					&raw[(idx + blk) * szBlock], 0);
+		}
+	}
+	back = (vdk_Cache.wbHead != NULL);
+	pthread_mutex_unlock(&vdk_CacheLock);
+
+	// Evicted blocks may belong to other disks, so a failed
+	// write-back is not an error for this read.
+	if (back)
+		vdk_CacheWriteBack();
+
+	return rc;
+}
+
+// Write blocks in disk format through the cache.
+static int vdk_WriteRaw(VDK_DISK *vdk, uint32 dskAddr, uint8 *raw, uint32 nBlocks)
+{
+	uint32 szBlock = vdk->szBlock;
+	uint32 idx;
+	VDK_CBLOCK *cb;
+	int    rc, back;
+
+	if (vdk_Cache.szCache == 0)
+		return vdk_WriteFile(vdk, dskAddr, raw, nBlocks, &vdk->errCode);
+
+	// Write through - update cache only with what reached the
+	// image file.  On error, drop cached copies of those blocks.
+	if (vdk_Cache.Mode != VDK_WRBACK) {
+		rc = vdk_WriteFile(vdk, dskAddr, raw, nBlocks, &vdk->errCode);
+
+		pthread_mutex_lock(&vdk_CacheLock);
+		vdk_Cache.nWrites += nBlocks;
+		for (idx = 0; idx < nBlocks; idx++) {
+			if (rc == VDK_OK)
+				vdk_CacheInsert(vdk, dskAddr + idx, &raw[idx * szBlock], 0);
+			else if (cb = vdk_CacheLookup(vdk, dskAddr + idx))
+				vdk_CacheRemove(cb);
+		}
+		back = (vdk_Cache.wbHead != NULL);
+		pthread_mutex_unlock(&vdk_CacheLock);
+
+		if (back)
+			vdk_CacheWriteBack();
+
+		return rc;
+	}
+
+	pthread_mutex_lock(&vdk_CacheLock);
+	vdk_Cache.nWrites += nBlocks;
+	for (idx = 0, rc = VDK_OK; idx < nBlocks; idx++)
+		if (vdk_CacheInsert(vdk, dskAddr + idx, &raw[idx * szBlock], 1))
+			rc = VDK_MEMERR;
+	back = (vdk_Cache.wbHead != NULL);
+	pthread_mutex_unlock(&vdk_CacheLock);
+
+	// Older copies must reach image file first.  Failed blocks
+	// are reported to their own disks at flush or close.
+	if (back)
+		vdk_CacheWriteBack();
+
+	// Write blocks that can't be cached now.
+	if (rc)
+		rc = vdk_WriteFile(vdk, dskAddr, raw, nBlocks, &vdk->errCode);
+
+	return rc;
+}
+
+// ********************************************************************
+
 VDK_FORMAT *vdk_GetFormat(char *fmtName)
 {
 	int idx;
@@ -111,18 +868,72 @@ VDK_FORMAT *vdk_GetFormat(char *fmtName)
 int vdk_OpenDisk(VDK_DISK *vdk)
 {
 	VDK_FORMAT *fmt;
-	int        umode;
+	VDK_OVLHDR hdr;
+	VZP_FILE   *zp;
+	int        umode, rc;
 
 	// Check any errors first.
 	if (vdk == NULL)
 		return VDK_NODESC;
 	if (vdk->fileName == NULL)
 		return VDK_NONAME;
+	pthread_mutex_init(&vdk->Lock, NULL);
+
+	// Attempt to open a disk file.
+	umode = (vdk->Flags & VDK_WRLOCK) ? O_RDONLY : O_RDWR|O_CREAT;
+	if ((vdk->dpFile = open(vdk->fileName, umode, 0700)) < 0) {
+		vdk->errCode = errno;
+		return VDK_OPENERR;
+	}
+
+	// Check if that is an overlay file.
+	vdk->baseName = NULL;
+	vdk->ovlMap   = NULL;
+	vdk->dpBase   = -1;
+	vdk->zpFile   = NULL;
+	vdk->zpBase   = NULL;
+	if ((pread(vdk->dpFile, &hdr, OVL_HDRSZ, 0) == OVL_HDRSZ) &&
+	    !strcmp(hdr.Magic, OVL_MAGIC) && (hdr.Version == OVL_VERSION)) {
+		hdr.baseName[sizeof(hdr.baseName) - 1] = '\0';
+		if ((vdk->baseName = (char *)malloc(strlen(hdr.baseName)+1)) == NULL) {
+			vdk_CloseDisk(vdk);
+			return VDK_MEMERR;
+		}
+		strcpy(vdk->baseName, hdr.baseName);
+
+		// Open base image for read only.
+		if ((vdk->dpBase = open(vdk->baseName, O_RDONLY)) < 0) {
+			vdk->errCode = errno;
+			vdk_CloseDisk(vdk);
+			return VDK_OPENERR;
+		}
+		vdk->Flags |= VDK_OVERLAY;
+		rc = vzp_Open(vdk->dpBase, VZP_RDONLY, &vdk->zpBase);
+	} else
+		rc = vzp_Open(vdk->dpFile, (vdk->Flags & VDK_WRLOCK) ?
+			VZP_RDONLY : VZP_RDWR, &vdk->zpFile);
+
+	// Check if (base) image is a compressed container.
+	if (rc) {
+		vdk->errCode = rc;
+		vdk_CloseDisk(vdk);
+		return VDK_OPENERR;
+	}
+	if (vdk->zpFile)
+		vdk->Flags |= VDK_COMPRESS;
+
+	// Get format from compressed container or
+	// from extension of (base) image name.
 	if (vdk->fmtName == NULL) {
-		char *p = strrchr(vdk->fileName, '.');
-		if (p == NULL)
+		char *p = strrchr(vdk->baseName ? vdk->baseName : vdk->fileName, '.');
+		zp = vdk->zpBase ? vdk->zpBase : vdk->zpFile;
+		if (zp && *vzp_GetFormat(zp))
+			vdk->fmtName = vzp_GetFormat(zp);
+		else if (p == NULL) {
+			vdk_CloseDisk(vdk);
 			return VDK_NOFMT;
-		vdk->fmtName = p + 1;
+		} else
+			vdk->fmtName = p + 1;
 	}
 
 	// Set up format conversion for 18-bit words if request.
@@ -137,11 +948,9 @@ int vdk_OpenDisk(VDK_DISK *vdk)
 	vdk->Blocks  = vdk->Cylinders * vdk->Tracks * vdk->Sectors;
 	vdk->szImage = vdk->Blocks * vdk->szBlock;
 
-	// Attempt to open a disk file.
-	umode = (vdk->Flags & VDK_WRLOCK) ? O_RDONLY : O_RDWR|O_CREAT;
-	if ((vdk->dpFile = open(vdk->fileName, umode, 0700)) < 0) {
-		vdk->errCode = errno;
-		return VDK_OPENERR;
+	if (vdk->baseName && (rc = vdk_OpenOverlay(vdk, &hdr))) {
+		vdk_CloseDisk(vdk);
+		return rc;
 	}
 	vdk->Flags |= VDK_OPENED;
 	
@@ -150,63 +959,97 @@ int vdk_OpenDisk(VDK_DISK *vdk)
 
 int vdk_CloseDisk(VDK_DISK *vdk)
 {
+	VZP_FILE *zp;
+	int      rc = VDK_OK;
+
 	if (vdk == NULL)
 		return VDK_NODESC;
 
+	// Write back and remove its cached blocks.
+	if (vdk_Cache.Hash && vdk_PurgeCache(vdk))
+		rc = VDK_IOERROR;
+
+	// Write back and release compressed containers.
+	// Format name may come from container.
+	if (zp = vdk->zpFile ? vdk->zpFile : vdk->zpBase) {
+		if (vdk->fmtName == vzp_GetFormat(zp))
+			vdk->fmtName = NULL;
+		if (vzp_Close(zp))
+			rc = VDK_IOERROR, vdk->errCode = errno;
+	}
+	vdk->zpFile = NULL;
+	vdk->zpBase = NULL;
+
 	close(vdk->dpFile);
-	vdk->Flags  &= ~VDK_OPENED;
 	vdk->dpFile  = 0;
 
-	return VDK_OK;
+	// Release overlay resources.
+	if (vdk->Flags & VDK_OVERLAY)
+		close(vdk->dpBase);
+	vdk->Flags  &= ~(VDK_OPENED|VDK_OVERLAY|VDK_COMPRESS);
+	vdk->dpBase  = -1;
+	if (vdk->ovlMap)
+		free(vdk->ovlMap);
+	vdk->ovlMap = NULL;
+	if (vdk->baseName) {
+		// Format name may come from base image name.
+		if ((vdk->fmtName >= vdk->baseName) &&
+		    (vdk->fmtName < (vdk->baseName + strlen(vdk->baseName) + 1)))
+			vdk->fmtName = NULL;
+		free(vdk->baseName);
+	}
+	vdk->baseName = NULL;
+
+	return rc;
 }
 
 int vdk_SeekDisk(VDK_DISK *vdk, uint32 dskAddr)
 {
-	int32 pos;
-
 	if (vdk == NULL)
 		return VDK_NODESC;
 	if (dskAddr >= vdk->Blocks)
 		return VDK_ADRERR;
 
-	if ((pos = lseek(vdk->dpFile, dskAddr * vdk->szBlock, SEEK_SET)) < 0) {
-		vdk->errCode = errno;
-		return VDK_IOERROR;
-	} else {
-		vdk->dskAddr = pos / vdk->szBlock;
-	}
+	// Positional I/O is used for transfers, so only
+	// current disk address is needed to be set here.
+	vdk->dskAddr = dskAddr;
 
 	return VDK_OK;
 }
 
-int vdk_ReadDisk(VDK_DISK *vdk, uint8 *data, uint32 mode)
+// Read contiguous blocks from disk address at once.  For 18-bit
+// transfers, whole buffer is converted from disk format at once.
+int vdk_ReadBlocks(VDK_DISK *vdk, uint32 dskAddr, uint8 *data,
+	uint32 nBlocks, uint32 mode)
 {
 	int rc;
 
 	if (vdk == NULL)
 		return VDK_NODESC;
+	if ((dskAddr >= vdk->Blocks) || (nBlocks > (vdk->Blocks - dskAddr)))
+		return VDK_ADRERR;
+
 	if (vdk->Flags & (mode & VDK_18B)) {
-		uint8 fmt[vdk->szBlock];
+		uint8 fmt[vdk->szBlock * nBlocks];
 		VDK_FORMAT *cvt;
 
-		if ((rc = read(vdk->dpFile, fmt, vdk->szBlock)) == vdk->szBlock) {
-			vdk->dskAddr++;
-			if (cvt = vdk->Format)
-				cvt->From(fmt, (uint18 *)data, 256);
-		}
+		if (rc = vdk_ReadRaw(vdk, dskAddr, fmt, nBlocks))
+			return rc;
+		if (cvt = vdk->Format)
+			cvt->From(fmt, (uint18 *)data, nBlocks * 256);
 	} else {
-		rc = read(vdk->dpFile, data, 512);
-	}
-
-	if (rc < 0) {
-		vdk->errCode = errno;
-		return VDK_IOERROR;
+		if (rc = vdk_ReadRaw(vdk, dskAddr, data, nBlocks))
+			return rc;
 	}
+	vdk->dskAddr = dskAddr + nBlocks;
 
 	return VDK_OK;
 }
 
-int vdk_WriteDisk(VDK_DISK *vdk, uint8 *data, uint32 mode)
+// Write contiguous blocks to disk address at once.  For 18-bit
+// transfers, whole buffer is converted to disk format at once.
+int vdk_WriteBlocks(VDK_DISK *vdk, uint32 dskAddr, uint8 *data,
+	uint32 nBlocks, uint32 mode)
 {
 	int rc;
 
@@ -214,29 +1057,415 @@ int vdk_WriteDisk(VDK_DISK *vdk, uint8 *data, uint32 mode)
 		return VDK_NODESC;
 	if (vdk->Flags & VDK_WRLOCK)
 		return VDK_WRPROT;
+	if ((dskAddr >= vdk->Blocks) || (nBlocks > (vdk->Blocks - dskAddr)))
+		return VDK_ADRERR;
 
 	if (vdk->Flags & (mode & VDK_18B)) {
-		uint8 fmt[vdk->szBlock];
+		uint8 fmt[vdk->szBlock * nBlocks];
 		VDK_FORMAT *cvt;
 
 		if (cvt = vdk->Format)
-			cvt->To((uint18 *)data, 256, fmt);
-		if ((rc = write(vdk->dpFile, fmt, vdk->szBlock)) == vdk->szBlock)
-			vdk->dskAddr++;
+			cvt->To((uint18 *)data, nBlocks * 256, fmt);
+		if (rc = vdk_WriteRaw(vdk, dskAddr, fmt, nBlocks))
+			return rc;
 	} else {
-		rc = write(vdk->dpFile, data, 512);
+		if (rc = vdk_WriteRaw(vdk, dskAddr, data, nBlocks))
+			return rc;
 	}
+	vdk->dskAddr = dskAddr + nBlocks;
 
-	if (rc < 0) {
-		vdk->errCode = errno;
-		return VDK_IOERROR;
+	return VDK_OK;
+}
+
+// Copy data between buffer and scatter/gather list.
+static void vdk_CopyVector(uint8 *data, struct iovec *iov, int nVecs,
+	uint32 szData, int toVec)
+{
+	uint32 cnt;
+	int    idx;
+
+	for (idx = 0; (idx < nVecs) && szData; idx++) {
+		cnt = (iov[idx].iov_len < szData) ? iov[idx].iov_len : szData;
+		if (toVec)
+			memcpy(iov[idx].iov_base, data, cnt);
+		else
+			memcpy(data, iov[idx].iov_base, cnt);
+		data   += cnt;
+		szData -= cnt;
+	}
+}
+
+// Read contiguous blocks (in disk format) into scatter/gather list,
+// so that devices can transfer data directly to emulated memory.
+// Whole list must be as long as that blocks.  Without cache and
+// overlay, data are read directly from image file.
+int vdk_ReadVector(VDK_DISK *vdk, uint32 dskAddr, struct iovec *iov,
+	int nVecs, uint32 nBlocks)
+{
+	uint32 szData;
+	uint8  *raw;
+	int    rc;
+
+	if (vdk == NULL)
+		return VDK_NODESC;
+	if ((dskAddr >= vdk->Blocks) || (nBlocks > (vdk->Blocks - dskAddr)))
+		return VDK_ADRERR;
+	szData = nBlocks * vdk->szBlock;
+
+	if ((vdk_Cache.szCache == 0) && !(vdk->Flags & (VDK_OVERLAY|VDK_COMPRESS))) {
+		if (rc = vdk_GetVector(vdk->dpFile, iov, nVecs, (off_t)dskAddr * vdk->szBlock)) {
+			vdk->errCode = rc;
+			return VDK_IOERROR;
+		}
+	} else {
+		if ((raw = (uint8 *)malloc(szData)) == NULL) {
+			vdk->errCode = ENOMEM;
+			return VDK_MEMERR;
+		}
+		if ((rc = vdk_ReadRaw(vdk, dskAddr, raw, nBlocks)) == VDK_OK)
+			vdk_CopyVector(raw, iov, nVecs, szData, 1);
+		free(raw);
+		if (rc)
+			return rc;
+	}
+	vdk->dskAddr = dskAddr + nBlocks;
+
+	return VDK_OK;
+}
+
+// Write contiguous blocks (in disk format) from scatter/gather list.
+int vdk_WriteVector(VDK_DISK *vdk, uint32 dskAddr, struct iovec *iov,
+	int nVecs, uint32 nBlocks)
+{
+	uint32 szData;
+	uint8  *raw;
+	int    rc;
+
+	if (vdk == NULL)
+		return VDK_NODESC;
+	if (vdk->Flags & VDK_WRLOCK)
+		return VDK_WRPROT;
+	if ((dskAddr >= vdk->Blocks) || (nBlocks > (vdk->Blocks - dskAddr)))
+		return VDK_ADRERR;
+	szData = nBlocks * vdk->szBlock;
+
+	if ((vdk_Cache.szCache == 0) && !(vdk->Flags & (VDK_OVERLAY|VDK_COMPRESS))) {
+		if (rc = vdk_PutVector(vdk->dpFile, iov, nVecs, (off_t)dskAddr * vdk->szBlock)) {
+			vdk->errCode = rc;
+			return VDK_IOERROR;
+		}
+	} else {
+		if ((raw = (uint8 *)malloc(szData)) == NULL) {
+			vdk->errCode = ENOMEM;
+			return VDK_MEMERR;
+		}
+		vdk_CopyVector(raw, iov, nVecs, szData, 0);
+		rc = vdk_WriteRaw(vdk, dskAddr, raw, nBlocks);
+		free(raw);
+		if (rc)
+			return rc;
 	}
+	vdk->dskAddr = dskAddr + nBlocks;
 
 	return VDK_OK;
 }
 
+int vdk_ReadDisk(VDK_DISK *vdk, uint8 *data, uint32 mode)
+{
+	if (vdk == NULL)
+		return VDK_NODESC;
+	return vdk_ReadBlocks(vdk, vdk->dskAddr, data, 1, mode);
+}
+
+int vdk_WriteDisk(VDK_DISK *vdk, uint8 *data, uint32 mode)
+{
+	if (vdk == NULL)
+		return VDK_NODESC;
+	return vdk_WriteBlocks(vdk, vdk->dskAddr, data, 1, mode);
+}
+
 uint32 vdk_GetDiskAddr(VDK_DISK *vdk,
 	uint32 Cylinder, uint32 Track, uint32 Sector)
 {
 	return (((Cylinder * vdk->Tracks) + Track) * vdk->Sectors) + Sector;
 }
+
+// ********************************************************************
+
+// Asynchronous I/O
+//
+// Devices may pass block transfers to a pool of I/O threads, so
+// that emulator thread does not wait for host disk.  Requests are
+// served in order of arrival by any idle I/O thread.  Completed
+// requests are returned to emulator thread, which is woken up
+// and calls their completion routines from its I/O poll.  One
+// request per disk image is expected to be in progress at a time.
+
+static pthread_mutex_t vdk_IOLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  vdk_IOWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  vdk_IOIdle = PTHREAD_COND_INITIALIZER;
+static VDK_IOREQ       *vdk_IOHead = NULL; // Queued requests
+static VDK_IOREQ       *vdk_IOTail = NULL;
+static VDK_IOREQ       *vdk_IODone = NULL; // Completed requests
+static int             vdk_IOBusy  = 0;    // Requests in progress
+static int             vdk_IOStart = 0;    // I/O threads started
+
+static void *vdk_IOThread(void *arg)
+{
+	VDK_IOREQ *req;
+
+	pthread_mutex_lock(&vdk_IOLock);
+	for (;;) {
+		while ((req = vdk_IOHead) == NULL)
+			pthread_cond_wait(&vdk_IOWork, &vdk_IOLock);
+		if ((vdk_IOHead = req->Next) == NULL)
+			vdk_IOTail = NULL;
+		req->State = VDK_IOACTIVE;
+		pthread_mutex_unlock(&vdk_IOLock);
+
+		// Now perform that transfer.
+		req->vdk->errCode = 0;
+		if (req->nVecs > 0) {
+			if (req->Func == VDK_WRITE)
+				req->Result = vdk_WriteVector(req->vdk, req->dskAddr,
+					req->ioVec, req->nVecs, req->nBlocks);
+			else
+				req->Result = vdk_ReadVector(req->vdk, req->dskAddr,
+					req->ioVec, req->nVecs, req->nBlocks);
+		} else if (req->Func == VDK_WRITE)
+			req->Result = vdk_WriteBlocks(req->vdk, req->dskAddr,
+				req->Data, req->nBlocks, req->Mode);
+		else
+			req->Result = vdk_ReadBlocks(req->vdk, req->dskAddr,
+				req->Data, req->nBlocks, req->Mode);
+		req->errCode = req->vdk->errCode;
+
+		// Pass it back to emulator thread.
+		pthread_mutex_lock(&vdk_IOLock);
+		req->State  = VDK_IODONE;
+		req->Next   = vdk_IODone;
+		vdk_IODone  = req;
+		pthread_cond_broadcast(&vdk_IOIdle);
+
+		// Wake up emulator thread to complete it.
+		ts10_Wakeup();
+	}
+
+	return NULL;
+}
+
+// Call completion routines for all completed requests in order
+// of completion.  Each request is retired before its completion
+// routine is called, so that the routine may cancel other ones.
+static void vdk_PollIO(void)
+{
+	VDK_IOREQ **preq, *req;
+
+	while (vdk_IOBusy > 0) {
+		// Take oldest completed request.
+		pthread_mutex_lock(&vdk_IOLock);
+		if (vdk_IODone == NULL) {
+			pthread_mutex_unlock(&vdk_IOLock);
+			break;
+		}
+		for (preq = &vdk_IODone; (*preq)->Next; preq = &(*preq)->Next);
+		req        = *preq;
+		*preq      = NULL;
+		req->State = VDK_IOIDLE;
+		pthread_mutex_unlock(&vdk_IOLock);
+
+		vdk_IOBusy--;
+		if (req->Done)
+			req->Done(req);
+	}
+}
+
+static int vdk_InitIO(void)
+{
+	sigset_t  allSigs, oldSigs;
+	pthread_t ioThread;
+	int       idx;
+
+	// Poll for completed requests whenever woken up.
+	if (ts10_AddIOPoll(vdk_PollIO))
+		return VDK_MEMERR;
+
+	// Start I/O threads with all signals blocked so that
+	// emulator thread still receives all signals.
+	sigfillset(&allSigs);
+	pthread_sigmask(SIG_BLOCK, &allSigs, &oldSigs);
+	for (idx = 0; idx < VDK_NTHREADS; idx++) {
+		if (pthread_create(&ioThread, NULL, vdk_IOThread, NULL))
+			break;
+		pthread_detach(ioThread);
+	}
+	pthread_sigmask(SIG_SETMASK, &oldSigs, NULL);
+
+	return (idx > 0) ? VDK_OK : VDK_MEMERR;
+}
+
+// Queue that request for I/O threads.  Its completion routine will
+// be called from emulator thread when transfer is done.  Return
+// non-zero if request can't be queued.
+int vdk_StartIO(VDK_IOREQ *req)
+{
+	if ((req == NULL) || (req->vdk == NULL))
+		return VDK_NODESC;
+	if (vdk_IOStart == 0) {
+		if (vdk_InitIO())
+			return VDK_MEMERR;
+		vdk_IOStart = 1;
+	}
+
+	pthread_mutex_lock(&vdk_IOLock);
+	req->State = VDK_IOQUEUED;
+	req->Next  = NULL;
+	if (vdk_IOTail)
+		vdk_IOTail->Next = req;
+	else
+		vdk_IOHead = req;
+	vdk_IOTail = req;
+	pthread_cond_signal(&vdk_IOWork);
+	pthread_mutex_unlock(&vdk_IOLock);
+
+	vdk_IOBusy++;
+
+	return VDK_OK;
+}
+
+// Cancel that request.  Wait for I/O thread if it is being processed.
+// Its completion routine will not be called.
+void vdk_CancelIO(VDK_IOREQ *req)
+{
+	VDK_IOREQ **preq, *prev;
+
+	if (req == NULL)
+		return;
+
+	// Already retired by vdk_PollIO (or never started).
+	pthread_mutex_lock(&vdk_IOLock);
+	if (req->State == VDK_IOIDLE) {
+		pthread_mutex_unlock(&vdk_IOLock);
+		return;
+	} else if (req->State == VDK_IOQUEUED) {
+		// Remove it from queued requests.
+		for (prev = NULL, preq = &vdk_IOHead; *preq != req;
+		     prev = *preq, preq = &(*preq)->Next);
+		*preq = req->Next;
+		if (vdk_IOTail == req)
+			vdk_IOTail = prev;
+	} else {
+		while (req->State == VDK_IOACTIVE)
+			pthread_cond_wait(&vdk_IOIdle, &vdk_IOLock);
+
+		// Remove it from completed requests.
+		for (preq = &vdk_IODone; *preq; preq = &(*preq)->Next)
+			if (*preq == req) {
+				*preq = req->Next;
+				break;
+			}
+	}
+	req->State = VDK_IOIDLE;
+	req->Next  = NULL;
+	pthread_mutex_unlock(&vdk_IOLock);
+
+	vdk_IOBusy--;
+}
+
+// ********************************************************************
+
+// Usage: set cache <size>[k|m|g] [through|back]
+//        set cache off
+int CmdSetCache(void *dev, int argc, char **argv)
+{
+	uint64 szCache;
+	int    mode = vdk_Cache.Mode;
+	int    shift = 0;
+	char   *end;
+
+	if (argc < 3) {
+		printf("Usage: %s %s <size>[k|m|g] [through|back]\n", argv[0], argv[1]);
+		return EMU_OK;
+	}
+
+	if (!strcasecmp(argv[2], "off"))
+		szCache = 0;
+	else {
+		szCache = strtoull(argv[2], &end, 10);
+		switch (*end) {
+			case 'k': case 'K': shift = 10; end++; break;
+			case 'm': case 'M': shift = 20; end++; break;
+			case 'g': case 'G': shift = 30; end++; break;
+		}
+		if ((end == argv[2]) || (*end != '\0') || !isdigit(argv[2][0])) {
+			printf("%s: Invalid cache size - %s\n", argv[1], argv[2]);
+			return EMU_OK;
+		}
+		if (szCache > (VDK_MAXCACHE >> shift)) {
+			printf("%s: Cache size too large - %s (Maximum %u MB)\n",
+				argv[1], argv[2], VDK_MAXCACHE >> 20);
+			return EMU_OK;
+		}
+		szCache <<= shift;
+	}
+
+	if (argc > 3) {
+		if (!strncasecmp(argv[3], "through", strlen(argv[3])))
+			mode = VDK_WRTHRU;
+		else if (!strncasecmp(argv[3], "back", strlen(argv[3])))
+			mode = VDK_WRBACK;
+		else {
+			printf("%s: Unknown write mode - %s\n", argv[1], argv[3]);
+			return EMU_OK;
+		}
+	}
+
+	if (vdk_SetCache(szCache, mode) != VDK_OK)
+		printf("%s: Not enough memory.\n", argv[1]);
+
+	return EMU_OK;
+}
+
+// Usage: show cache
+int CmdShowCache(void *dev, int argc, char **argv)
+{
+	uint32 nReads = vdk_Cache.nHits + vdk_Cache.nMisses;
+
+	if (vdk_Cache.szCache == 0) {
+		printf("Disk block cache is off.\n");
+		return EMU_OK;
+	}
+
+	printf("Disk block cache: %u KB (%s)\n", vdk_Cache.szCache >> 10,
+		(vdk_Cache.Mode == VDK_WRBACK) ? "write-back" : "write-through");
+	printf("  Used:    %u KB in %u blocks\n",
+		vdk_Cache.szUsed >> 10, vdk_Cache.nBlocks);
+	printf("  Reads:   %u (%u hits, %u misses, %u%% hit rate)\n",
+		nReads, vdk_Cache.nHits, vdk_Cache.nMisses,
+		nReads ? (uint32)(((uint64)vdk_Cache.nHits * 100) / nReads) : 0);
+	printf("  Writes:  %u (%u written back, %u failed)\n",
+		vdk_Cache.nWrites, vdk_Cache.nBacks, vdk_Cache.nBackErrs);
+	printf("  Evicted: %u\n", vdk_Cache.nEvicts);
+
+	return EMU_OK;
+}
+
+// Usage: overlay <file> <base image>
+int CmdOverlay(void *dev, int argc, char **argv)
+{
+	int rc;
+
+	if (argc != 3) {
+		printf("Usage: %s <file> <base image>\n", argv[0]);
+		return EMU_OK;
+	}
+
+	if (rc = vdk_CreateOverlay(argv[1], argv[2])) {
+		printf("%s: Can't create overlay '%s' on '%s' - %s.\n", argv[0],
+			argv[1], argv[2], (rc == VDK_NONAME) ? "Name too long" : strerror(errno));
+		return EMU_OK;
+	}
+	printf("%s: Overlay '%s' created on '%s'.\n", argv[0], argv[1], argv[2]);
+
+	return EMU_OK;
+}
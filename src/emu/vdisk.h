@@ -24,11 +24,22 @@
 // dealings in this Software without prior written authorization from
 // Timothy M Stark.
 
+#include "emu/vzip.h"
+#include "emu/pthread.h"
+
 // Virtual Disk Flags
 #define VDK_OPENED   0x80000000  // File is opened and accesible.
 #define VDK_WRLOCK   0x40000000  // Write-locked (1 = Locked, 0 = Unlocked)
+#define VDK_OVERLAY  0x20000000  // Copy-on-write overlay on base image
+#define VDK_COMPRESS 0x10000000  // Compressed image container
 #define VDK_18B      0x00000001  // 18-bit Mode - Use format conversion
 
+// Block Cache Write Modes
+#define VDK_WRTHRU   0  // Write-through
+#define VDK_WRBACK   1  // Write-back (Written at eviction or flush)
+
+#define VDK_MAXCACHE 0x80000000u // Maximum cache size (2 GB)
+
 // Virtual Disk Error Codes
 #define VDK_OK       0  // Successful - Normal Operation
 #define VDK_IOERROR  1  // I/O Error
@@ -40,8 +51,20 @@
 #define VDK_ADRERR   7  // Address Error
 #define VDK_WRPROT   8  // Write Protection Violation
 
+// Asynchronous I/O Functions and States
+#define VDK_READ     0  // Read blocks
+#define VDK_WRITE    1  // Write blocks
+
+#define VDK_IOIDLE   0  // Not in use
+#define VDK_IOQUEUED 1  // Waiting for I/O thread
+#define VDK_IOACTIVE 2  // Being processed by I/O thread
+#define VDK_IODONE   3  // Done, waiting for completion call
+
+#define VDK_NTHREADS 4    // Number of I/O threads
+
 typedef struct vdk_Format VDK_FORMAT;
 typedef struct vdk_Disk   VDK_DISK;
+typedef struct vdk_IoReq  VDK_IOREQ;
 
 struct vdk_Format {
 	char   *Name;    // Format Name
@@ -65,6 +88,8 @@ struct vdk_Disk {
 	int        dpFile;    // File Descriptor for host operating system.
 	uint32     dskAddr;   // Current Disk Address in Blocks.
 	int        errCode;   // Error Code (errno)
+	pthread_mutex_t Lock; // Lock for image file and overlay bitmap
+	int        wbError;   // Write-back error (errno) not reported yet
 
 	// Disk Geometries
 	uint32     Cylinders; // Number of Cylinders
@@ -74,6 +99,37 @@ struct vdk_Disk {
 	uint32     vsBlock;   // Virtual Block Size
 	uint32     szBlock;   // Physical Block Size
 	uint32     szImage;   // Image Size in Bytes
+
+	// Copy-on-write overlay
+	char       *baseName; // Base Image Name
+	int        dpBase;    // File Descriptor for base image (read-only)
+	uint8      *ovlMap;   // Allocation Bitmap (1 = Block in overlay)
+	uint32     ovlMapPos; // Position of bitmap in overlay file
+	uint32     ovlData;   // Position of block data in overlay file
+
+	// Compressed image containers
+	VZP_FILE   *zpFile;   // Image file (or overlay file)
+	VZP_FILE   *zpBase;   // Base image
+};
+
+// Asynchronous I/O Request
+struct vdk_IoReq {
+	VDK_IOREQ  *Next;     // Next request in queue
+	VDK_DISK   *vdk;      // Disk image
+	int        Func;      // Function (Read or Write)
+	int        State;     // Request State
+	uint32     dskAddr;   // Disk Address in Blocks
+	uint8      *Data;     // Data Buffer
+	struct iovec *ioVec;  // Scatter/Gather List (instead of buffer)
+	int        nVecs;     // Number of Entries (0 = Use data buffer)
+	uint32     nBlocks;   // Number of Blocks
+	uint32     Mode;      // Transfer Mode (VDK_18B)
+	int        Result;    // Return code (VDK_OK, etc.)
+	int        errCode;   // Error Code (errno)
+
+	// Completion call (from emulator thread)
+	void       *Device;
+	void       (*Done)(VDK_IOREQ *);
 };
 
 // External function calls.
@@ -82,4 +138,14 @@ int vdk_CloseDisk(VDK_DISK *);
 int vdk_SeekDisk(VDK_DISK *, uint32);
 int vdk_ReadDisk(VDK_DISK *, uint8 *, uint32);
 int vdk_WriteDisk(VDK_DISK *, uint8 *, uint32);
+int vdk_ReadBlocks(VDK_DISK *, uint32, uint8 *, uint32, uint32);
+int vdk_WriteBlocks(VDK_DISK *, uint32, uint8 *, uint32, uint32);
+int vdk_ReadVector(VDK_DISK *, uint32, struct iovec *, int, uint32);
+int vdk_WriteVector(VDK_DISK *, uint32, struct iovec *, int, uint32);
 uint32 vdk_GetDiskAddr(VDK_DISK *, uint32, uint32, uint32);
+int32 vdk_GetImageSize(VDK_DISK *);
+int vdk_CreateOverlay(char *, char *);
+int vdk_StartIO(VDK_IOREQ *);
+void vdk_CancelIO(VDK_IOREQ *);
+int vdk_SetCache(uint64, int);
+int vdk_FlushCache(VDK_DISK *);
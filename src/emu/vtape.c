@@ -59,84 +59,207 @@ static __inline__ int vmt_DispError(register VMT_TAPE *vmt, char *reason)
 
 // ********************************************************************
 
+// Read tape data from image file or compressed container.
+static __inline__ int vmt_ReadFile(VMT_TAPE *vmt, uint8 *data, uint32 len, uint32 pos)
+{
+	if (vmt->zpFile)
+		return vzp_Read(vmt->zpFile, data, len, pos);
+	return pread(vmt->dpFile, data, len, pos);
+}
+
+// Read-ahead Buffer
+//
+// Tape data are read through a large buffer, so that each record
+// does not need any more system calls.  Buffer is filled forward
+// for forward reads, or backward for reverse reads.  Large records
+// are read directly.  Writes discard the buffer.
+
+static int vmt_ReadData(VMT_TAPE *vmt, uint32 pos, uint8 *data,
+	uint32 len, int rev)
+{
+	uint32 cnt;
+	int    rc;
+
+	if ((vmt->bufData == NULL) || (len > (VMT_BUFSZ / 2)))
+		return vmt_ReadFile(vmt, data, len, pos);
+
+	if ((pos < vmt->bufAddr) || ((pos + len) > (vmt->bufAddr + vmt->bufLen))) {
+		// Refill buffer around that data.
+		if (rev && ((pos + len) > VMT_BUFSZ))
+			vmt->bufAddr = (pos + len) - VMT_BUFSZ;
+		else
+			vmt->bufAddr = rev ? 0 : pos;
+		vmt->bufLen = 0;
+		if ((rc = vmt_ReadFile(vmt, vmt->bufData, VMT_BUFSZ, vmt->bufAddr)) < 0)
+			return rc;
+		vmt->bufLen = rc;
+		if (pos >= (vmt->bufAddr + vmt->bufLen))
+			return 0;
+	}
+
+	cnt = (vmt->bufAddr + vmt->bufLen) - pos;
+	if (cnt > len)
+		cnt = len;
+	memcpy(data, &vmt->bufData[pos - vmt->bufAddr], cnt);
+	return cnt;
+}
+
+// ********************************************************************
+
+// Record Index
+//
+// Index holds position and header of every record and tape mark
+// from BOT to idxEnd.  It is built while tape is being read or
+// spaced forward beyond idxEnd, so that spacing and reverse reads
+// within indexed part of tape need no I/O.  Writing a record
+// truncates index at that position.
+
+// Find that record by position.  Return -1 if not found.
+static int vmt_FindRecord(VMT_TAPE *vmt, uint32 pos)
+{
+	int lo = 0, hi = vmt->nRecs - 1, mid;
+
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		if (vmt->recIndex[mid].Pos == pos)
+			return mid;
+		if (vmt->recIndex[mid].Pos < pos)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return -1;
+}
+
+// Find a record just before that position.  Return -1 if not found.
+static int vmt_FindPrevious(VMT_TAPE *vmt, uint32 pos)
+{
+	int idx;
+
+	if (pos == vmt->idxEnd)
+		return vmt->nRecs - 1;
+	if ((idx = vmt_FindRecord(vmt, pos)) < 0)
+		return -1;
+	return idx - 1;
+}
+
+// Return position next to that record.
+static __inline__ uint32 vmt_NextRecord(VMT_TAPE *vmt, int idx)
+{
+	return ((idx + 1) < vmt->nRecs) ? vmt->recIndex[idx+1].Pos : vmt->idxEnd;
+}
+
+// Put a new record at that position, which ends at end.
+static int vmt_AddRecord(VMT_TAPE *vmt, uint32 pos, uint32 hdr, uint32 end)
+{
+	VMT_RECORD *newIndex;
+	uint32     szIndex;
+
+	// Discard all records at and after that position.
+	if (pos != vmt->idxEnd) {
+		while (vmt->nRecs && (vmt->recIndex[vmt->nRecs-1].Pos >= pos))
+			vmt->nRecs--;
+	}
+
+	if (vmt->nRecs == vmt->szIndex) {
+		szIndex = vmt->szIndex ? (vmt->szIndex * 2) : VMT_NINDEX;
+		newIndex = (VMT_RECORD *)realloc(vmt->recIndex,
+			szIndex * sizeof(VMT_RECORD));
+		if (newIndex == NULL)
+			return MTERR(vmt, ENOMEM);
+		vmt->recIndex = newIndex;
+		vmt->szIndex  = szIndex;
+	}
+
+	vmt->recIndex[vmt->nRecs].Pos = pos;
+	vmt->recIndex[vmt->nRecs].Hdr = hdr;
+	vmt->nRecs++;
+	vmt->idxEnd = end;
+
+	return MT_OK;
+}
+
+// ********************************************************************
+
 // TPS Format - Tape Data, SIMH Format
 
-int tps_Read(VMT_TAPE *vmt, uint8 *data, int32 blksz)
+// Put a record next to index into index.
+static int tps_Parse(VMT_TAPE *vmt)
 {
+	uint32 pos = vmt->idxEnd;
 	uint32 blksz32, tblksz32, wc;
-	int    rbc, pos;
+	int    rbc;
+
+	if ((rbc = vmt_ReadData(vmt, pos, (uint8 *)&blksz32, sizeof(blksz32), 0)) < 0)
+		return MTERR(vmt, errno);
+	else if (rbc < sizeof(blksz32))
+		return MT_EOT;
+	else if ((blksz32 == MTR_TMK) || (blksz32 == MTR_EOM))
+		return vmt_AddRecord(vmt, pos, blksz32, pos + sizeof(blksz32));
+
+	wc  = (MTRL(blksz32) + 1) & ~1; // Word-aligned length
+	rbc = vmt_ReadData(vmt, pos + sizeof(blksz32) + wc,
+		(uint8 *)&tblksz32, sizeof(tblksz32), 0);
+	if (rbc < 0)
+		return MTERR(vmt, errno);
+	else if (rbc < sizeof(tblksz32))
+		return MT_EOT;
+	else if (blksz32 != tblksz32) {
+#ifdef DEBUG
+		dbg_Printf("%s: Read Forward(%d): Mismatch block sizes: %d != %d\n",
+			vmt->Format->Name, pos, blksz32, tblksz32);
+#endif /* DEBUG */
+		return MT_CRC;
+	}
+
+	return vmt_AddRecord(vmt, pos, blksz32,
+		pos + wc + (sizeof(blksz32) * 2));
+}
+
+int tps_Read(VMT_TAPE *vmt, uint8 *data, int32 blksz)
+{
+	VMT_RECORD *rec;
+	uint32     blksz32, wc;
+	int        idx, rbc, pos, rc;
 
 	vmt->errCode = 0;
 	if (blksz < 0) {
 		// Read Reverse
 		if (vmt->mtAddr == 0)
 			return MTOK2(vmt, MT_BOT, "Bottom of Tape");
-
-		pos = vmt->mtAddr - sizeof(blksz32);
-		lseek(vmt->dpFile, pos, SEEK_SET);
-		rbc = read(vmt->dpFile, &blksz32, sizeof(blksz32));
-		if (rbc < sizeof(blksz32)) {
-			return MTERR2(vmt, "Read Reverse");
-		} else if (blksz32 == MTR_TMK) {
-			vmt->mtAddr = pos;
-			return MTOK2(vmt, MT_MARK, "Tape Mark");
-		} else if (blksz32 == MTR_EOM) {
-			vmt->mtAddr = pos;
-			return MTOK2(vmt, MT_EOM, "End of Medium");
-		}
-
-		pos -= (wc = (blksz32 + 1) & ~1); // Word-aligned length
-		lseek(vmt->dpFile, pos, SEEK_SET);
-		if ((rbc = read(vmt->dpFile, data, wc)) < 0)
-			return MTERR2(vmt, "Read Reverse");
-		else if (rbc < wc)
-			return MTOK2(vmt, MT_BOT, "Bottom of Tape");
-	
-		pos -= sizeof(tblksz32);
-		lseek(vmt->dpFile, pos, SEEK_SET);
-		if ((rbc = read(vmt->dpFile, &tblksz32, sizeof(tblksz32))) < 0)
-			return MTERR2(vmt, "Read Reverse");
-		else if ((rbc != sizeof(tblksz32)) || (blksz32 != tblksz32)) {
-#ifdef DEBUG
-			dbg_Printf("%s: Read Reverse(%d): Mismatch block sizes: %d != %d\n",
-				vmt->Format->Name, vmt->mtAddr, blksz32, tblksz32);
-#endif /* DEBUG */
-			return MTOK(vmt, MT_CRC);
-		}
+		if ((idx = vmt_FindPrevious(vmt, vmt->mtAddr)) < 0)
+			return MTERR(vmt, EINVAL);
+		rec = &vmt->recIndex[idx];
+		pos = rec->Pos;
 	} else {
 		// Read Forward
-		lseek(vmt->dpFile, vmt->mtAddr, SEEK_SET);
-		rbc = read(vmt->dpFile, &blksz32, sizeof(blksz32));
-		if (rbc < 0)
-			return MTERR2(vmt, "Read Forward");
-		else if (rbc < sizeof(blksz32))
-			return MTOK2(vmt, MT_EOT, "End of Tape");
-		else if (blksz32 == MTR_TMK) {
-			vmt->mtAddr += sizeof(blksz32);
-			return MTOK2(vmt, MT_MARK, "Tape Mark");
-		} else if (blksz32 == MTR_EOM) {
-			vmt->mtAddr += sizeof(blksz32);
-			return MTOK2(vmt, MT_EOM, "End of Medium");
+		if ((vmt->mtAddr == vmt->idxEnd) && (rc = tps_Parse(vmt))) {
+			if (rc == MT_EOT)
+				return MTOK2(vmt, MT_EOT, "End of Tape");
+			return (rc == MT_ERROR) ? MTERR2(vmt, "Read Forward") : MTOK(vmt, rc);
 		}
+		if ((idx = vmt_FindRecord(vmt, vmt->mtAddr)) < 0)
+			return MTERR(vmt, EINVAL);
+		rec = &vmt->recIndex[idx];
+		pos = vmt_NextRecord(vmt, idx);
+	}
 
-		wc = (blksz32 + 1) & ~1; // Word-aligned length
-		if ((rbc = read(vmt->dpFile, data, wc)) < 0)
-			return MTERR2(vmt, "Read Forward");
-		else if (rbc < wc)
-			return MTOK2(vmt, MT_EOT, "End of Tape");
-
-		if ((rbc = read(vmt->dpFile, &tblksz32, sizeof(tblksz32))) < 0)
-			return MTERR2(vmt, "Read Forward");
-		else if ((rbc != sizeof(tblksz32)) || (blksz32 != tblksz32)) {
-#ifdef DEBUG
-			dbg_Printf("%s: Read Forward(%d): Mismatch block sizes: %d != %d\n",
-				vmt->Format->Name, vmt->mtAddr, blksz32, tblksz32);
-#endif /* DEBUG */
-			return MTOK(vmt, MT_CRC);
-		}
-		pos = vmt->mtAddr + wc + (sizeof(blksz32) * 2);
+	if (rec->Hdr == MTR_TMK) {
+		vmt->mtAddr = pos;
+		return MTOK2(vmt, MT_MARK, "Tape Mark");
+	} else if (rec->Hdr == MTR_EOM) {
+		vmt->mtAddr = pos;
+		return MTOK2(vmt, MT_EOM, "End of Medium");
 	}
 
+	blksz32 = MTRL(rec->Hdr);
+	wc = (blksz32 + 1) & ~1; // Word-aligned length
+	if ((rbc = vmt_ReadData(vmt, rec->Pos + sizeof(blksz32), data, wc, blksz < 0)) < 0)
+		return MTERR2(vmt, (blksz < 0) ? "Read Reverse" : "Read Forward");
+	else if (rbc < wc)
+		return MTOK2(vmt, (blksz < 0) ? MT_BOT : MT_EOT,
+			(blksz < 0) ? "Bottom of Tape" : "End of Tape");
+
 #ifdef DEBUG
 	if (vmt->Flags & VMT_DEBUG)
 		dbg_Printf("%s: Read %s(%d): Read %d bytes of data.\n",
@@ -148,12 +271,13 @@ int tps_Read(VMT_TAPE *vmt, uint8 *data, int32 blksz)
 
 	// Record is valid now.
 	vmt->mtAddr = pos;
-	return MTOK(vmt, blksz32);
+	return MTOK(vmt, MTRF(rec->Hdr) ? MT_CRC : blksz32);
 }
 
 int tps_Write(VMT_TAPE *vmt, uint8 *data, int32 blksz)
 {
-	int wc, idx, rc;
+	uint32 pos = vmt->mtAddr;
+	int    wc, rc;
 
 	vmt->errCode = 0;
 
@@ -168,13 +292,18 @@ int tps_Write(VMT_TAPE *vmt, uint8 *data, int32 blksz)
 			vmt->Format->Name);
 #endif /* DEBUG */
 		vmt->errCode = -1;
-	} else if ((rc = lseek(vmt->dpFile, vmt->mtAddr, SEEK_SET)) >= 0) {
-		if ((rc = write(vmt->dpFile, &blksz, sizeof(blksz))) == sizeof(blksz)) {
-			wc = (blksz + 1) & ~1; // Word-aligned length
-			if (blksz < wc) data[blksz] = '\0';
-			if ((rc = write(vmt->dpFile, data, wc)) == wc) {
-				rc = write(vmt->dpFile, &blksz, sizeof(blksz));
-				if (rc == sizeof(blksz)) {
+		return MT_ERROR;
+	}
+
+	vmt->bufLen = 0;
+	if ((rc = pwrite(vmt->dpFile, &blksz, sizeof(blksz), pos)) == sizeof(blksz)) {
+		wc = (blksz + 1) & ~1; // Word-aligned length
+		if (blksz < wc) data[blksz] = '\0';
+		pos += sizeof(blksz);
+		if ((rc = pwrite(vmt->dpFile, data, wc, pos)) == wc) {
+			pos += wc;
+			rc = pwrite(vmt->dpFile, &blksz, sizeof(blksz), pos);
+			if (rc == sizeof(blksz)) {
 #ifdef DEBUG
 	if (vmt->Flags & VMT_DEBUG)
 		dbg_Printf("%s: Write Forward(%d): Write %d bytes of data.\n",
@@ -182,22 +311,18 @@ int tps_Write(VMT_TAPE *vmt, uint8 *data, int32 blksz)
 	if (vmt->Flags & VMT_DUMP)
 		PrintDump(0, data, wc);
 #endif /* DEBUG */
-					// Record is valid now.
-					vmt->mtAddr  += wc + (sizeof(blksz) * 2);
-					vmt->posFlag  = MT_CUR;
-					vmt->errCode  = 0;
-					return blksz;
-				}
+				// Record is valid now.
+				pos += sizeof(blksz);
+				if (vmt_AddRecord(vmt, vmt->mtAddr, blksz, pos))
+					return MT_ERROR;
+				vmt->mtAddr   = pos;
+				vmt->posFlag  = MT_CUR;
+				vmt->errCode  = 0;
+				return blksz;
 			}
 		}
-	} else {
-		vmt->errCode = errno;
-#ifdef DEBUG
-		if (vmt->Flags & VMT_DEBUG)
-			dbg_Printf("%s: (W) Seek(%s): %s\n",
-				vmt->Format->Name, vmt->mtAddr, strerror(errno));
-#endif /* DEBUG */
 	}
+	vmt->errCode = (rc < 0) ? errno : ENOSPC;
 
 	// if no space left on device means the end of tape.
 	if (vmt->errCode == ENOSPC) {
@@ -210,51 +335,43 @@ int tps_Write(VMT_TAPE *vmt, uint8 *data, int32 blksz)
 	return MT_ERROR;
 }
 
-int tps_Mark(VMT_TAPE *vmt)
+// Write a tape mark or end of medium.
+static int tps_WriteMark(VMT_TAPE *vmt, uint32 mark, char *reason)
 {
-	uint32 tmk = MTR_TMK; // Block length
-	int    rc;
+	int rc;
 
 	if (vmt->Flags & VMT_WRLOCK) {
 		vmt->errCode = EACCES;
 		return MT_ERROR;
 	}
 
-	if ((rc = write(vmt->dpFile, &tmk, sizeof(tmk))) < 0)
-		return MTERR2(vmt, "Tape Mark");
-	if (rc < sizeof(tmk))
+	vmt->bufLen = 0;
+	if ((rc = pwrite(vmt->dpFile, &mark, sizeof(mark), vmt->mtAddr)) < 0)
+		return MTERR2(vmt, reason);
+	if (rc < sizeof(mark))
 		return MTOK2(vmt, MT_EOT, "End of Tape");
 
 	// Successful Operation
-	vmt->mtAddr += sizeof(tmk);
+	if (vmt_AddRecord(vmt, vmt->mtAddr, mark, vmt->mtAddr + sizeof(mark)))
+		return MT_ERROR;
+	vmt->mtAddr += sizeof(mark);
 	return MTOK(vmt, MT_OK);
 }
 
-int tps_Erase(VMT_TAPE *vmt)
+int tps_Mark(VMT_TAPE *vmt)
 {
-	uint32 eom = MTR_EOM; // Block length
-	int    rc;
-
-	if (vmt->Flags & VMT_WRLOCK) {
-		vmt->errCode = EACCES;
-		return MT_ERROR;
-	}
-
-	if ((rc = write(vmt->dpFile, &eom, sizeof(eom))) < 0)
-		return MTERR2(vmt, "Erase");
-	if (rc < sizeof(eom))
-		return MTOK2(vmt, MT_EOT, "End of Tape");
+	return tps_WriteMark(vmt, MTR_TMK, "Tape Mark");
+}
 
-	// Successful Operation
-	vmt->mtAddr += sizeof(eom);
-	return MTOK(vmt, MT_OK);
+int tps_Erase(VMT_TAPE *vmt)
+{
+	return tps_WriteMark(vmt, MTR_EOM, "Erase");
 }
 
 int tps_Skip(VMT_TAPE *vmt, int32 dir)
 {
-	uint32 blksz;
-	int count = 0;
-	int pos, rc;
+	VMT_RECORD *rec;
+	int        idx, rc;
 
 	vmt->posFlag = MT_CUR;
 	if (dir < 0) {
@@ -263,65 +380,50 @@ int tps_Skip(VMT_TAPE *vmt, int32 dir)
 			vmt->posFlag = MT_BOT;
 			return vmt->posFlag;
 		}
-		pos = vmt->mtAddr - sizeof(blksz);
-		lseek(vmt->dpFile, pos, SEEK_SET);
-		if ((rc = read(vmt->dpFile, &blksz, sizeof(blksz))) < sizeof(blksz)) {
-			if (rc < 0) {
-				// I/O Error
-				vmt->errCode = errno;
-				vmt->posFlag = MT_ERROR;
-			} else
-				// BOT/EOM Encounter
-				vmt->posFlag = MT_BOT;
-			vmt->mtAddr = 0;
+		if ((idx = vmt_FindPrevious(vmt, vmt->mtAddr)) < 0) {
+			vmt->errCode = EINVAL;
+			vmt->posFlag = MT_ERROR;
 			return vmt->posFlag;
 		}
-#ifdef DEBUG
-		if (vmt->Flags & VMT_DEBUG)
-			dbg_Printf("%s: (Backward) Skipping %d (%04X at %08X) bytes of record.\n",
-				vmt->Format->Name, blksz, blksz, vmt->mtAddr);
-#endif /* DEBUG */
-		if (blksz == 0) {
-			vmt->mtAddr  = pos;
-			vmt->posFlag = MT_MARK;
-		} else
-			vmt->mtAddr -= (blksz + (sizeof(blksz) * 2));
+		rec = &vmt->recIndex[idx];
+		vmt->mtAddr = rec->Pos;
 	} else {
-		lseek(vmt->dpFile, vmt->mtAddr, SEEK_SET);
-		rc = read(vmt->dpFile, &blksz, sizeof(blksz));
-		if (rc == sizeof(blksz)) {
+		if ((vmt->mtAddr == vmt->idxEnd) && (rc = tps_Parse(vmt))) {
+			vmt->posFlag = rc;
+			return vmt->posFlag;
+		}
+		if ((idx = vmt_FindRecord(vmt, vmt->mtAddr)) < 0) {
+			vmt->errCode = EINVAL;
+			vmt->posFlag = MT_ERROR;
+			return vmt->posFlag;
+		}
+		rec = &vmt->recIndex[idx];
+		vmt->mtAddr = vmt_NextRecord(vmt, idx);
+	}
+
 #ifdef DEBUG
-			if (vmt->Flags & VMT_DEBUG)
-				dbg_Printf("%s: (Forward) Skipping %d (%04X at %08X) bytes of record.\n",
-					vmt->Format->Name, blksz, blksz, vmt->mtAddr);
+	if (vmt->Flags & VMT_DEBUG)
+		dbg_Printf("%s: (%s) Skipping %d (%04X at %08X) bytes of record.\n",
+			vmt->Format->Name, (dir < 0) ? "Backward" : "Forward",
+			rec->Hdr, rec->Hdr, rec->Pos);
 #endif /* DEBUG */
-			if (blksz == 0) {
-				vmt->mtAddr += sizeof(blksz);
-				vmt->posFlag = MT_MARK;
-			} else
-				vmt->mtAddr += (blksz + (sizeof(blksz) * 2));
-		} else if (rc == 0)
-			vmt->posFlag = MT_EOT;
-	}
+
+	if (rec->Hdr == MTR_TMK)
+		vmt->posFlag = MT_MARK;
+	else if (rec->Hdr == MTR_EOM)
+		vmt->posFlag = MT_EOM;
 
 	return vmt->posFlag;
 }
 
 int tps_Rewind(VMT_TAPE *vmt)
 {
-	int32 pos;
-
-	if ((pos = lseek(vmt->dpFile, 0, SEEK_SET)) < 0) {
-		vmt->errCode = errno;
-		return MT_ERROR;
-	}
-
 #ifdef DEBUG
 	if (vmt->Flags & VMT_DEBUG)
 		dbg_Printf("%s: Rewinding.\n", vmt->Format->Name);
 #endif /* DEBUG */
 
-	vmt->mtAddr  = pos;
+	vmt->mtAddr  = 0;
 	vmt->posFlag = MT_BOT;
 
 	return MT_OK;
@@ -352,23 +454,26 @@ VMT_FORMAT *vmt_GetFormat(char *fmtName)
 
 int vmt_OpenTape(VMT_TAPE *vmt)
 {
-	VMT_FORMAT *fmt;
-	int        umode;
+	VMT_FORMAT *fmt = NULL;
+	char       *p;
+	int        umode, rc;
 
 	// Check any errors first.
 	if (vmt == NULL)
 		return VMT_NODESC;
 	if (vmt->fileName == NULL)
 		return VMT_NONAME;
-	if (vmt->fmtName == NULL) {
-		char *p = strrchr(vmt->fileName, '.');
-		if (p == NULL)
-			return VMT_NOFMT;
-		vmt->fmtName = p + 1;
+	if ((p = vmt->fmtName) == NULL) {
+		if (p = strrchr(vmt->fileName, '.'))
+			p++;
 	}
-	if ((fmt = vmt_GetFormat(vmt->fmtName)) == NULL)
+	if (p)
+		fmt = vmt_GetFormat(p);
+
+	// Unknown format is only allowed for compressed
+	// containers, which tell their format.
+	if ((fmt == NULL) && (access(vmt->fileName, F_OK) < 0))
 		return VMT_NOFMT;
-	vmt->Format = fmt;
 
 	// Attempt to open a tape file.
 	umode = (vmt->Flags & VMT_WRLOCK) ? O_RDONLY : O_RDWR|O_CREAT;
@@ -376,7 +481,44 @@ int vmt_OpenTape(VMT_TAPE *vmt)
 		vmt->errCode = errno;
 		return VMT_OPENERR;
 	}
+
+	// Check if that is a compressed container.  Compressed
+	// tapes are always read only.
+	if (rc = vzp_Open(vmt->dpFile, VZP_RDONLY, &vmt->zpFile)) {
+		close(vmt->dpFile);
+		vmt->errCode = rc;
+		return VMT_OPENERR;
+	}
+	if (vmt->zpFile) {
+		if ((vmt->Flags & VMT_WRLOCK) == 0)
+			vmt->Flags |= VMT_WRLOCK|VMT_ZPLOCK;
+		if ((fmt == NULL) && (vmt->fmtName == NULL))
+			fmt = vmt_GetFormat(vzp_GetFormat(vmt->zpFile));
+	}
+	if (fmt == NULL) {
+		if (vmt->zpFile)
+			vzp_Close(vmt->zpFile);
+		if (vmt->Flags & VMT_ZPLOCK)
+			vmt->Flags &= ~(VMT_WRLOCK|VMT_ZPLOCK);
+		vmt->zpFile = NULL;
+		close(vmt->dpFile);
+		return VMT_NOFMT;
+	}
+	if (vmt->fmtName == NULL)
+		vmt->fmtName = fmt->Name;
+	vmt->Format = fmt;
 	vmt->Flags |= VMT_OPENED;
+	vmt->mtAddr = 0;
+
+	// Set up empty record index and read-ahead buffer.
+	// Without buffer, data are read directly.
+	vmt->recIndex = NULL;
+	vmt->nRecs    = 0;
+	vmt->szIndex  = 0;
+	vmt->idxEnd   = 0;
+	vmt->bufData  = (uint8 *)malloc(VMT_BUFSZ);
+	vmt->bufAddr  = 0;
+	vmt->bufLen   = 0;
 
 	return VMT_OK;
 }
@@ -386,9 +528,26 @@ int vmt_CloseTape(VMT_TAPE *vmt)
 	if (vmt == NULL)
 		return VMT_NODESC;
 
+	// Release write lock if open had set it
+	// for compressed tape.
+	if (vmt->zpFile)
+		vzp_Close(vmt->zpFile);
+	if (vmt->Flags & VMT_ZPLOCK)
+		vmt->Flags &= ~(VMT_WRLOCK|VMT_ZPLOCK);
+	vmt->zpFile  = NULL;
 	close(vmt->dpFile);
 	vmt->Flags  &= ~VMT_OPENED;
 	vmt->dpFile  = 0;
 
+	// Release record index and read-ahead buffer.
+	if (vmt->recIndex)
+		free(vmt->recIndex);
+	if (vmt->bufData)
+		free(vmt->bufData);
+	vmt->recIndex = NULL;
+	vmt->bufData  = NULL;
+	vmt->nRecs    = 0;
+	vmt->szIndex  = 0;
+
 	return VMT_OK;
 }
@@ -24,11 +24,14 @@
 // dealings in this Software without prior written authorization from
 // Timothy M Stark.
 
+#include "emu/vzip.h"
+
 // Virtual Tape Flags
 #define VMT_OPENED  0x80000000  // Tape file is Opened.
 #define VMT_WRLOCK  0x40000000  // Write-locked (1 = Locked, 0 = Unlocked)
 #define VMT_DEBUG   0x20000000  // Debug Information Enable
 #define VMT_DUMP    0x10000000  // Dump Information Enable
+#define VMT_ZPLOCK  0x08000000  // Write-locked by open (compressed tape)
 
 // Virtual Disk Error Codes
 #define VMT_OK       0  // Successful - Normal Operation
@@ -64,8 +67,13 @@
 #define MT_CRC   -5  // Bad CRC/Checksum
 #define MT_ERROR -6  // I/O Error
 
+// Read-ahead buffer and record index
+#define VMT_BUFSZ   (1 << 20) // Size of read-ahead buffer
+#define VMT_NINDEX  1024      // Initial size of record index
+
 typedef struct vmt_Format VMT_FORMAT;
 typedef struct vmt_Tape   VMT_TAPE;
+typedef struct vmt_Record VMT_RECORD;
 
 struct vmt_Format {
 	char *Name;    // Format Name (File extension)
@@ -81,6 +89,12 @@ struct vmt_Format {
 	int (*Rewind)(VMT_TAPE *);
 };
 
+// Record index entry (one per record or tape mark)
+struct vmt_Record {
+	uint32 Pos;      // Tape Address of record
+	uint32 Hdr;      // Record Header (Length, Tape Mark, or EOM)
+};
+
 struct vmt_Tape {
 	char       *fileName; // File Name
 	int        dpFile;    // File Descriptor for host operating system.
@@ -92,6 +106,18 @@ struct vmt_Tape {
 	int        posFlag;   // Position Flag - BOT, EOF, or EOT.
 	int        errCode;   // Error Code
 
+	// Record Index (records from BOT to idxEnd)
+	VMT_RECORD *recIndex; // Record Index
+	uint32     nRecs;     // Number of records in index
+	uint32     szIndex;   // Size of index (in entries)
+	uint32     idxEnd;    // Tape Address next to last record in index
+
+	// Read-ahead Buffer
+	uint8      *bufData;  // Buffer Data
+	uint32     bufAddr;   // Tape Address of buffer
+	uint32     bufLen;    // Length of valid data in buffer
+
+	VZP_FILE   *zpFile;   // Compressed image container (read only)
 };
 
 // External function calls
@@ -0,0 +1,731 @@
+// vzip.c - Compressed Image Container Support Routines
+//
+// Copyright (c) 2002, Timothy M. Stark
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// TIMOTHY M STARK BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Timothy M Stark shall not
+// be used in advertising or otherwise to promote the sale, use or other
+// dealings in this Software without prior written authorization from
+// Timothy M Stark.
+
+// Compressed container holds a tape or disk image as fixed-size
+// chunks, each compressed independently by zlib, so that any part
+// of image can be read without decompressing whole image.  File
+// begins with a header, followed by chunk data, and chunk index
+// (position and length of each chunk) is at end of file.  Chunks
+// of zeros are not stored at all.
+//
+// Recently used chunks are kept decompressed in a small cache for
+// each container.  Changed chunks are compressed again and written
+// back when they are replaced or flushed.  Chunks and index are
+// never written over space that header still refers to, so that
+// file stays consistent if emulator dies before flush completes.
+// They go to free space or end of file.  Space they leave behind
+// is held until new index and header are written and synced, then
+// becomes free for reuse, and free space at end of file is cut off.
+// Free space is found from index when container is opened.
+
+#include "emu/defs.h"
+#include "emu/vzip.h"
+#include "emu/pthread.h"
+#include <zlib.h>
+
+#define VZP_HDRSZ   64  // Size of header
+#define VZP_NOCHUNK ((uint32)-1)
+
+// Index flags
+#define VZP_RAW     0x0001  // Chunk is stored uncompressed
+
+typedef struct {
+	char   Magic[8];            // Magic ("TS10VZP")
+	uint32 Version;             // Format Version
+	uint32 szChunk;             // Chunk Size (uncompressed)
+	uint64 szImage;             // Image Size in Bytes
+	uint64 idxPos;              // Position of Chunk Index
+	uint32 nChunks;             // Number of Chunks
+	uint32 Flags;               // (Reserved)
+	char   fmtName[VZP_FMTSZ];  // Format Name of Image
+	uint32 Reserved[2];
+} VZP_HEADER;
+
+typedef struct {
+	uint64 Pos;    // Position of chunk data
+	uint32 Len;    // Length of chunk data (0 = zeros)
+	uint32 Flags;  // Chunk Flags
+} VZP_ENTRY;
+
+typedef struct {
+	off_t  Pos;    // Position of space
+	off_t  Len;    // Length of space
+} VZP_EXTENT;
+
+typedef struct {
+	VZP_EXTENT *Ext;  // Extents (sorted by position)
+	uint32     nExt;  // Number of extents
+	uint32     szExt; // Size of extent table
+} VZP_SPACE;
+
+typedef struct {
+	uint32 Chunk;  // Chunk Number
+	uint32 Stamp;  // Last use
+	int    Dirty;  // Not written back yet
+	uint8  *Data;  // Decompressed Data
+} VZP_CHUNK;
+
+struct vzp_File {
+	VZP_FILE  *Next;      // Next open container
+	int       dpFile;     // File Descriptor
+	int       Mode;       // Open Mode
+	int       Level;      // Compression Level
+	uint32    szChunk;    // Chunk Size (uncompressed)
+	off_t     szImage;    // Image Size in Bytes
+	off_t     idxPos;     // Position of Chunk Index
+	uint32    idxLen;     // Length of Chunk Index on file
+	off_t     endPos;     // End of File
+	uint32    nChunks;    // Number of Chunks
+	uint32    szIndex;    // Size of Chunk Index (in entries)
+	int       idxDirty;   // Index not written yet
+	VZP_ENTRY *Index;     // Chunk Index
+	VZP_SPACE Free;       // Free space (reusable)
+	VZP_SPACE Held;       // Space left behind since last index
+	uint8     *zData;     // Compressed Data Buffer
+	uLong     szData;     // Size of Compressed Data Buffer
+	uint32    Stamp;      // Use Counter
+	VZP_CHUNK Cache[VZP_NCACHE];
+	char      fmtName[VZP_FMTSZ];
+
+	pthread_mutex_t Lock;
+};
+
+// All open containers, so that they can be flushed at exit.
+static pthread_mutex_t vzp_ListLock = PTHREAD_MUTEX_INITIALIZER;
+static VZP_FILE        *vzp_List = NULL;
+
+static VZP_FILE *vzp_Alloc(int fd, int mode, uint32 szChunk)
+{
+	VZP_FILE *zp;
+	int      idx;
+
+	if ((zp = (VZP_FILE *)calloc(1, sizeof(VZP_FILE))) == NULL)
+		return NULL;
+	zp->dpFile  = fd;
+	zp->Mode    = mode;
+	zp->Level   = Z_BEST_SPEED;
+	zp->szChunk = szChunk;
+	zp->szData  = compressBound(szChunk);
+	if ((zp->zData = (uint8 *)malloc(zp->szData)) == NULL) {
+		free(zp);
+		return NULL;
+	}
+	for (idx = 0; idx < VZP_NCACHE; idx++)
+		zp->Cache[idx].Chunk = VZP_NOCHUNK;
+	pthread_mutex_init(&zp->Lock, NULL);
+
+	return zp;
+}
+
+static void vzp_Free(VZP_FILE *zp)
+{
+	int idx;
+
+	for (idx = 0; idx < VZP_NCACHE; idx++)
+		if (zp->Cache[idx].Data)
+			free(zp->Cache[idx].Data);
+	if (zp->Index)
+		free(zp->Index);
+	if (zp->Free.Ext)
+		free(zp->Free.Ext);
+	if (zp->Held.Ext)
+		free(zp->Held.Ext);
+	pthread_mutex_destroy(&zp->Lock);
+	free(zp->zData);
+	free(zp);
+}
+
+// Set number of chunks, growing index as needed.
+static int vzp_SetChunks(VZP_FILE *zp, uint32 nChunks)
+{
+	VZP_ENTRY *newIndex;
+	uint32    szIndex;
+
+	if (nChunks > zp->szIndex) {
+		szIndex = zp->szIndex ? zp->szIndex : 64;
+		while (szIndex < nChunks)
+			szIndex *= 2;
+		newIndex = (VZP_ENTRY *)realloc(zp->Index, szIndex * sizeof(VZP_ENTRY));
+		if (newIndex == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		memset(&newIndex[zp->szIndex], 0,
+			(szIndex - zp->szIndex) * sizeof(VZP_ENTRY));
+		zp->Index   = newIndex;
+		zp->szIndex = szIndex;
+	}
+	zp->nChunks = nChunks;
+
+	return 0;
+}
+
+// Add that extent to space, merging it with its neighbors.
+// Space is lost if table can't grow.
+static void vzp_AddSpace(VZP_SPACE *sp, off_t pos, off_t len)
+{
+	VZP_EXTENT *newExt;
+	uint32     idx, szExt;
+
+	if (len == 0)
+		return;
+	for (idx = 0; (idx < sp->nExt) && (sp->Ext[idx].Pos < pos); idx++);
+
+	// Merge with previous and/or next extent.
+	if ((idx > 0) && ((sp->Ext[idx-1].Pos + sp->Ext[idx-1].Len) == pos)) {
+		sp->Ext[idx-1].Len += len;
+		if ((idx < sp->nExt) && ((pos + len) == sp->Ext[idx].Pos)) {
+			sp->Ext[idx-1].Len += sp->Ext[idx].Len;
+			memmove(&sp->Ext[idx], &sp->Ext[idx+1],
+				(--sp->nExt - idx) * sizeof(VZP_EXTENT));
+		}
+		return;
+	}
+	if ((idx < sp->nExt) && ((pos + len) == sp->Ext[idx].Pos)) {
+		sp->Ext[idx].Pos  = pos;
+		sp->Ext[idx].Len += len;
+		return;
+	}
+
+	if (sp->nExt == sp->szExt) {
+		szExt  = sp->szExt ? (sp->szExt * 2) : 64;
+		newExt = (VZP_EXTENT *)realloc(sp->Ext, szExt * sizeof(VZP_EXTENT));
+		if (newExt == NULL)
+			return;
+		sp->Ext   = newExt;
+		sp->szExt = szExt;
+	}
+	memmove(&sp->Ext[idx+1], &sp->Ext[idx],
+		(sp->nExt++ - idx) * sizeof(VZP_EXTENT));
+	sp->Ext[idx].Pos = pos;
+	sp->Ext[idx].Len = len;
+}
+
+// Allocate space from free space (first fit) or end of file.
+static off_t vzp_Allocate(VZP_FILE *zp, uint32 len)
+{
+	VZP_SPACE *sp = &zp->Free;
+	off_t     pos;
+	uint32    idx;
+
+	for (idx = 0; idx < sp->nExt; idx++) {
+		if (sp->Ext[idx].Len < len)
+			continue;
+		pos = sp->Ext[idx].Pos;
+		sp->Ext[idx].Pos += len;
+		if ((sp->Ext[idx].Len -= len) == 0)
+			memmove(&sp->Ext[idx], &sp->Ext[idx+1],
+				(--sp->nExt - idx) * sizeof(VZP_EXTENT));
+		return pos;
+	}
+
+	pos = zp->endPos;
+	zp->endPos += len;
+	return pos;
+}
+
+// New index is on file - held space is free now.  Cut off free
+// space at end of file.
+static void vzp_Release(VZP_FILE *zp)
+{
+	VZP_SPACE *sp = &zp->Free;
+	uint32    idx;
+
+	for (idx = 0; idx < zp->Held.nExt; idx++)
+		vzp_AddSpace(sp, zp->Held.Ext[idx].Pos, zp->Held.Ext[idx].Len);
+	zp->Held.nExt = 0;
+
+	if (sp->nExt &&
+	    ((sp->Ext[sp->nExt-1].Pos + sp->Ext[sp->nExt-1].Len) == zp->endPos) &&
+	    (ftruncate(zp->dpFile, sp->Ext[sp->nExt-1].Pos) == 0))
+		zp->endPos = sp->Ext[--sp->nExt].Pos;
+}
+
+static int vzp_ComparePos(const void *a, const void *b)
+{
+	off_t pa = ((const VZP_EXTENT *)a)->Pos;
+	off_t pb = ((const VZP_EXTENT *)b)->Pos;
+
+	return (pa < pb) ? -1 : (pa > pb);
+}
+
+// Find free space between chunks and index on file.
+static int vzp_FindSpace(VZP_FILE *zp)
+{
+	VZP_EXTENT *ext;
+	off_t      pos = VZP_HDRSZ;
+	uint32     idx, cnt = 0;
+
+	if ((ext = (VZP_EXTENT *)malloc((zp->nChunks + 1) * sizeof(VZP_EXTENT))) == NULL)
+		return -1;
+	for (idx = 0; idx < zp->nChunks; idx++)
+		if (zp->Index[idx].Len) {
+			ext[cnt].Pos   = zp->Index[idx].Pos;
+			ext[cnt++].Len = zp->Index[idx].Len;
+		}
+	ext[cnt].Pos   = zp->idxPos;
+	ext[cnt++].Len = zp->idxLen;
+	qsort(ext, cnt, sizeof(VZP_EXTENT), vzp_ComparePos);
+
+	for (idx = 0; idx < cnt; idx++) {
+		if (ext[idx].Pos > pos)
+			vzp_AddSpace(&zp->Free, pos, ext[idx].Pos - pos);
+		if ((ext[idx].Pos + ext[idx].Len) > pos)
+			pos = ext[idx].Pos + ext[idx].Len;
+	}
+	if (zp->endPos > pos)
+		vzp_AddSpace(&zp->Free, pos, zp->endPos - pos);
+	free(ext);
+
+	return 0;
+}
+
+static int vzp_WriteHeader(VZP_FILE *zp)
+{
+	VZP_HEADER hdr;
+
+	memset(&hdr, 0, sizeof(hdr));
+	strcpy(hdr.Magic, VZP_MAGIC);
+	hdr.Version = VZP_VERSION;
+	hdr.szChunk = zp->szChunk;
+	hdr.szImage = zp->szImage;
+	hdr.idxPos  = zp->idxPos;
+	hdr.nChunks = zp->nChunks;
+	strcpy(hdr.fmtName, zp->fmtName);
+
+	if (pwrite(zp->dpFile, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+		if (errno == 0)
+			errno = ENOSPC;
+		return -1;
+	}
+	return 0;
+}
+
+// Decompress that chunk from file.
+static int vzp_LoadChunk(VZP_FILE *zp, uint32 chunk, uint8 *data)
+{
+	VZP_ENTRY *ent;
+	uLong     szData = zp->szChunk;
+	int       rc;
+
+	if ((chunk >= zp->nChunks) || ((ent = &zp->Index[chunk])->Len == 0)) {
+		memset(data, 0, zp->szChunk);
+		return 0;
+	}
+
+	if (ent->Flags & VZP_RAW) {
+		if ((rc = pread(zp->dpFile, data, zp->szChunk, ent->Pos)) < 0)
+			return -1;
+		if (rc < zp->szChunk) {
+			errno = EIO;
+			return -1;
+		}
+		return 0;
+	}
+
+	if ((ent->Len > zp->szData) ||
+	    ((rc = pread(zp->dpFile, zp->zData, ent->Len, ent->Pos)) < 0))
+		return -1;
+	if ((rc < ent->Len) ||
+	    (uncompress(data, &szData, zp->zData, ent->Len) != Z_OK) ||
+	    (szData != zp->szChunk)) {
+		errno = EIO;
+		return -1;
+	}
+
+	return 0;
+}
+
+// Compress that chunk and write it back.
+static int vzp_PutChunk(VZP_FILE *zp, VZP_CHUNK *cp)
+{
+	VZP_ENTRY *ent = &zp->Index[cp->Chunk];
+	uLong     szData = zp->szData;
+	uint8     *data;
+	uint32    len, flags = 0;
+	off_t     pos;
+
+	if ((cp->Data[0] == 0) && !memcmp(cp->Data, cp->Data + 1, zp->szChunk - 1)) {
+		// Chunk of zeros - nothing to store.
+		pos = 0;
+		len = 0;
+	} else {
+		if ((compress2(zp->zData, &szData, cp->Data, zp->szChunk,
+		    zp->Level) == Z_OK) && (szData < zp->szChunk)) {
+			data = zp->zData;
+			len  = szData;
+		} else {
+			data  = cp->Data;
+			len   = zp->szChunk;
+			flags = VZP_RAW;
+		}
+
+		// Never write over old chunk - index on file
+		// still refers to it.
+		pos = vzp_Allocate(zp, len);
+		if (pwrite(zp->dpFile, data, len, pos) != len) {
+			vzp_AddSpace(&zp->Held, pos, len);
+			if (errno == 0)
+				errno = ENOSPC;
+			return -1;
+		}
+	}
+
+	// Old chunk is free after next index.
+	if (ent->Len)
+		vzp_AddSpace(&zp->Held, ent->Pos, ent->Len);
+	ent->Pos   = pos;
+	ent->Len   = len;
+	ent->Flags = flags;
+	zp->idxDirty = 1;
+	cp->Dirty    = 0;
+
+	return 0;
+}
+
+// Find that chunk in cache, or replace least recently used
+// chunk with it.  Chunk is not read if it will be overwritten.
+static VZP_CHUNK *vzp_GetChunk(VZP_FILE *zp, uint32 chunk, int load)
+{
+	VZP_CHUNK *cp = NULL;
+	int       idx;
+
+	for (idx = 0; idx < VZP_NCACHE; idx++) {
+		if (zp->Cache[idx].Chunk == chunk) {
+			cp = &zp->Cache[idx];
+			cp->Stamp = ++zp->Stamp;
+			return cp;
+		}
+		if ((cp == NULL) || (zp->Cache[idx].Stamp < cp->Stamp))
+			cp = &zp->Cache[idx];
+	}
+
+	if (cp->Dirty && vzp_PutChunk(zp, cp))
+		return NULL;
+	if ((cp->Data == NULL) &&
+	    ((cp->Data = (uint8 *)malloc(zp->szChunk)) == NULL)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	cp->Chunk = VZP_NOCHUNK;
+	if (load && vzp_LoadChunk(zp, chunk, cp->Data))
+		return NULL;
+	cp->Chunk = chunk;
+	cp->Stamp = ++zp->Stamp;
+
+	return cp;
+}
+
+static int vzp_FlushLocked(VZP_FILE *zp)
+{
+	uint32 szIndex;
+	off_t  pos, oldPos;
+	int    idx;
+
+	for (idx = 0; idx < VZP_NCACHE; idx++)
+		if (zp->Cache[idx].Dirty && vzp_PutChunk(zp, &zp->Cache[idx]))
+			return -1;
+
+	if (zp->idxDirty) {
+		// Write new index apart from old one, and sync chunks
+		// and index before header points to it.
+		szIndex = zp->nChunks * sizeof(VZP_ENTRY);
+		pos     = vzp_Allocate(zp, szIndex);
+		if ((pwrite(zp->dpFile, zp->Index, szIndex, pos) != szIndex) ||
+		    fdatasync(zp->dpFile)) {
+			vzp_AddSpace(&zp->Held, pos, szIndex);
+			if (errno == 0)
+				errno = ENOSPC;
+			return -1;
+		}
+		oldPos     = zp->idxPos;
+		zp->idxPos = pos;
+		if (vzp_WriteHeader(zp) || fdatasync(zp->dpFile)) {
+			// Header may point to either index now.
+			zp->idxPos = oldPos;
+			vzp_AddSpace(&zp->Held, pos, szIndex);
+			return -1;
+		}
+
+		// Old chunks and index may be reused now.
+		vzp_AddSpace(&zp->Held, oldPos, zp->idxLen);
+		zp->idxLen   = szIndex;
+		zp->idxDirty = 0;
+		vzp_Release(zp);
+	}
+
+	return 0;
+}
+
+// ********************************************************************
+
+// Check that file for container.  If so, return its descriptor in
+// *zpp, otherwise return NULL in *zpp.  Return errno for errors.
+int vzp_Open(int fd, int mode, VZP_FILE **zpp)
+{
+	VZP_HEADER  hdr;
+	VZP_FILE    *zp;
+	struct stat st;
+	uint32      szIndex;
+
+	*zpp = NULL;
+	if ((pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) ||
+	    strncmp(hdr.Magic, VZP_MAGIC, sizeof(hdr.Magic)))
+		return 0;
+	if ((hdr.Version != VZP_VERSION) || (hdr.szChunk == 0) ||
+	    (hdr.szChunk > VZP_MAXCHUNK) ||
+	    (((hdr.szImage + hdr.szChunk - 1) / hdr.szChunk) != hdr.nChunks))
+		return EINVAL;
+	if (fstat(fd, &st) < 0)
+		return errno;
+
+	if ((zp = vzp_Alloc(fd, mode, hdr.szChunk)) == NULL)
+		return ENOMEM;
+	zp->szImage = hdr.szImage;
+	zp->idxPos  = hdr.idxPos;
+	zp->idxLen  = hdr.nChunks * sizeof(VZP_ENTRY);
+	zp->endPos  = st.st_size;
+	hdr.fmtName[VZP_FMTSZ - 1] = '\0';
+	strcpy(zp->fmtName, hdr.fmtName);
+
+	// Load chunk index.
+	szIndex = hdr.nChunks * sizeof(VZP_ENTRY);
+	if (vzp_SetChunks(zp, hdr.nChunks)) {
+		vzp_Free(zp);
+		return ENOMEM;
+	}
+	if (szIndex &&
+	    (pread(fd, zp->Index, szIndex, hdr.idxPos) != szIndex)) {
+		vzp_Free(zp);
+		return EINVAL;
+	}
+	if ((mode == VZP_RDWR) && vzp_FindSpace(zp)) {
+		vzp_Free(zp);
+		return ENOMEM;
+	}
+
+	pthread_mutex_lock(&vzp_ListLock);
+	zp->Next = vzp_List;
+	vzp_List = zp;
+	pthread_mutex_unlock(&vzp_ListLock);
+
+	*zpp = zp;
+	return 0;
+}
+
+// Write back container and release it.  File is not closed.
+int vzp_Close(VZP_FILE *zp)
+{
+	VZP_FILE **pzp;
+	int      rc;
+
+	pthread_mutex_lock(&vzp_ListLock);
+	for (pzp = &vzp_List; *pzp; pzp = &(*pzp)->Next)
+		if (*pzp == zp) {
+			*pzp = zp->Next;
+			break;
+		}
+	pthread_mutex_unlock(&vzp_ListLock);
+
+	rc = vzp_Flush(zp);
+	vzp_Free(zp);
+
+	return rc;
+}
+
+int vzp_Flush(VZP_FILE *zp)
+{
+	int rc;
+
+	pthread_mutex_lock(&zp->Lock);
+	rc = vzp_FlushLocked(zp);
+	pthread_mutex_unlock(&zp->Lock);
+
+	return rc;
+}
+
+// Write back all open containers (at exit).
+void vzp_FlushAll(void)
+{
+	VZP_FILE *zp;
+
+	pthread_mutex_lock(&vzp_ListLock);
+	for (zp = vzp_List; zp; zp = zp->Next)
+		vzp_Flush(zp);
+	pthread_mutex_unlock(&vzp_ListLock);
+}
+
+// Read data from image like pread.  Return number of bytes,
+// which is short at end of image, or -1 for errors.
+int vzp_Read(VZP_FILE *zp, void *data, uint32 len, off_t pos)
+{
+	VZP_CHUNK *cp;
+	uint32    off, cnt, idx;
+
+	pthread_mutex_lock(&zp->Lock);
+	if (pos >= zp->szImage)
+		len = 0;
+	else if (len > (zp->szImage - pos))
+		len = zp->szImage - pos;
+
+	for (idx = 0; idx < len; idx += cnt, pos += cnt) {
+		off = pos % zp->szChunk;
+		cnt = zp->szChunk - off;
+		if (cnt > (len - idx))
+			cnt = len - idx;
+		if ((cp = vzp_GetChunk(zp, pos / zp->szChunk, 1)) == NULL) {
+			pthread_mutex_unlock(&zp->Lock);
+			return -1;
+		}
+		memcpy((uint8 *)data + idx, &cp->Data[off], cnt);
+	}
+	pthread_mutex_unlock(&zp->Lock);
+
+	return len;
+}
+
+// Write data to image like pwrite.  Image grows if written
+// beyond its end.  Data are written back later.
+int vzp_Write(VZP_FILE *zp, void *data, uint32 len, off_t pos)
+{
+	VZP_CHUNK *cp;
+	uint32    off, cnt, idx;
+
+	if (zp->Mode != VZP_RDWR) {
+		errno = EBADF;
+		return -1;
+	}
+
+	pthread_mutex_lock(&zp->Lock);
+	if ((pos + len) > zp->szImage) {
+		if (vzp_SetChunks(zp, (pos + len + zp->szChunk - 1) / zp->szChunk)) {
+			pthread_mutex_unlock(&zp->Lock);
+			return -1;
+		}
+		zp->szImage  = pos + len;
+		zp->idxDirty = 1;
+	}
+
+	for (idx = 0; idx < len; idx += cnt, pos += cnt) {
+		off = pos % zp->szChunk;
+		cnt = zp->szChunk - off;
+		if (cnt > (len - idx))
+			cnt = len - idx;
+		if ((cp = vzp_GetChunk(zp, pos / zp->szChunk, cnt < zp->szChunk)) == NULL) {
+			pthread_mutex_unlock(&zp->Lock);
+			return -1;
+		}
+		memcpy(&cp->Data[off], (uint8 *)data + idx, cnt);
+		cp->Dirty = 1;
+	}
+	pthread_mutex_unlock(&zp->Lock);
+
+	return len;
+}
+
+off_t vzp_GetSize(VZP_FILE *zp)
+{
+	return zp->szImage;
+}
+
+// Return format name of image (empty if not known).
+char *vzp_GetFormat(VZP_FILE *zp)
+{
+	return zp->fmtName;
+}
+
+// Compress that image into a new container.  Return errno for errors.
+int vzp_Compress(char *fileName, char *imgName)
+{
+	VZP_FILE *zp;
+	uint8    *data;
+	char     *p;
+	off_t    pos = 0;
+	int      ifd, ofd, rc;
+
+	if ((ifd = open(imgName, O_RDONLY)) < 0)
+		return errno;
+	if ((ofd = open(fileName, O_RDWR|O_CREAT|O_EXCL, 0700)) < 0) {
+		rc = errno;
+		close(ifd);
+		return rc;
+	}
+	if ((zp = vzp_Alloc(ofd, VZP_RDWR, VZP_CHUNKSZ)) == NULL) {
+		close(ifd);
+		close(ofd);
+		unlink(fileName);
+		return ENOMEM;
+	}
+	zp->Level    = Z_BEST_COMPRESSION;
+	zp->endPos   = VZP_HDRSZ;
+	zp->idxDirty = 1;
+	if ((p = strrchr(imgName, '.')) && (strlen(p + 1) < VZP_FMTSZ))
+		strcpy(zp->fmtName, p + 1);
+
+	if ((data = (uint8 *)malloc(zp->szChunk)) == NULL)
+		rc = -1, errno = ENOMEM;
+	else {
+		while ((rc = pread(ifd, data, zp->szChunk, pos)) > 0) {
+			if (vzp_Write(zp, data, rc, pos) < 0) {
+				rc = -1;
+				break;
+			}
+			pos += rc;
+		}
+		free(data);
+	}
+	rc = (rc < 0) ? errno : 0;
+
+	// Write index and header.
+	if (vzp_Close(zp) && (rc == 0))
+		rc = errno;
+	close(ifd);
+	close(ofd);
+	if (rc)
+		unlink(fileName);
+
+	return rc;
+}
+
+// Usage: compress <file> <image>
+int CmdCompress(void *dev, int argc, char **argv)
+{
+	int rc;
+
+	if (argc != 3) {
+		printf("Usage: %s <file> <image>\n", argv[0]);
+		return EMU_OK;
+	}
+
+	if (rc = vzp_Compress(argv[1], argv[2])) {
+		printf("%s: Can't compress '%s' into '%s' - %s.\n", argv[0],
+			argv[2], argv[1], strerror(rc));
+		return EMU_OK;
+	}
+	printf("%s: Image '%s' compressed into '%s'.\n", argv[0], argv[2], argv[1]);
+
+	return EMU_OK;
+}
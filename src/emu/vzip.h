@@ -0,0 +1,54 @@
+// vzip.h - Compressed Image Container Support Routines
+//
+// Copyright (c) 2002, Timothy M. Stark
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// TIMOTHY M STARK BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Timothy M Stark shall not
+// be used in advertising or otherwise to promote the sale, use or other
+// dealings in this Software without prior written authorization from
+// Timothy M Stark.
+
+#ifndef _VZIP_H
+#define _VZIP_H
+
+#define VZP_MAGIC    "TS10VZP"
+#define VZP_VERSION  1
+#define VZP_CHUNKSZ  (64 * 1024)  // Default chunk size (uncompressed)
+#define VZP_MAXCHUNK (16 << 20)   // Maximum chunk size
+#define VZP_NCACHE   16           // Decompressed chunks per container
+#define VZP_FMTSZ    16           // Size of format name
+
+// Open Modes
+#define VZP_RDONLY   0  // Read only
+#define VZP_RDWR     1  // Read and write-back
+
+typedef struct vzp_File VZP_FILE;
+
+// External function calls
+int   vzp_Open(int, int, VZP_FILE **);
+int   vzp_Close(VZP_FILE *);
+int   vzp_Flush(VZP_FILE *);
+void  vzp_FlushAll(void);
+int   vzp_Read(VZP_FILE *, void *, uint32, off_t);
+int   vzp_Write(VZP_FILE *, void *, uint32, off_t);
+off_t vzp_GetSize(VZP_FILE *);
+char  *vzp_GetFormat(VZP_FILE *);
+int   vzp_Compress(char *, char *);
+
+#endif /* _VZIP_H */
@@ -5204,6 +5204,9 @@ int p10_Go(MAP_DEVICE *map)
 		}
 	}
 
+	// Check interrupt requests before first instruction.
+	ts10_CutBatch();
+
 	while (p10_State == EMU_RUN) {
 		pager_PC = PC; // Save base address for trap.
 		cpu_pFlags &= CPU_CYCLE_PI;  // Reset process flags.
@@ -5216,12 +5219,15 @@ int p10_Go(MAP_DEVICE *map)
 
 		// ACTION: Need that to being set by timer.
 
-		if (ts10_ClkInterval-- <= 0)
+		// Interrupt requests end current batch of
+		// instructions so that they are checked here only.
+		if (ts10_ClkInterval-- <= 0) {
 			ts10_ExecuteTimer();
 
-		if (KX10_IntrQ) {
-			KX10_piProcess();
-			continue;
+			if (KX10_IntrQ) {
+				KX10_piProcess();
+				continue;
+			}
 		}
 
 		p10_Execute(PC, 0);
@@ -276,7 +276,7 @@ void dte20_ctyCharOut(DTE_DEVICE *dte20, uchar ch)
 {
 	if (dte20->ctySocket) {
 		ch &= 0177;
-		sock_Print(dte20->ctySocket, (char *)&ch, 1);
+		sock_Output(dte20->ctySocket, (char *)&ch, 1);
 
 		// Log a character into a log file.
 		if (ch == '\n') {
@@ -308,7 +308,7 @@ void dte20_ctyStrOut(DTE_DEVICE *dte, uchar *out, int len)
 #endif /* DEBUG */
 
 	if (dte->ctySocket) {
-		sock_Print(dte->ctySocket, (char *)out, len);
+		sock_Output(dte->ctySocket, (char *)out, len);
 
 #ifdef DEBUG
 		for (idx = 0; idx < len; idx++) {
@@ -117,6 +117,8 @@ void KL10pi_Evaluate(void)
 			KX10_IntrQ = reqlvl;
 		}
 	}
+	if (KX10_IntrQ)
+		ts10_CutBatch();
 }
 
 void KL10pi_RequestAPR(int pi)
@@ -619,7 +619,7 @@ void p10_ConsoleOutput(P10_CONSOLE *cty)
 	if (cty->ctySocket && *cty->ctyOutWord) {
 		if (*cty->ctyOutFlag == CTY_PENDING) {
 			ch = *cty->ctyOutChar & 0177;
-			sock_Print(cty->ctySocket, &ch, 1);
+			sock_Output(cty->ctySocket, &ch, 1);
 
 			// Log a character into a log file.
 			if (ch == '\n') {
@@ -653,7 +653,7 @@ void p10_ConsoleOutput(P10_CONSOLE *cty)
 			case CTY_PENDING:
 				// Print a character on terminal
 				ch = *cty->kluOutChar & 0177;
-				sock_Print(cty->kluSocket, &ch, 1);
+				sock_Output(cty->kluSocket, &ch, 1);
 
 				// Log a character into a log file.
 				if (ch == '\n') {
@@ -852,9 +852,7 @@ int ks10_BootDisk(UQ_BOOT *bt, int argc, char **argv)
 	printf("Reading FE-FILE Page 0 at block %d (Cyl %d Trk %d Sec %d)...\n",
 		dskAddr, dskCylinder, dskTrack, dskSector);
 
-	vdk_SeekDisk(vdk, dskAddr);
-	for (idx = 0; idx < 4; idx++)
-		vdk_ReadDisk(vdk, (uint8 *)&inBlock[idx * 256], VDK_18B);
+	vdk_ReadBlocks(vdk, dskAddr, (uint8 *)inBlock, 4, VDK_18B);
 
 #ifdef DEBUG
 	if (dbg_Check(DBG_IODATA)) {
@@ -884,9 +882,7 @@ int ks10_BootDisk(UQ_BOOT *bt, int argc, char **argv)
 	printf("Reading Pre-boot loader at block %d (Cyl %d Trk %d Sec %d)...\n",
 		dskAddr, dskCylinder, dskTrack, dskSector);
 
-	vdk_SeekDisk(vdk, dskAddr);
-	for (idx = 0; idx < 4; idx++)
-		vdk_ReadDisk(vdk, (uint8 *)&inBlock[idx * 256], VDK_18B);
+	vdk_ReadBlocks(vdk, dskAddr, (uint8 *)inBlock, 4, VDK_18B);
 
 #ifdef DEBUG
 	if (dbg_Check(DBG_IODATA)) {
@@ -146,6 +146,8 @@ void KS10_piEvaluate(void)
 		if ((actlvl == 0) || (reqlvl < actlvl))
 			KX10_IntrQ = reqlvl;
 	}
+	if (KX10_IntrQ)
+		ts10_CutBatch();
 }
 
 void KS10_piRequestIO(int pi)
@@ -78,7 +78,7 @@ void p10_HandleTimer(int x)
 	}
 
 #ifndef HAVE_SIGACTION
-	signal(SIGALRM, p10_HandleTimer);
+	ts10_SetAlarm(p10_HandleTimer);
 #endif /* HAVE_SIGACTION */
 }
 
@@ -228,6 +228,10 @@ inline void p11_FromTrap(register P11_CPU *p11, cchar *name)
 	// Update Interrupt Requests
 	uq11_EvalIRQ(p11, GET_IPL(PSW));
 
+	// Check trace for next instruction.
+	if (PSW & PSW_T)
+		ts10_CutBatch();
+
 #ifdef DEBUG
 	if (dbg_Check(DBG_TRACE|DBG_DATA)) {
 		dbg_Printf("%s: (%s) Old PC %06o PSW %06o Mode: (%d,%d)\n",
@@ -1620,6 +1624,7 @@ INSDEF(p11, WAIT)
 {
 	if (PSW_GETCUR(PSW) == AM_KERNEL) {
 		IDLE = 1;
+		ts10_CutBatch();
 #ifdef DEBUG
 		if (dbg_Check(DBG_TRACE|DBG_DATA) || dbg_Check(DBG_INTERRUPT))
 			dbg_Printf("%s: Entered Wait State at PC %06o.\n",
@@ -1812,24 +1817,36 @@ void p11_Execute(register P11_CPU *p11)
 		}
 	}
 
+	// Check all requests before first instruction.
+	ts10_CutBatch();
+
 	while (emu_State == P11_RUN) {
-		if (ts10_ClkInterval-- <= 0)
+		// Interrupt, trap and trace requests end current
+		// batch so that they are checked here only.
+		if (ts10_ClkInterval-- <= 0) {
 			ts10_ExecuteTimer();
 
-		// If any interrupt/trap requests,
-		// do them right now.
-		if (TIRQ) {
-			p11_DoTraps(p11);
-			continue;
-		}
-		if (PSW & PSW_T)
-			SET_TRAP(TRAP_TRC);
-
-		// Current wait state
-		if (IDLE) {
-			if (ts10_SimClock != NULL)
-				ts10_ClkInterval = 0;
-			continue;
+			// If any interrupt/trap requests,
+			// do them right now.  Check trace
+			// again for new PSW.
+			if (TIRQ) {
+				p11_DoTraps(p11);
+				ts10_CutBatch();
+				continue;
+			}
+			if (PSW & PSW_T)
+				SET_TRAP(TRAP_TRC);
+
+			// Current wait state.  Skip forward to
+			// next timer event if any, otherwise stay
+			// here until interrupt request.
+			if (IDLE) {
+				if (ts10_SimClock != NULL)
+					ts10_SkipTimer();
+				else
+					ts10_CutBatch();
+				continue;
+			}
 		}
 
 #ifdef DEBUG
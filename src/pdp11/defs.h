@@ -317,7 +317,7 @@
 
 #define SET_CPUERR(cpue) CPUERR |= (cpue)
 #define CLR_CPUERR(cpue) CPUERR &= ~(cpue)
-#define SET_TRAP(tirq)   TIRQ |= (tirq)
+#define SET_TRAP(tirq)   TIRQ |= (tirq), ts10_CutBatch()
 #define CLR_TRAP(tirq)   TIRQ &= ~(tirq)
 #define ABORT(why)       longjmp(p11->SetJump, why)
 
@@ -75,6 +75,7 @@ void uq11_EvalIRQ(register P11_CPU *p11, uint32 ipl)
 	for (idx = IPL_HLVL - 1; idx > ipl; idx--) {
 		if (uq->intReqs[idx] || ((int16)pirq < 0)) {
 			TIRQ |= TRAP_INT;
+			ts10_CutBatch();
 			return;
 		}
 		pirq <<= 1;
@@ -310,6 +311,49 @@ uint32 uq11_WriteBlock(void *dptr, uint32 ioAddr, uint8 *data,
 	return szBytes;
 }
 
+// Map block of Unibus/QBus addresses to host memory for direct
+// transfers.  Return number of bytes mapped (less than requested
+// if any block is not in memory) and number of entries in
+// scatter/gather list.
+uint32 uq11_MapBlock(void *dptr, uint32 ioAddr, uint32 szBytes,
+	UQ_IOVEC *iov, int *nVecs)
+{
+	P11_CPU *p11 = (P11_CPU *)dptr;
+	UQ_IO   *uq  = p11->uqba;
+	uint32  mapAddr, cntBytes, szMapped = 0;
+	uint8   *hstAddr;
+	int     maxVecs = *nVecs, idx = 0;
+
+	cntBytes = UBM_BLKSZ - (ioAddr & UBM_BLKOFF);
+	if (szBytes < cntBytes)
+		cntBytes = szBytes;
+
+	while (szBytes) {
+		mapAddr = uq11_MapAddr(uq, ioAddr);
+		if ((mapAddr + cntBytes) > p11->ramSize)
+			break;
+
+		// Merge adjacent blocks into one entry.
+		hstAddr = &((uint8 *)p11->ramData)[mapAddr];
+		if (idx && (((uint8 *)iov[idx-1].iov_base + iov[idx-1].iov_len) == hstAddr))
+			iov[idx-1].iov_len += cntBytes;
+		else if (idx < maxVecs) {
+			iov[idx].iov_base  = hstAddr;
+			iov[idx++].iov_len = cntBytes;
+		} else
+			break;
+
+		// Increment them by 512-bytes block.
+		ioAddr   += cntBytes;
+		szMapped += cntBytes;
+		szBytes  -= cntBytes;
+		cntBytes  = (szBytes > UBM_BLKSZ) ? UBM_BLKSZ : szBytes;
+	}
+
+	*nVecs = idx;
+	return szMapped;
+}
+
 int uq11_ReadIO(register UQ_IO *uq, uint32 pAddr, uint16 *data, uint32 size)
 {
 	uint32 ioAddr = pAddr & IO_MASK;
@@ -519,6 +563,10 @@ UQ_CALL uq11_Callback =
 	NULL,              // Get Host Address
 
 	uq11_SetMap,       // SetMap Routine
+	NULL,              // Boot Routine
+
+	uq11_MapBlock,     // Map Block for DMA
+	NULL,              // Sync Block after DMA
 };
 
 // PDP-11 Unibus/QBus Device
@@ -0,0 +1,356 @@
+// cpu_block.c - VAX Call-Threaded Instruction Blocks for x86-64 Hosts
+//
+// Copyright (c) 2002, Timothy M. Stark
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// TIMOTHY M STARK BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Timothy M Stark shall not
+// be used in advertising or otherwise to promote the sale, use or other 
+// dealings in this Software without prior written authorization from
+// Timothy M Stark.
+
+#include "vax/defs.h"
+
+#ifdef VAX_BLOCKS
+
+#ifndef __x86_64__
+#error "cpu_block.c emits x86-64 host code only."
+#endif
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+extern int32 ts10_ClkInterval;
+
+// Host Code for Call-Threaded Blocks
+//
+// Host code does not emulate instructions by itself, so this is not
+// a compiler.  It replays each decoded instruction and calls its
+// handler directly, so that fetch, cache lookup and dispatch are gone
+// from hot loops:
+//
+//   push  %rbx                 Save VAX CPU pointer
+//   mov   %rdi, %rbx
+//
+// For each instruction in block:
+//
+//   mov   %rbx, %rdi
+//   mov   $blk, %rsi
+//   mov   $idx, %edx
+//   mov   $vax_BlockStep, %rax
+//   call  *%rax                Check events and decode specifiers
+//   test  %eax, %eax
+//   jz    exit                 Leave to interpreter
+//   mov   %rbx, %rdi
+//   mov   $handler, %rax
+//   call  *%rax                Execute instruction
+//
+// At end of block, unless last instruction changes mapping or mode
+// (MTPR, REI, LDPCTX, etc.) and interpreter has to look at new PC:
+//
+//   mov   %rbx, %rdi
+//   mov   $blk, %rsi
+//   mov   $vax_BlockChain, %rax
+//   call  *%rax                Look up next block
+//   test  %rax, %rax
+//   jz    exit
+//   pop   %rbx
+//   jmp   *%rax                Continue with next block
+// exit:
+//   pop   %rbx
+//   ret
+//
+// Faults within handlers go back to vax_Execute through longjmp
+// as usual.  Code buffer is only flushed from the interpreter, never
+// while host code is running.
+//
+// Code buffer is never writable and executable at the same time.
+// Pages are made writable only while a block is being emitted into
+// them, then made executable again before host code can run.
+
+#define BLK_MAXCODE  ((BLK_MAXINST * 64) + 64) // Maximum code per block
+
+#define EMIT1(val)  *cp++ = (uint8)(val)
+#define EMIT4(val)  { uint32 d = (val); memcpy(cp, &d, 4); cp += 4; }
+#define EMIT8(val)  { uint64 q = (uint64)(val); memcpy(cp, &q, 8); cp += 8; }
+
+#define EMIT_MOVRDIRBX  EMIT1(0x48); EMIT1(0x89); EMIT1(0xDF)
+#define EMIT_MOVRSI(v)  EMIT1(0x48); EMIT1(0xBE); EMIT8(v)
+#define EMIT_MOVEDX(v)  EMIT1(0xBA); EMIT4(v)
+#define EMIT_CALL(f)    EMIT1(0x48); EMIT1(0xB8); EMIT8(f); \
+                        EMIT1(0xFF); EMIT1(0xD0)
+
+// Change protection of code buffer pages covering 'len' bytes
+// at offset 'off'.  Return zero if that failed.
+static int vax_BlockProtect(register VAX_CPU *vax, uint32 off, uint32 len, int prot)
+{
+	uint32 pgsz  = sysconf(_SC_PAGESIZE);
+	uint32 start = off & ~(pgsz - 1);
+	uint32 end   = (off + len + pgsz - 1) & ~(pgsz - 1);
+
+	if (end > BLK_CODESIZE)
+		end = BLK_CODESIZE;
+	return mprotect(vax->blkCode + start, end - start, prot) == 0;
+}
+
+// Check pending events and replay next instruction in block.
+// Return zero to leave host code without executing it.
+static int vax_BlockStep(register VAX_CPU *vax, VAX_BLOCK *blk, int idx)
+{
+	ICENTRY *ic = &blk->Inst[idx];
+
+	if ((emu_State != VAX_RUN) || (ts10_ClkInterval <= 0) || TIR ||
+	    (PSL & (PSL_TP|PSL_FPD|PSW_T)))
+		return 0;
+
+	// Leave if instructions were changed or if last
+	// instruction went elsewhere (exceptions, etc.)
+	if (blk->gen != vax->icPages[blk->ppc >> VA_N_OFF])
+		return 0;
+	if (idx == 0)
+		vax->blkBase = PC;
+	else if (PC != (vax->blkBase + (ic->ppc - blk->ppc)))
+		return 0;
+
+	ts10_ClkInterval--;
+	faultPC = PC;
+	RQPTR   = 0;
+	vax->ips++;
+	vax->blkCount++;
+
+	vax_ReplayInst(vax, ic);
+	return 1;
+}
+
+// Return host code for block at current PC to chain into.
+static uint8 *vax_BlockChain(register VAX_CPU *vax, VAX_BLOCK *blk)
+{
+	VAX_BLOCK *next = blk->Link;
+	uint32   ppc   = vax_GetPhysPC(vax);
+
+	if ((next == NULL) || (next->ppc != ppc) || (next->Code == NULL)) {
+		if (ppc >= vax->sizeRAM)
+			return NULL;
+		next = &vax->blkTable[BLK_INDEX(ppc)];
+		if ((next->ppc != ppc) || (next->Code == NULL))
+			return NULL;
+		blk->Link = next;
+	}
+	if (next->gen != vax->icPages[ppc >> VA_N_OFF])
+		return NULL;
+
+	return next->Code;
+}
+
+// Build block from decoded instruction cache and translate it.
+static int vax_BlockTranslate(register VAX_CPU *vax, VAX_BLOCK *blk)
+{
+	uint32  ppc  = blk->ppc;
+	uint32  gen  = blk->gen;
+	uint32  page = ppc >> VA_N_OFF;
+	uint32  exits[BLK_MAXINST];
+	uint8   *cp;
+	ICENTRY *ic;
+	uint16  opcode;
+	int     idx;
+
+	// Make room in code buffer first.
+	if ((vax->blkUsed + BLK_MAXCODE) > BLK_CODESIZE) {
+		vax_BlockFlush(vax);
+		blk->ppc = ppc;
+		blk->gen = gen;
+	}
+
+	// Collect instructions up to first jump or end of page.
+	// Restartable and emulated instructions are left to the
+	// interpreter.  Jumps include MTPR, REI and LDPCTX, so
+	// that no block runs on with old mapping or mode.
+	blk->nInst = 0;
+	while (blk->nInst < BLK_MAXINST) {
+		ic = &vax->icTable[IC_INDEX(ppc)];
+		if ((ic->ppc != ppc) || (ic->gen != gen))
+			break;
+		opcode = ic->opCode;
+		if (vax->tblFlags[opcode] & (ISTR_FPD|ISTR_EMULATE))
+			break;
+		blk->Inst[blk->nInst++] = *ic;
+		if (vax->tblFlags[opcode] & ISTR_JUMP)
+			break;
+		ppc += ic->nLength;
+		if ((ppc >> VA_N_OFF) != page)
+			break;
+	}
+	if (blk->nInst == 0) {
+		blk->nCount = 0;
+		return 0;
+	}
+
+	// Emit host code.
+	if (!vax_BlockProtect(vax, vax->blkUsed, BLK_MAXCODE, PROT_READ|PROT_WRITE)) {
+		blk->nInst  = 0;
+		blk->nCount = 0;
+		return 0;
+	}
+	cp = blk->Code = vax->blkCode + vax->blkUsed;
+
+	EMIT1(0x53);                            // push %rbx
+	EMIT1(0x48); EMIT1(0x89); EMIT1(0xFB);  // mov  %rdi, %rbx
+
+	for (idx = 0; idx < blk->nInst; idx++) {
+		opcode = blk->Inst[idx].opCode;
+
+		EMIT_MOVRDIRBX;
+		EMIT_MOVRSI(blk);
+		EMIT_MOVEDX(idx);
+		EMIT_CALL(vax_BlockStep);
+		EMIT1(0x85); EMIT1(0xC0);               // test %eax, %eax
+		EMIT1(0x0F); EMIT1(0x84); EMIT4(0);     // jz   exit
+		exits[idx] = cp - blk->Code;
+		EMIT_MOVRDIRBX;
+		EMIT_CALL(vax->tblOpcode[opcode]);
+	}
+
+	// Chain into next block unless context was changed.
+	opcode = blk->Inst[blk->nInst - 1].opCode;
+	if ((vax->tblFlags[opcode] & ISTR_CONTEXT) == 0) {
+		EMIT_MOVRDIRBX;
+		EMIT_MOVRSI(blk);
+		EMIT_CALL(vax_BlockChain);
+		EMIT1(0x48); EMIT1(0x85); EMIT1(0xC0);  // test %rax, %rax
+		EMIT1(0x74); EMIT1(0x03);               // jz   exit
+		EMIT1(0x5B);                            // pop  %rbx
+		EMIT1(0xFF); EMIT1(0xE0);               // jmp  *%rax
+	}
+	EMIT1(0x5B);                            // exit: pop %rbx
+	EMIT1(0xC3);                            // ret
+
+	// Resolve exits to leave host code.
+	for (idx = 0; idx < blk->nInst; idx++) {
+		uint32 rel = (cp - 2 - blk->Code) - exits[idx];
+		memcpy(blk->Code + exits[idx] - 4, &rel, 4);
+	}
+
+	if (!vax_BlockProtect(vax, vax->blkUsed, BLK_MAXCODE, PROT_READ|PROT_EXEC)) {
+		blk->Code   = NULL;
+		blk->nInst  = 0;
+		blk->nCount = 0;
+		return 0;
+	}
+	__builtin___clear_cache((char *)blk->Code, (char *)cp);
+	vax->blkUsed += cp - blk->Code;
+
+	return 1;
+}
+
+// Run translated code for current PC.  Count executions of blocks
+// not translated yet.  Return non-zero if any instruction was
+// executed by host code.
+int vax_BlockExecute(register VAX_CPU *vax)
+{
+	VAX_BLOCK *blk;
+	uint32   ppc;
+
+#ifdef DEBUG
+	// Breakpoints and traces are left to the interpreter.
+	if (vax->Breaks.Switch || dbg_Check(DBG_TRACE|DBG_REGISTER))
+		return 0;
+#endif /* DEBUG */
+
+	if ((vax->blkTable == NULL) || (PSL & PSL_FPD))
+		return 0;
+	ppc = vax_GetPhysPC(vax);
+	if (ppc >= vax->sizeRAM)
+		return 0;
+
+	blk = &vax->blkTable[BLK_INDEX(ppc)];
+	if ((blk->ppc != ppc) || (blk->gen != vax->icPages[ppc >> VA_N_OFF])) {
+		// Take over entry for new block or
+		// for instructions which were changed.
+		blk->ppc    = ppc;
+		blk->gen    = vax->icPages[ppc >> VA_N_OFF];
+		blk->nCount = 0;
+		blk->nInst  = 0;
+		blk->Code   = NULL;
+		blk->Link   = NULL;
+	}
+
+	if (blk->Code == NULL) {
+		if (++blk->nCount < BLK_THRESHOLD)
+			return 0;
+		if (vax_BlockTranslate(vax, blk) == 0)
+			return 0;
+	}
+
+	vax->blkCount = 0;
+	((void (*)(VAX_CPU *))blk->Code)(vax);
+
+	return vax->blkCount > 0;
+}
+
+// Allocate block table and host code buffer.
+void vax_BlockInit(VAX_CPU *vax)
+{
+	void *code;
+
+	vax_BlockRelease(vax);
+
+	code = mmap(NULL, BLK_CODESIZE, PROT_READ|PROT_EXEC,
+		MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (code == MAP_FAILED) {
+		printf("VAX: Can't allocate translation buffer - blocks disabled.\n");
+		return;
+	}
+
+	vax->blkTable = (VAX_BLOCK *)calloc(BLK_TABLE, sizeof(VAX_BLOCK));
+	if (vax->blkTable == NULL) {
+		munmap(code, BLK_CODESIZE);
+		return;
+	}
+	vax->blkCode = (uint8 *)code;
+	vax_BlockFlush(vax);
+}
+
+void vax_BlockRelease(VAX_CPU *vax)
+{
+	if (vax->blkTable)
+		free(vax->blkTable);
+	if (vax->blkCode)
+		munmap(vax->blkCode, BLK_CODESIZE);
+
+	vax->blkTable = NULL;
+	vax->blkCode  = NULL;
+	vax->blkUsed  = 0;
+}
+
+// Discard all translated blocks.
+void vax_BlockFlush(VAX_CPU *vax)
+{
+	int idx;
+
+	if (vax->blkTable == NULL)
+		return;
+	for (idx = 0; idx < BLK_TABLE; idx++) {
+		vax->blkTable[idx].ppc    = IC_NONE;
+		vax->blkTable[idx].nCount = 0;
+		vax->blkTable[idx].Code   = NULL;
+		vax->blkTable[idx].Link   = NULL;
+	}
+	vax->blkUsed = 0;
+}
+
+#endif /* VAX_BLOCKS */
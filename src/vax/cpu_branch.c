@@ -727,6 +727,17 @@ DEF_INST(vax, CASEL)
 // Opcodes:
 //   11  BRB  Branch With Byte Displacement
 //   31  BRW  Branch With Word Displacement
+//
+// Note: With IDLE, branches within an idle loop are handed to vax_Idle
+// to stop spinning on host.  VMS null process (SCH$IDLE) loops on the
+// interrupt stack at IPL 3, and other systems branch to themselves with
+// nothing pending.
+
+#define IDLE_IPL 3 // VMS Idle Loop (SCH$IDLE) at IPL 3
+
+#define IS_IDLE \
+	((TIR == 0) && ((PSW & PSW_T) == 0) && \
+	 (((PSL & PSL_IS) && (PSL_GETIPL(PSL) == IDLE_IPL)) || (PC == faultPC)))
 
 DEF_INST(vax, BRB)
 {
@@ -735,6 +746,10 @@ DEF_INST(vax, BRB)
 #endif /* DEBUG */
 
 	SET_PC(PC + SXTB(vax->brDisp));
+#ifdef IDLE
+	if (IS_IDLE)
+		vax_Idle(vax);
+#endif /* IDLE */
 
 #ifdef DEBUG
 	if (dbg_Check(DBG_TRACE|DBG_DATA)) {
@@ -752,6 +767,10 @@ DEF_INST(vax, BRW)
 #endif /* DEBUG */
 
 	SET_PC(PC + SXTW(vax->brDisp));
+#ifdef IDLE
+	if (IS_IDLE)
+		vax_Idle(vax);
+#endif /* IDLE */
 
 #ifdef DEBUG
 	if (dbg_Check(DBG_TRACE|DBG_DATA)) {
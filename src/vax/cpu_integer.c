@@ -594,7 +594,7 @@ DEF_INST(vax, DIVW)
 
 	if (divr == 0) {
 		quo = divd;
-		flg == CC_V;
+		flg = CC_V;
 		SET_TRAP(TRAP_INTDIV);
 	} else if ((divr == -1) && (divd == -32768)) {
 		quo = divd;
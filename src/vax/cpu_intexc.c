@@ -237,7 +237,7 @@ void vax_Emulate(register VAX_CPU *vax, int32 opCode)
 	SET_PC(newPC & SCB_ADDR);
 }
 
-inline void vax_ChangeMode(register VAX_CPU *vax, int newMode)
+static __inline__ void vax_ChangeMode(register VAX_CPU *vax, int newMode)
 {
 	int32 code = SXTW(OP0);
 	int32 vec, prvMode;
@@ -526,6 +526,10 @@ DEF_INST(vax, REI)
 	SET_ACCESS; // Update new access mode
 	SET_IRQ;    // Evaluate Interrupts
 
+	// Check trace for next instruction.
+	if (PSL & (PSL_TP|PSW_T))
+		ts10_CutBatch();
+
 #ifdef DEBUG
 	if (DBGIPL[oldIPL] & DBG_FLAG) {
 		dbg_PutMode(DBGIPL[oldIPL] & ~DBG_FLAG);
@@ -27,7 +27,23 @@
 #include "vax/defs.h"
 #include "emu/socket.h"
 
-extern int32 ts10_ClkInterval;
+// Threaded dispatch needs labels as values (GCC extension).
+#if defined(VAX_THREADED) && !defined(__GNUC__)
+#undef VAX_THREADED
+#endif
+
+// Translated blocks are looked up at every instruction boundary,
+// which leaves nothing for threaded dispatch to gain.
+#if defined(VAX_THREADED) && defined(VAX_BLOCKS)
+#warning "VAX_THREADED and VAX_BLOCKS are exclusive - using VAX_BLOCKS only."
+#undef VAX_THREADED
+#endif
+#ifdef VAX_THREADED
+#include "vax/dispatch.h"
+#endif /* VAX_THREADED */
+
+extern int32     ts10_ClkInterval;
+extern CLK_QUEUE *ts10_SimClock;
 
 // Instruction table from inst.c file.
 extern INSTRUCTION vax_Instruction[];
@@ -68,6 +84,56 @@ char *vax_DisplayConditions(uint32 cc)
 	return ascFlags;
 }
 
+// Evaluate condition codes from last lazy operation.
+void vax_UpdateCC(register VAX_CPU *vax)
+{
+	int32  res = vax->ccRes;
+	int32  s1  = vax->ccSrc1;
+	int32  s2  = vax->ccSrc2;
+	uint32 cc  = vax->ccNeg ? CC_N : 0;
+
+	switch (vax->ccOp) {
+		case CC_OP_IIZZ:
+			if (res == 0)
+				cc |= CC_Z;
+			break;
+
+		case CC_OP_IIZP:
+			if (res == 0)
+				cc |= CC_Z;
+			cc |= vax->ccCarry;
+			break;
+
+		case CC_OP_ADD:
+			if (res == 0)
+				cc |= CC_Z;
+			if (((~s1 ^ s2) & (s1 ^ res)) & vax->ccSign)
+				cc |= CC_V;
+			if ((uint32)res < (uint32)s2)
+				cc |= CC_C;
+			break;
+
+		case CC_OP_SUB:
+			if (res == 0)
+				cc |= CC_Z;
+			if (((s1 ^ s2) & (~s1 ^ res)) & vax->ccSign)
+				cc |= CC_V;
+			if ((uint32)s2 < (uint32)s1)
+				cc |= CC_C;
+			break;
+
+		case CC_OP_CMP:
+			if (res == s2)
+				cc |= CC_Z;
+			if ((uint32)res < (uint32)s2)
+				cc |= CC_C;
+			break;
+	}
+
+	vax->ccReg = cc;
+	vax->ccOp  = CC_OP_NONE;
+}
+
 #ifdef DEBUG
 void vax_DisplayRegisters(register VAX_CPU *vax)
 {
@@ -90,6 +156,8 @@ void vax_BuildCPU(VAX_CPU *cpu, uint32 config)
 	for (idxInst = 0; idxInst < NUM_INST; idxInst++)
 		cpu->tblOpcode[idxInst] = vax_Opcode_Illegal;
 	memset(&cpu->tblOperand, 0, sizeof(uint32) * (NUM_INST * (MAX_SPEC+1)));
+	memset(&cpu->tblSpecs, 0, sizeof(SPECDEC) * (NUM_INST * (MAX_SPEC+1)));
+	memset(&cpu->tblFlags, 0, sizeof(uint32) * NUM_INST);
 
 	// Build instruction table
 	for (idxInst = 0; vax_Instruction[idxInst].Name; idxInst++) {
@@ -103,6 +171,7 @@ void vax_BuildCPU(VAX_CPU *cpu, uint32 config)
 			opCode |= ((opExtend - (INST_EXTEND - 1)) << 8);
 
 		// Build opcode entry
+		cpu->tblFlags[opCode] = opFlags;
 		if ((Execute == NULL) && ((opFlags & ISTR_EMULATE) == 0))
 			cpu->tblOpcode[opCode] = vax_Opcode_Unimplemented;
 		else {
@@ -116,11 +185,51 @@ void vax_BuildCPU(VAX_CPU *cpu, uint32 config)
 			for (idxOpnd = 0; idxOpnd < nOpnds; idxOpnd++)
 				cpu->tblOperand[opCode][idxOpnd+1] =
 					vax_Instruction[idxInst].opMode[idxOpnd];
+
+			// Build specifier decoder entry.  Immediate operands
+			// (BUGW/BUGL) are not decoded and branch displacement
+			// always is last operand.
+			for (idxOpnd = 0; idxOpnd < nOpnds; idxOpnd++) {
+				uint32 opMode = vax_Instruction[idxInst].opMode[idxOpnd];
+
+				if (opMode & OP_IMMED)
+					break;
+				cpu->tblSpecs[opCode][idxOpnd] = vax_GetSpecDecoder(opMode);
+				if (opMode & OP_BRANCH) {
+					cpu->tblFlags[opCode] |= ISTR_JUMP;
+					break;
+				}
+			}
 		}
 	}
 }
 
-// Operand Decoder
+// Instruction Stream for Operand Decoder
+//
+// When an instruction is replayed from the decoded instruction cache,
+// specifier data come from the cache entry instead of the prefetch
+// buffer.  Otherwise, specifier data are fetched from the prefetch
+// buffer and recorded into the cache entry being filled (if any).
+
+#define ReadIS(len) \
+	(vax->isData ? (PC += (len), *vax->isData++) : vax_FetchIS(vax, len))
+
+static __inline__ int32 vax_FetchIS(register VAX_CPU *vax, int32 len)
+{
+	ICENTRY *ic = vax->icEntry;
+	int32   data = ReadI(len);
+
+	if (ic) {
+		if (ic->nData < IC_MAXDATA)
+			ic->Data[ic->nData++] = data;
+		else
+			vax->icEntry = NULL; // Too long - Do not cache
+	}
+
+	return data;
+}
+
+// Operand Specifier Decoder
 //
 // Operands and parsed and placed into operand queues.
 //
@@ -131,16 +240,321 @@ void vax_BuildCPU(VAX_CPU *cpu, uint32 config)
 //    mq        opRegs[idx:idx+1]   value of operand
 //    w[bwlq]   opRegs[idx]         register/memory flag
 //              opRegs[idx+1]       memory address
+//
+// Write operand registers for register operand 'reg'.
+static __inline__ __attribute__((always_inline))
+int vax_StoreReg(register VAX_CPU *vax, uint32 opmode, int reg, int idx)
+{
+	if (opmode & (OP_VADDR|OP_WRITE)) {
+		OPN(idx++) = reg;
+		OPN(idx++) = RN(reg);
+	} else {
+		if ((opmode & OP_SCALE) <= OP_LONG)
+			OPN(idx++) = RN(reg);
+		else {
+			OPN(idx++) = RN0(reg);
+			OPN(idx++) = RN1(reg);
+		}
+		if (opmode & OP_MODIFIED)
+			OPN(idx++) = reg;
+	}
+	return idx;
+}
 
-inline void vax_DecodeOperand(register VAX_CPU *vax, uint32 *Operand, int32 *pc)
+// Write operand registers for memory operand at 'iAddr'.
+static __inline__ __attribute__((always_inline))
+int vax_StoreMem(register VAX_CPU *vax, uint32 opmode, int32 iAddr, int idx)
 {
-	int   opmode, scale;
+	int scale = opmode & OP_SCALE;
+
+	if (opmode & (OP_VADDR|OP_ADDR|OP_WRITE)) {
+		if (opmode & (OP_VADDR|OP_WRITE))
+			OPN(idx++) = OP_MEM;
+		OPN(idx++) = iAddr;
+	} else {
+		if (scale <= OP_LONG)
+			OPN(idx++) = ReadV(iAddr, scale, RA);
+		else {
+			OPN(idx++) = ReadV(iAddr, OP_LONG, RA);
+			OPN(idx++) = ReadV(iAddr + OP_LONG, OP_LONG, RA);
+		}
+		if (opmode & OP_MODIFIED) {
+			OPN(idx++) = OP_MEM;
+			OPN(idx++) = iAddr;
+		}
+	}
+	return idx;
+}
+
+// Decode one specifier for operand mode 'opmode' and return next
+// index of operand registers.  That is always inlined into decoders
+// below with constant 'opmode' so that all flag tests are resolved
+// at compile time.
+
+static __inline__ __attribute__((always_inline))
+int vax_DecodeSpec(register VAX_CPU *vax, uint32 opmode, int idx)
+{
+	int   scale = opmode & OP_SCALE;
 	uint8 optype;
 	uint8 mode, reg;
-	int   idx1, idx2, idx3;
-	int32 iAddr;
+	int   idx3;
+	int32 iAddr, disp;
 	int32 t1, t2;
 
+	// For BUGW/BUGL, Do not decode their operands!
+	if (opmode & OP_IMMED)
+		return idx;
+
+	if (opmode & OP_BRANCH) {
+		vax->brDisp = ReadIS(scale);
+		return idx;
+	}
+
+	optype = ReadIS(OP_BYTE);
+	mode = optype & OP_MMASK;
+	reg  = optype & OP_RMASK;
+
+	t1 = t2 = iAddr = 0;
+
+	switch (mode) {
+		case LIT0: case LIT1: // Short Literal
+		case LIT2: case LIT3:
+			if (opmode & (OP_VADDR|OP_ADDR|OP_MODIFIED|OP_WRITE))
+				RSVD_ADDR_FAULT;
+			if (opmode & OP_FLOAT) {
+				if (opmode & (OP_FFLOAT|OP_DFLOAT))
+					OPN(idx++) = 0x4000 | (optype << 4);
+				else
+					OPN(idx++) = 0x4000 | (optype << 1);
+			} else
+				OPN(idx++) = optype;
+			if (scale > OP_LONG)
+				OPN(idx++) = 0;
+			return idx;
+
+		case REG: // Register
+			if (reg >= (nPC - (scale > OP_LONG)))
+				RSVD_ADDR_FAULT;
+			if (opmode & OP_ADDR)
+				RSVD_ADDR_FAULT;
+			return vax_StoreReg(vax, opmode, reg, idx);
+
+		case ADEC: // Autodecrement
+			RN(reg) -= scale;
+			RQOP(RQPTR++) = reg | (scale << 4);
+
+		case REGD: // Register Deferred
+			if (reg == nPC)
+				RSVD_ADDR_FAULT;
+			iAddr = RN(reg);
+			break;
+
+		case AINC: // Autoincrement or Immediate
+			if (reg == nPC) {
+				// Immediate
+				if (opmode & (OP_VADDR|OP_ADDR|OP_WRITE)) {
+					if (opmode & (OP_VADDR|OP_WRITE))
+						OPN(idx++) = OP_MEM;
+					OPN(idx++) = RN(reg);
+					for (idx3 = 0; idx3 < scale; idx3 += OP_LONG)
+						ReadIS(MAX(scale, OP_LONG));
+				} else {
+					for (idx3 = 0; idx3 < scale; idx3 += OP_LONG)
+						OPN(idx++) = ReadIS(MAX(scale, OP_LONG));
+				}
+				return idx;
+			} else {
+				// Autoincrement
+				iAddr = RN(reg);
+				RN(reg) += scale;
+				RQOP(RQPTR++) = 0x8000 | reg | (scale << 4);
+			}
+			break;
+
+		case AINCD: // Autoincrement Deferred or Absolute
+			if (reg == nPC) {
+				iAddr = ReadIS(OP_LONG);
+			} else {
+				iAddr = ReadV(RN(reg), OP_LONG, RA);
+				RN(reg) += OP_LONG;
+				RQOP(RQPTR++) = 0x8000 | reg | (OP_LONG << 4);
+			}
+			break;
+
+		case BDP: // Byte Displacement
+			disp  = SXTB(ReadIS(OP_BYTE));
+			iAddr = RN(reg) + disp;
+			break;
+
+		case BDPD: // Byte Displacement Deferred
+			disp  = SXTB(ReadIS(OP_BYTE));
+			iAddr = ReadV(RN(reg) + disp, OP_LONG, RA);
+			break;
+
+		case WDP: // Word Displacement
+			disp  = SXTW(ReadIS(OP_WORD));
+			iAddr = RN(reg) + disp;
+			break;
+
+		case WDPD: // Word Displacement Deferred
+			disp  = SXTW(ReadIS(OP_WORD));
+			iAddr = ReadV(RN(reg) + disp, OP_LONG, RA);
+			break;
+
+		case LDP: // Longword Displacement
+			disp  = ReadIS(OP_LONG);
+			iAddr = RN(reg) + disp;
+			break;
+
+		case LDPD: // Longword Displacement Deferred
+			disp  = ReadIS(OP_LONG);
+			iAddr = ReadV(RN(reg) + disp, OP_LONG, RA);
+			break;
+
+		case IDX: // Indexed
+			if (reg == nPC)
+				RSVD_ADDR_FAULT;
+			iAddr = RN(reg) * scale;
+
+			optype = ReadIS(OP_BYTE);
+			mode = optype & OP_MMASK;
+			reg  = optype & OP_RMASK;
+
+			switch(mode) {
+				case ADEC: // Autodecrement
+					RN(reg) -= scale;
+					RQOP(RQPTR++) = reg | (scale << 4);
+
+				case REGD: // Register Deferred
+					if (reg == nPC)
+						RSVD_ADDR_FAULT;
+					iAddr += RN(reg);
+					break;
+
+				case AINC: // Autoincrement
+					if (reg == nPC)
+						RSVD_ADDR_FAULT;
+					iAddr += RN(reg);
+					RN(reg) += scale;
+					RQOP(RQPTR++) = 0x8000 | reg | (scale << 4);
+					break;
+
+				case AINCD: // Autoincrement Deferred or Absolute
+					if (reg == nPC)
+						iAddr += ReadIS(OP_LONG);
+					else {
+						iAddr += ReadV(RN(reg), OP_LONG, RA);
+						RN(reg) += OP_LONG;
+						RQOP(RQPTR++) = 0x8000 | reg | (OP_LONG << 4);
+					}
+					break;
+
+				case BDP: // Byte Displacement
+					disp   = SXTB(ReadIS(OP_BYTE));
+					iAddr += RN(reg) + disp;
+					break;
+
+				case BDPD: // Byte Displacement Deferred
+					disp   = SXTB(ReadIS(OP_BYTE));
+					t1     = RN(reg) + disp;
+					iAddr += ReadV(t1, OP_LONG, RA);
+					break;
+
+				case WDP: // Word Displacement
+					disp   = SXTW(ReadIS(OP_WORD));
+					iAddr += RN(reg) + disp;
+					break;
+
+				case WDPD: // Word Displacement Deferred
+					disp   = SXTW(ReadIS(OP_WORD));
+					t1     = RN(reg) + disp;
+					iAddr += ReadV(t1, OP_LONG, RA);
+					break;
+
+				case LDP: // Longword Displacement
+					disp   = ReadIS(OP_LONG);
+					iAddr += RN(reg) + disp;
+					break;
+
+				case LDPD: // Longword Displacement Deferred
+					disp   = ReadIS(OP_LONG);
+					t1     = RN(reg) + disp;
+					iAddr += ReadV(t1, OP_LONG, RA);
+					break;
+
+				default:
+					RSVD_ADDR_FAULT;
+			}
+	}
+
+	return vax_StoreMem(vax, opmode, iAddr, idx);
+}
+
+// Specialized specifier decoders, one for each operand mode
+// in the instruction table.  Any other operand mode will be
+// decoded by generic decoder.
+
+#define DEF_SPEC(opm) \
+static int vax_DecodeSpec_##opm(register VAX_CPU *vax, uint32 opmode, int idx) \
+{ \
+	return vax_DecodeSpec(vax, opm, idx); \
+}
+
+DEF_SPEC(RB) DEF_SPEC(RW) DEF_SPEC(RL) DEF_SPEC(RQ) DEF_SPEC(RO)
+DEF_SPEC(MB) DEF_SPEC(MW) DEF_SPEC(ML) DEF_SPEC(MQ) DEF_SPEC(MO)
+DEF_SPEC(WB) DEF_SPEC(WW) DEF_SPEC(WL) DEF_SPEC(WQ) DEF_SPEC(WO)
+DEF_SPEC(RF) DEF_SPEC(RD) DEF_SPEC(RG) DEF_SPEC(RH)
+DEF_SPEC(MF) DEF_SPEC(MD) DEF_SPEC(MG) DEF_SPEC(MH)
+DEF_SPEC(WF) DEF_SPEC(WD) DEF_SPEC(WG) DEF_SPEC(WH)
+DEF_SPEC(AB) DEF_SPEC(AW) DEF_SPEC(AL) DEF_SPEC(AQ) DEF_SPEC(AO)
+DEF_SPEC(AF) DEF_SPEC(AD) DEF_SPEC(AG) DEF_SPEC(AH)
+DEF_SPEC(BB) DEF_SPEC(BW) DEF_SPEC(VB)
+
+static int vax_DecodeSpec_Generic(register VAX_CPU *vax, uint32 opmode, int idx)
+{
+	return vax_DecodeSpec(vax, opmode, idx);
+}
+
+#define SPEC(opm) { opm, vax_DecodeSpec_##opm }
+
+static const struct {
+	uint32  opMode;
+	SPECDEC Decode;
+} vax_tblSpecs[] = {
+	SPEC(RB), SPEC(RW), SPEC(RL), SPEC(RQ), SPEC(RO),
+	SPEC(MB), SPEC(MW), SPEC(ML), SPEC(MQ), SPEC(MO),
+	SPEC(WB), SPEC(WW), SPEC(WL), SPEC(WQ), SPEC(WO),
+	SPEC(RF), SPEC(RD), SPEC(RG), SPEC(RH),
+	SPEC(MF), SPEC(MD), SPEC(MG), SPEC(MH),
+	SPEC(WF), SPEC(WD), SPEC(WG), SPEC(WH),
+	SPEC(AB), SPEC(AW), SPEC(AL), SPEC(AQ), SPEC(AO),
+	SPEC(AF), SPEC(AD), SPEC(AG), SPEC(AH),
+	SPEC(BB), SPEC(BW), SPEC(VB),
+	{ 0, NULL } // Null Terminator
+};
+
+// Find specifier decoder for operand mode.
+SPECDEC vax_GetSpecDecoder(uint32 opMode)
+{
+	int idx;
+
+	for (idx = 0; vax_tblSpecs[idx].Decode; idx++)
+		if (vax_tblSpecs[idx].opMode == opMode)
+			return vax_tblSpecs[idx].Decode;
+	return vax_DecodeSpec_Generic;
+}
+
+// Operand Decoder
+//
+// Run specifier decoders for current instruction in order.
+// List of decoders is null-terminated.
+
+inline void vax_DecodeOperand(register VAX_CPU *vax, SPECDEC *Decode, uint32 *Operand)
+{
+	ICENTRY *ic;
+	int32   pc;
+	int     idx1, idx2;
+
 #ifdef DEBUG
 	// Reset all operand registers first for debug use.
 	for (idx1 = 0; idx1 < MAX_OPREGS; idx1++)
@@ -148,222 +562,178 @@ inline void vax_DecodeOperand(register VAX_CPU *vax, uint32 *Operand, int32 *pc)
 #endif /* DEBUG */
 	RQPTR = 0;
 
-	for (idx1 = 0, idx2 = 0; idx1 < Operand[0]; idx1++) {
-		opmode = Operand[idx1+1];
+	for (idx1 = 0, idx2 = 0; Decode[idx1]; idx1++) {
+		pc = PC;
+		if (ic = vax->icEntry)
+			ic->Spec[idx1].Data = ic->nData;
+		idx2 = Decode[idx1](vax, Operand[idx1+1], idx2);
+		if (ic = vax->icEntry)
+			ic->Spec[idx1].Length = PC - pc;
+	}
+}
+
+// Decode recorded specifiers of completed cache entry into
+// descriptors.  Specifiers that are not simple to replay (or
+// that would fault) are left to operand decoder.
+static void vax_BuildSpecs(ICENTRY *ic, SPECDEC *Decode, uint32 *Operand)
+{
+	ICSPEC *sp;
+	int32  *data;
+	uint32 opmode;
+	int    scale, idx;
+	uint8  optype, mode, reg;
+
+	for (idx = 0; Decode[idx]; idx++) {
+		sp     = &ic->Spec[idx];
+		data   = &ic->Data[sp->Data];
+		opmode = Operand[idx+1];
 		scale  = opmode & OP_SCALE;
 
-		// For BUGW/BUGL, Do not decode their operands!
+		sp->Kind = IC_RAW;
 		if (opmode & OP_IMMED)
-			return;
-
+			continue;
 		if (opmode & OP_BRANCH) {
-			vax->brDisp = ReadI(scale);
-
-			// Get out of the operand decoder routine.
-			return;
-		}	
-
-		optype = ReadI(OP_BYTE);
-		mode = optype & OP_MMASK;
-		reg  = optype & OP_RMASK;
+			sp->Kind     = IC_BRANCH;
+			sp->Value[0] = data[0];
+			continue;
+		}
 
-		t1 = t2 = 0;
+		optype  = data[0];
+		mode    = optype & OP_MMASK;
+		reg     = optype & OP_RMASK;
+		sp->Reg = reg;
 
 		switch (mode) {
 			case LIT0: case LIT1: // Short Literal
 			case LIT2: case LIT3:
-				if (opmode & (OP_VADDR|OP_ADDR|OP_MODIFIED|OP_WRITE))
-					RSVD_ADDR_FAULT;
-				if (opmode & OP_FLOAT) {
-					if (opmode & (OP_FFLOAT|OP_DFLOAT))
-						OPN(idx2++) = 0x4000 | (optype << 4);
-					else
-						OPN(idx2++) = 0x4000 | (optype << 1);
-				} else
-					OPN(idx2++) = optype;
-				if (scale > OP_LONG)
-					OPN(idx2++) = 0;
-				continue;
-
-			case REG: // Register
-				if (reg >= (nPC - (scale > OP_LONG)))
-					RSVD_ADDR_FAULT;
-				if (opmode & OP_ADDR)
-					RSVD_ADDR_FAULT;
-				if (opmode & (OP_VADDR|OP_WRITE)) {
-					OPN(idx2++) = reg;
-					OPN(idx2++) = RN(reg);
-				} else {
-					if (scale <= OP_LONG)
-						OPN(idx2++) = RN(reg);
-					else {
-						OPN(idx2++) = RN0(reg);
-						OPN(idx2++) = RN1(reg);
-					}
-					if (opmode & OP_MODIFIED)
-						OPN(idx2++) = reg;
+				if ((opmode & (OP_VADDR|OP_ADDR|OP_MODIFIED|OP_WRITE)) == 0) {
+					if (opmode & OP_FLOAT) {
+						if (opmode & (OP_FFLOAT|OP_DFLOAT))
+							sp->Value[0] = 0x4000 | (optype << 4);
+						else
+							sp->Value[0] = 0x4000 | (optype << 1);
+					} else
+						sp->Value[0] = optype;
+					sp->Value[1] = 0;
+					sp->Kind     = IC_VALUE;
 				}
-				continue;
+				break;
 
-			case ADEC: // Autodecrement
-				RN(reg) -= scale;
-				RQOP(RQPTR++) = reg | (scale << 4);
+			case REG: // Register
+				if ((reg < (nPC - (scale > OP_LONG))) && !(opmode & OP_ADDR))
+					sp->Kind = IC_REG;
+				break;
 
 			case REGD: // Register Deferred
-				if (reg == nPC)
-					RSVD_ADDR_FAULT;
-				iAddr = RN(reg);
+				if (reg != nPC) {
+					sp->Kind     = IC_DISP;
+					sp->Value[0] = 0;
+				}
 				break;
 
-			case AINC: // Autoincrement or Immediate
-				if (reg == nPC) {
-					// Immediate
-					if (opmode & (OP_VADDR|OP_ADDR|OP_WRITE)) {
-						if (opmode & (OP_VADDR|OP_WRITE))
-							OPN(idx2++) = OP_MEM;
-						OPN(idx2++) = RN(reg);
-						for (idx3 = 0; idx3 < scale; idx3 += OP_LONG)
-							ReadI(MAX(scale, OP_LONG));
-					} else {
-						for (idx3 = 0; idx3 < scale; idx3 += OP_LONG)
-							OPN(idx2++) = ReadI(MAX(scale, OP_LONG));
-					}
-					continue;
-				} else {
-					// Autoincrement
-					iAddr = RN(reg);
-					RN(reg) += scale;
-					RQOP(RQPTR++) = 0x8000 | reg | (scale << 4);
+			case AINC: // Immediate
+				if (reg != nPC)
+					break;
+				if (opmode & (OP_VADDR|OP_ADDR|OP_WRITE)) {
+					// Address of immediate data behind mode byte
+					sp->Kind     = IC_DISP;
+					sp->Value[0] = 1 - sp->Length;
+				} else if (scale <= OP_QUAD) {
+					sp->Kind     = IC_VALUE;
+					sp->Value[0] = data[1];
+					sp->Value[1] = (scale > OP_LONG) ? data[2] : 0;
 				}
 				break;
 
-			case AINCD: // Autoincrement Deferred or Absolute
+			case AINCD: // Absolute
 				if (reg == nPC) {
-					iAddr = ReadI(OP_LONG);
-				} else {
-					iAddr = ReadV(RN(reg), OP_LONG, RA);
-					RN(reg) += OP_LONG;
-					RQOP(RQPTR++) = 0x8000 | reg | (OP_LONG << 4);
+					sp->Kind     = IC_ABS;
+					sp->Value[0] = data[1];
 				}
 				break;
 
-			case BDP: // Byte Displacement
-				iAddr = RN(reg) + SXTB(ReadI(OP_BYTE));
+			case BDP: case BDPD: // Byte Displacement
+				sp->Kind     = (mode == BDP) ? IC_DISP : IC_DISPD;
+				sp->Value[0] = SXTB(data[1]);
 				break;
 
-			case BDPD: // Byte Displacement Deferred
-				iAddr = RN(reg) + SXTB(ReadI(OP_BYTE));
-				iAddr = ReadV(iAddr, OP_LONG, RA);
+			case WDP: case WDPD: // Word Displacement
+				sp->Kind     = (mode == WDP) ? IC_DISP : IC_DISPD;
+				sp->Value[0] = SXTW(data[1]);
 				break;
 
-			case WDP: // Word Displacement
-				iAddr = RN(reg) + SXTW(ReadI(OP_WORD));
+			case LDP: case LDPD: // Longword Displacement
+				sp->Kind     = (mode == LDP) ? IC_DISP : IC_DISPD;
+				sp->Value[0] = data[1];
 				break;
+		}
+	}
+}
 
-			case WDPD: // Word Displacement Deferred
-				iAddr = RN(reg) + SXTW(ReadI(OP_WORD));
-				iAddr = ReadV(iAddr, OP_LONG, RA);
-				break;
+// Replay one decoded specifier.  Program counter is advanced
+// past specifier first so that PC-relative modes see the same
+// PC as operand decoder does.
+static __inline__ int vax_ReplaySpec(register VAX_CPU *vax,
+	uint32 opmode, ICSPEC *sp, int idx)
+{
+	int32 iAddr;
 
-			case LDP: // Longword Displacement
-				iAddr = RN(reg) + ReadI(OP_LONG);
-				break;
+	PC += sp->Length;
+	switch (sp->Kind) {
+		case IC_BRANCH:
+			vax->brDisp = sp->Value[0];
+			return idx;
 
-			case LDPD: // Longword Displacement Deferred
-				iAddr = RN(reg) + ReadI(OP_LONG);
-				iAddr = ReadV(iAddr, OP_LONG, RA);
-				break;
+		case IC_VALUE:
+			OPN(idx++) = sp->Value[0];
+			if ((opmode & OP_SCALE) > OP_LONG)
+				OPN(idx++) = sp->Value[1];
+			return idx;
 
-			case IDX: // Indexed
-				if (reg == nPC)
-					RSVD_ADDR_FAULT;
-				iAddr = RN(reg) * scale;
-
-				optype = ReadI(OP_BYTE);
-				mode = optype & OP_MMASK;
-				reg  = optype & OP_RMASK;
-
-				switch(mode) {
-					case ADEC: // Autodecrement
-						RN(reg) -= scale;
-						RQOP(RQPTR++) = reg | (scale << 4);
-
-					case REGD: // Register Deferred
-						if (reg == nPC)
-							RSVD_ADDR_FAULT;
-						iAddr += RN(reg);
-						break;
-
-					case AINC: // Autoincrement
-						if (reg == nPC)
-							RSVD_ADDR_FAULT;
-						iAddr += RN(reg);
-						RN(reg) += scale;
-						RQOP(RQPTR++) = 0x8000 | reg | (scale << 4);
-						break;
-
-					case AINCD: // Autoincrement Deferred or Absolute
-						if (reg == nPC)
-							iAddr += ReadI(OP_LONG);
-						else {
-							iAddr += ReadV(RN(reg), OP_LONG, RA);
-							RN(reg) += OP_LONG;
-							RQOP(RQPTR++) = 0x8000 | reg | (OP_LONG << 4);
-						}
-						break;
-
-					case BDP: // Byte Displacement
-						iAddr += RN(reg) + SXTB(ReadI(OP_BYTE));
-						break;
-
-					case BDPD: // Byte Displacement Deferred
-						t1 = RN(reg) + SXTB(ReadI(OP_BYTE));
-						iAddr += ReadV(t1, OP_LONG, RA);
-						break;
-
-					case WDP: // Word Displacement
-						iAddr += RN(reg) + SXTW(ReadI(OP_WORD));
-						break;
-
-					case WDPD: // Word Displacement Deferred
-						t1 = RN(reg) + SXTW(ReadI(OP_WORD));
-						iAddr += ReadV(t1, OP_LONG, RA);
-						break;
-
-					case LDP: // Longword Displacement
-						iAddr += RN(reg) + ReadI(OP_LONG);
-						break;
-
-					case LDPD: // Longword Displacement Deferred
-						t1 = RN(reg) + ReadI(OP_LONG);
-						iAddr += ReadV(t1, OP_LONG, RA);
-						break;
-
-					default:
-						RSVD_ADDR_FAULT;
-				}
-		}
+		case IC_REG:
+			return vax_StoreReg(vax, opmode, sp->Reg, idx);
 
-		// Write operand registers
-		if (opmode & (OP_VADDR|OP_ADDR|OP_WRITE)) {
-			if (opmode & (OP_VADDR|OP_WRITE))
-				OPN(idx2++) = OP_MEM;
-			OPN(idx2++) = iAddr;
-		} else {
-//			for (idx3 = 0; idx3 < scale; idx3 += OP_LONG)
-//				OPN(idx2++) = ReadV(iAddr + idx3, scale, RA);
-			if (scale <= OP_LONG)
-				OPN(idx2++) = ReadV(iAddr, scale, RA);
-			else {
-				OPN(idx2++) = ReadV(iAddr, OP_LONG, RA);
-				OPN(idx2++) = ReadV(iAddr + OP_LONG, OP_LONG, RA);
-			}
-			if (opmode & OP_MODIFIED) {
-				OPN(idx2++) = OP_MEM;
-				OPN(idx2++) = iAddr;
-			}
-		}
+		case IC_DISP:
+			iAddr = RN(sp->Reg) + sp->Value[0];
+			break;
+
+		case IC_DISPD:
+			iAddr = ReadV(RN(sp->Reg) + sp->Value[0], OP_LONG, RA);
+			break;
+
+		default: // IC_ABS
+			iAddr = sp->Value[0];
+			break;
 	}
+	return vax_StoreMem(vax, opmode, iAddr, idx);
+}
+
+// Operand Replayer
+//
+// Same as operand decoder but takes operands from decoded
+// instruction cache entry.
+static void vax_ReplayOperand(register VAX_CPU *vax, ICENTRY *ic,
+	SPECDEC *Decode, uint32 *Operand)
+{
+	ICSPEC *sp;
+	int    idx1, idx2;
+
+#ifdef DEBUG
+	// Reset all operand registers first for debug use.
+	for (idx1 = 0; idx1 < MAX_OPREGS; idx1++)
+		OPN(idx1) = 0;
+#endif /* DEBUG */
+	RQPTR = 0;
+
+	for (idx1 = 0, idx2 = 0; Decode[idx1]; idx1++) {
+		sp = &ic->Spec[idx1];
+		if (sp->Kind == IC_RAW) {
+			vax->isData = &ic->Data[sp->Data];
+			idx2 = Decode[idx1](vax, Operand[idx1+1], idx2);
+		} else
+			idx2 = vax_ReplaySpec(vax, Operand[idx1+1], sp, idx2);
+	}
+	vax->isData = NULL;
 }
 
 inline void vax_DoFault(register VAX_CPU *vax, int32 vec)
@@ -534,23 +904,193 @@ inline void vax_Interrupt(register VAX_CPU *vax)
 			ABORT(STOP_UIPL);
 
 		vax_DoIntexc(vax, vec, newIPL, IE_INT);
+#ifdef IDLE
+		vax->idleWait = 0;
+#endif /* IDLE */
 	} else
 		TIR = 0;
 }
 
+// Fetch and decode the next instruction at the current PC
+// and return its opcode for dispatching.
+static __inline__ __attribute__((always_inline))
+uint16 vax_FetchInst(register VAX_CPU *vax,
+	SPECDEC tblSpecs[][MAX_SPEC+1], uint32 tblOperand[][MAX_SPEC+1])
+{
+	uint16  opcode;
+	uint32  ppc;
+	ICENTRY *ic, *hit;
+
+#ifdef DEBUG
+	// Breakpoints here
+	if (vax->Breaks.Switch && dbg_CheckBreak(&vax->Breaks, faultPC, SWMASK('e')))
+		ABORT(STOP_BRKPT);
+
+	if (dbg_Check(DBG_TRACE)) {
+		int32 pc = PC;
+		vax_Disasm(vax, dbg_File, &pc, SWMASK('v'));
+	}
+#endif /* DEBUG */
+
+	// Fetch instruction opcode from current Program Counter.
+	// If opcode is greater than or equal to 0xFD, then
+	// opcode is extended opcode.  Fetch another instruction
+	// opcode from next byte location.
+
+	vax->ips++;
+
+	// Look up decoded instruction cache by physical PC first.
+	// If instruction was found, replay its decoded specifiers.
+	// Otherwise, fill a new entry while decoding instruction.
+	hit          = NULL;
+	vax->isData  = NULL;
+	vax->icEntry = NULL;
+	ppc          = vax_GetPhysPC(vax);
+	if ((ppc < vax->sizeRAM) && vax->icTable) {
+		ic = &vax->icTable[IC_INDEX(ppc)];
+		if ((ic->ppc == ppc) && (ic->gen == vax->icPages[ppc >> VA_N_OFF])) {
+			opcode  = ic->opCode;
+			PC     += (opcode > 0xFF) ? 2 : 1;
+			hit     = ic;
+			FLUSH_ISTR;
+		} else {
+			ic->ppc      = IC_NONE;
+			ic->nData    = 0;
+			vax->icEntry = ic;
+		}
+	}
+
+	if (hit == NULL) {
+		opcode = ZXTB(ReadI(OP_BYTE));
+		if (opcode >= INST_EXTEND) {
+			opcode = (opcode - (INST_EXTEND - 1)) << 8;
+			opcode |= ZXTB(ReadI(OP_BYTE));
+		}
+	}
+
+	OPC = opcode;
+	if ((PSL & PSL_FPD) && (vax->tblFlags[opcode] & (ISTR_FPD|ISTR_EMULATE))) {
+		// Resume instruction with first part done.  Its state
+		// is in general registers so that operands must not be
+		// decoded again.
+		vax->icEntry = NULL;
+	} else if (tblSpecs[opcode][0]) {
+		if (hit)
+			vax_ReplayOperand(vax, hit, tblSpecs[opcode], tblOperand[opcode]);
+		else
+			vax_DecodeOperand(vax, tblSpecs[opcode], tblOperand[opcode]);
+	}
+
+	// Complete new cache entry.  Instructions crossing
+	// a page boundary are not cached.
+	if (ic = vax->icEntry) {
+		if ((VA_GETOFF(faultPC) + (PC - faultPC)) <= VA_PAGESIZE) {
+			vax_BuildSpecs(ic, tblSpecs[opcode], tblOperand[opcode]);
+			ic->opCode  = opcode;
+			ic->nLength = PC - faultPC;
+			vax->icPages[ppc >> VA_N_OFF] |= IC_LIVE;
+			ic->gen     = vax->icPages[ppc >> VA_N_OFF];
+			ic->ppc     = ppc;
+		}
+		vax->icEntry = NULL;
+	}
+
+	return opcode;
+}
+
+#ifdef VAX_BLOCKS
+// Replay decoded instruction from translated block.  Called
+// by host code before it calls the instruction handler.
+void vax_ReplayInst(register VAX_CPU *vax, ICENTRY *ic)
+{
+	uint16 opcode = ic->opCode;
+
+	PC          += (opcode > 0xFF) ? 2 : 1;
+	vax->isData  = NULL;
+	vax->icEntry = NULL;
+	FLUSH_ISTR;
+
+	OPC = opcode;
+	if (vax->tblSpecs[opcode][0])
+		vax_ReplayOperand(vax, ic, vax->tblSpecs[opcode], vax->tblOperand[opcode]);
+}
+#endif /* VAX_BLOCKS */
+
+#ifdef VAX_THREADED
+// Instruction fetch for threaded dispatch, used at
+// every handler label in vax_Execute.
+static __inline__ uint16 vax_FetchNext(register VAX_CPU *vax)
+{
+	return vax_FetchInst(vax, vax->tblSpecs, vax->tblOperand);
+}
+#endif /* VAX_THREADED */
+
+#ifdef VAX_THREADED
+// Threaded dispatch.  Every instruction handler has its own label
+// below which calls it and then jumps straight to the next handler
+// through the label table, so that each handler has its own indirect
+// branch for the host branch predictor.  The common path only tests
+// for halt and end of instruction batch (see emu/timer.c) and falls
+// back to vax_Event to service timers, interrupts and traces.
+
+#define VAX_DISPATCH \
+	if ((emu_State != VAX_RUN) | (ts10_ClkInterval <= 0)) \
+		goto vax_Event; \
+	ts10_ClkInterval--; \
+	faultPC = PC; \
+	RQPTR   = 0; \
+	goto *tblLabel[vax_FetchNext(vax)];
+
+#ifdef DEBUG
+#define VAX_NEXT \
+	if (dbg_Check(DBG_TRACE|DBG_REGISTER)) \
+		vax_DisplayRegisters(vax); \
+	VAX_DISPATCH
+#else /* DEBUG */
+#define VAX_NEXT VAX_DISPATCH
+#endif /* DEBUG */
+
+#endif /* VAX_THREADED */
+
+#ifdef IDLE
+// Processor is idle, spinning in idle loop until next interrupt.
+// Skip forward to next simulation event first so that pending
+// I/O completes at once.  If processor is still idle after that,
+// sleep until next host timer tick or I/O wakeup instead of
+// burning host time, then check all requests at once.
+void vax_Idle(register VAX_CPU *vax)
+{
+	if ((vax->idleWait == 0) && ts10_SimClock) {
+		ts10_SkipTimer();
+		vax->idleWait = 1;
+	} else {
+		ts10_WaitWakeup(CLK_TICK / 1000);
+		ts10_CutBatch();
+		vax->idleWait = 0;
+	}
+}
+#endif /* IDLE */
+
 int vax_Execute(MAP_DEVICE *map)
 {
 	register VAX_CPU *vax;
-	uint16 opcode;
 	int    abValue;
 	int    idxInst, idxOpnd;
 
+#ifdef VAX_THREADED
+#define VAX_HANDLER(name) DEF_NAME(vax, name),
+	static void (*thrFuncs[])() = { VAX_HANDLERS NULL };
+#undef VAX_HANDLER
+#define VAX_HANDLER(name) &&vax_Thread_##name,
+	static void *thrLabels[] = { VAX_HANDLERS NULL };
+#undef VAX_HANDLER
+	void   *tblLabel[NUM_INST];
+#else /* VAX_THREADED */
+	uint16 opcode;
 	void   (*tblOpcode[NUM_INST])();
 	uint32 tblOperand[NUM_INST][MAX_SPEC+1];
-
-#ifdef DEBUG
-	DBG_BRKSYS *Break;
-#endif /* DEBUG */
+	SPECDEC tblSpecs[NUM_INST][MAX_SPEC+1];
+#endif /* VAX_THREADED */
 
 	vax = ((VAX_SYSTEM *)map->Device)->Processor;
 
@@ -560,18 +1100,27 @@ int vax_Execute(MAP_DEVICE *map)
 		return STOP_NOCTY;
 	}
 
-#ifdef DEBUG
-	Break = &vax->Breaks;
-#endif /* DEBUG */
-
-//	tblOpcode  = &vax->tblOpcode;
-//	tblOperand = &vax->tblOperand;
-
+#ifdef VAX_THREADED
+	// Map each opcode to its handler label.  Opcodes
+	// without their own label go through opcode table.
+	for (idxInst = 0; idxInst < NUM_INST; idxInst++) {
+		tblLabel[idxInst] = &&vax_Generic;
+		for (idxOpnd = 0; thrFuncs[idxOpnd]; idxOpnd++) {
+			if (vax->tblOpcode[idxInst] == thrFuncs[idxOpnd]) {
+				tblLabel[idxInst] = thrLabels[idxOpnd];
+				break;
+			}
+		}
+	}
+#else /* VAX_THREADED */
 	for (idxInst = 0; idxInst < NUM_INST; idxInst++) {
 		tblOpcode[idxInst] = vax->tblOpcode[idxInst];
-		for (idxOpnd = 0; idxOpnd < MAX_SPEC+1; idxOpnd++)
+		for (idxOpnd = 0; idxOpnd < MAX_SPEC+1; idxOpnd++) {
 			tblOperand[idxInst][idxOpnd] = vax->tblOperand[idxInst][idxOpnd];
+			tblSpecs[idxInst][idxOpnd]   = vax->tblSpecs[idxInst][idxOpnd];
+		}
 	}
+#endif /* VAX_THREADED */
 
 	// Set up host timer system and
 	// reset clock (Time of Day).
@@ -587,6 +1136,10 @@ int vax_Execute(MAP_DEVICE *map)
 	SET_ACCESS; // Reset access mode for memory management
 	FLUSH_ISTR; // Reset prefetch instruction buffer first
 
+	// Memory may be changed by console commands
+	// so that clear decoded instruction cache.
+	vax_ClearICache(vax);
+
 	// Set up fault trap
 	abValue = setjmp(vax->SetJump);
 	if (abValue > 0) {
@@ -604,60 +1157,100 @@ int vax_Execute(MAP_DEVICE *map)
 	} else if (abValue < 0)
 		vax_DoFault(vax, -abValue);
 
-	// Main loop for every instruction execution.
+	// Check all requests before first instruction.
+	ts10_CutBatch();
+
+#ifdef VAX_THREADED
+	// Service pending events and dispatch next instruction.
+	// Also entered after faults and at start of execution.
+vax_Event:
 	while (emu_State == VAX_RUN) {
 		// Save current PC for fault/interrupt use.
 		faultPC = PC;
 		RQPTR   = 0;
 
-		// Check Simulation Interval Timer
-		if (ts10_ClkInterval-- <= 0)
+		// Check Simulation Interval Timer at end of batch.
+		// Trap, interrupt and trace requests end current
+		// batch so that they are checked here only.
+		if (ts10_ClkInterval-- <= 0) {
 			ts10_ExecuteTimer();
 
-		// Check Trap and Interrupt Requests First
-		if (TIR) {
-			vax_Interrupt(vax); // Execute Interrupts
-			SET_IRQ;            // Evaluate Interrupts
-			continue;
-		}
+			// Check Trap and Interrupt Requests First
+			if (TIR) {
+				vax_Interrupt(vax); // Execute Interrupts
+				SET_IRQ;            // Evaluate Interrupts
+				continue;
+			}
 
-		// Check trace pending for debugging purposes.
-		// If Trace bit is set, set Trace-Pending bit.
-		if (PSL & PSL_TP) {
-			PSL &= ~PSL_TP;
-			vax_DoIntexc(vax, SCB_TP, 0, IE_EXC);
-			continue;
+			// Check trace pending for debugging purposes.
+			// If Trace bit is set, set Trace-Pending bit
+			// and check it again after this instruction.
+			if (PSL & PSL_TP) {
+				PSL &= ~PSL_TP;
+				vax_DoIntexc(vax, SCB_TP, 0, IE_EXC);
+				continue;
+			}
+			if (PSW & PSW_T) {
+				PSL |= PSL_TP;
+				ts10_CutBatch();
+			}
 		}
-		if (PSW & PSW_T)
-			PSL |= PSL_TP;
 
-#ifdef DEBUG
-		// Breakpoints here
-		if (Break->Switch && dbg_CheckBreak(Break, faultPC, SWMASK('e')))
-			ABORT(STOP_BRKPT);
+		goto *tblLabel[vax_FetchNext(vax)];
 
-		if (dbg_Check(DBG_TRACE)) {
-			int32 pc = PC;
-			vax_Disasm(vax, dbg_File, &pc, SWMASK('v'));
-		}
-#endif /* DEBUG */
+		// Instruction handlers
+#define VAX_HANDLER(name) \
+	vax_Thread_##name: \
+		DEF_NAME(vax, name)(vax); \
+		VAX_NEXT
+		VAX_HANDLERS
+#undef VAX_HANDLER
+
+	vax_Generic:
+		vax->tblOpcode[OPC](vax);
+		VAX_NEXT
+	}
+#else /* VAX_THREADED */
+	// Main loop for every instruction execution.
+	while (emu_State == VAX_RUN) {
+		// Save current PC for fault/interrupt use.
+		faultPC = PC;
+		RQPTR   = 0;
 
-		// Fetch instruction opcode from current Program Counter.
-		// If opcode is greater than or equal to 0xFD, then
-		// opcode is extended opcode.  Fetch another instruction
-		// opcode from next byte location.
+		// Check Simulation Interval Timer at end of batch.
+		// Trap, interrupt and trace requests end current
+		// batch so that they are checked here only.
+		if (ts10_ClkInterval-- <= 0) {
+			ts10_ExecuteTimer();
 
-		vax->ips++;
+			// Check Trap and Interrupt Requests First
+			if (TIR) {
+				vax_Interrupt(vax); // Execute Interrupts
+				SET_IRQ;            // Evaluate Interrupts
+				continue;
+			}
 
-		opcode = ZXTB(ReadI(OP_BYTE));
-		if (opcode >= INST_EXTEND) {
-			opcode = (opcode - (INST_EXTEND - 1)) << 8;
-			opcode |= ZXTB(ReadI(OP_BYTE));
+			// Check trace pending for debugging purposes.
+			// If Trace bit is set, set Trace-Pending bit
+			// and check it again after this instruction.
+			if (PSL & PSL_TP) {
+				PSL &= ~PSL_TP;
+				vax_DoIntexc(vax, SCB_TP, 0, IE_EXC);
+				continue;
+			}
+			if (PSW & PSW_T) {
+				PSL |= PSL_TP;
+				ts10_CutBatch();
+			}
 		}
 
-		OPC = opcode;
-		if (tblOperand[opcode][0])
-			vax_DecodeOperand(vax, &tblOperand[opcode][0], &PC);
+#ifdef VAX_BLOCKS
+		// Run translated code for current PC if any.
+		if (((PSW & PSW_T) == 0) && vax_BlockExecute(vax))
+			continue;
+#endif /* VAX_BLOCKS */
+
+		opcode = vax_FetchInst(vax, tblSpecs, tblOperand);
 		tblOpcode[opcode](vax);
 
 #ifdef DEBUG
@@ -665,6 +1258,7 @@ int vax_Execute(MAP_DEVICE *map)
 			vax_DisplayRegisters(vax);
 #endif /* DEBUG */
 	}
+#endif /* VAX_THREADED */
 
 	if (emu_State == VAX_SWHALT) {
 		if (vax->HaltAction) {
@@ -51,6 +51,10 @@ DEF_INST(vax, BISPSW)
 	// Set all or any bits with mask bits.
 	PSW |= (mask & ~PSW_CC);
 	CC  |= (mask & PSW_CC);
+
+	// Check trace for next instruction.
+	if (mask & PSW_T)
+		ts10_CutBatch();
 }
 
 // BPT  Breakpoint
@@ -193,6 +193,7 @@ void vax_ClearTBTable(register VAX_CPU *vax, int stlb)
 		if (stlb)
 			STLB[idx].tag = STLB[idx].pte = -1;
 	}
+	vax_ClearHostTB(vax, stlb);
 }
 
 // Clear TB Entry with virtual address
@@ -204,6 +205,24 @@ void vax_ClearTBEntry(register VAX_CPU *vax, uint32 vAddr)
 		STLB[tbi].tag = STLB[tbi].pte = -1;
 	else
 		PTLB[tbi].tag = PTLB[tbi].pte = -1;
+
+	tbi = HTLB_INDEX(vAddr);
+	HRTLB[tbi].tag = HWTLB[tbi].tag = -1;
+}
+
+// Clear Host TB Table.  System entries are kept unless
+// 'stlb' is set.  Also must be called when host addresses
+// of RAM are changed or parity checking is enabled.
+void vax_ClearHostTB(register VAX_CPU *vax, int stlb)
+{
+	uint32 idx;
+
+	for (idx = 0; idx < VA_TBSIZE; idx++) {
+		if (stlb || ((HRTLB[idx].tag & VA_S0) == 0))
+			HRTLB[idx].tag = -1;
+		if (stlb || ((HWTLB[idx].tag & VA_S0) == 0))
+			HWTLB[idx].tag = -1;
+	}
 }
 
 // Check TB Entry with virtual address
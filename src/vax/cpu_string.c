@@ -26,6 +26,95 @@
 
 #include "vax/defs.h"
 
+// String Run Routines
+//
+// Strings are processed in runs within a page.  Each run is mapped
+// to host memory once so that bytes can be scanned directly.  If page
+// is not in RAM, one byte is read by using ReadV instead.  Registers
+// are not updated until instruction is done, so that instruction will
+// be restarted from beginning after a page fault.
+
+static __inline__ uint8 *vax_MapString(register VAX_CPU *vax,
+	uint32 addr, uint32 len, uint32 *cnt, uint8 *buf)
+{
+	uint8 *str;
+
+	*cnt = VA_PAGESIZE - VA_GETOFF(addr);
+	if (*cnt > len)
+		*cnt = len;
+	if ((str = vax_MapPage(vax, addr, RA)) == NULL) {
+		*buf = ReadV(addr, OP_BYTE, RA);
+		*cnt = 1;
+		str  = buf;
+	}
+	return str;
+}
+
+// Load 256-byte table for SCANC/SPANC once per instruction.  Table
+// may cross a page, so each part is copied from its own page.
+static __inline__ void vax_LoadTable(register VAX_CPU *vax,
+	uint32 tbladdr, uint8 *table)
+{
+	uint32 idx, cnt;
+	uint8  *tbl;
+
+	for (idx = 0; idx < 256; idx += cnt) {
+		cnt = VA_PAGESIZE - VA_GETOFF(tbladdr + idx);
+		if (cnt > (256 - idx))
+			cnt = 256 - idx;
+		if (tbl = vax_MapPage(vax, tbladdr + idx, RA))
+			memcpy(&table[idx], tbl, cnt);
+		else {
+			table[idx] = ReadV(tbladdr + idx, OP_BYTE, RA);
+			cnt = 1;
+		}
+	}
+}
+
+// Compare two strings by runs.  Return number of equal bytes and
+// differing bytes if any.
+static uint32 vax_CompareString(register VAX_CPU *vax,
+	uint32 s1addr, uint32 s2addr, uint32 len, int8 *s1, int8 *s2)
+{
+	uint32 cnt1, cnt2, idx, done = 0;
+	uint8  *str1, *str2;
+	uint8  buf1, buf2;
+
+	while (done < len) {
+		str1 = vax_MapString(vax, s1addr + done, len - done, &cnt1, &buf1);
+		str2 = vax_MapString(vax, s2addr + done, len - done, &cnt2, &buf2);
+		if (cnt1 > cnt2)
+			cnt1 = cnt2;
+		if (memcmp(str1, str2, cnt1)) {
+			for (idx = 0; str1[idx] == str2[idx]; idx++);
+			*s1 = str1[idx];
+			*s2 = str2[idx];
+			return done + idx;
+		}
+		done += cnt1;
+	}
+	return done;
+}
+
+// Compare a string against fill character by runs.  Return number
+// of bytes equal to fill character.
+static uint32 vax_SkipString(register VAX_CPU *vax,
+	uint32 addr, uint32 len, uint8 ch)
+{
+	uint32 cnt, idx, done = 0;
+	uint8  *str;
+	uint8  buf;
+
+	while (done < len) {
+		str = vax_MapString(vax, addr + done, len - done, &cnt, &buf);
+		for (idx = 0; idx < cnt; idx++)
+			if (str[idx] != ch)
+				return done + idx;
+		done += cnt;
+	}
+	return done;
+}
+
 DEF_INST(vax, CMPC3)
 {
 	uint16 len    = OP0;
@@ -33,25 +122,17 @@ DEF_INST(vax, CMPC3)
 	int32  s2addr = OP2;
 	int32  cc;
 	int8   s1, s2;
+	uint32 cnt;
 
-	if (len > 0) {
-		while (len > 0) {
-			s1 = ReadV(s1addr, OP_BYTE, RA);
-			s2 = ReadV(s2addr, OP_BYTE, RA);
-
-			if (s1 != s2)
-				break;
-
-			len--;
-			s1addr++;
-			s2addr++;
-		}
+	s1 = s2 = 0;
+	cnt     = vax_CompareString(vax, s1addr, s2addr, len, &s1, &s2);
+	len    -= cnt;
+	s1addr += cnt;
+	s2addr += cnt;
 
-		cc =  (s1 < s2) ? CC_N : 0;
-		cc |= (s1 == s2) ? CC_Z : 0;
-		cc |= ((uint8)s1 < (uint8)s2) ? CC_C : 0;
-	} else
-		cc = CC_Z;
+	cc =  (s1 < s2) ? CC_N : 0;
+	cc |= (s1 == s2) ? CC_Z : 0;
+	cc |= ((uint8)s1 < (uint8)s2) ? CC_C : 0;
 
 	// Update condition bits
 	CC = cc;
@@ -72,30 +153,39 @@ DEF_INST(vax, CMPC5)
 	int32  s2addr = OP4;
 	int32  cc;
 	int8   s1, s2;
-
-	if ((s1len | s2len) > 0) {
-		while ((s1len | s2len) > 0) {
-			s1 = (s1len > 0) ? ReadV(s1addr, OP_BYTE, RA) : fill;
-			s2 = (s2len > 0) ? ReadV(s2addr, OP_BYTE, RA) : fill;
-
-			if (s1 != s2)
-				break;
-
-			if (s1len > 0) {
-				s1len--;
-				s1addr++;
-			}
-			if (s2len > 0) {
-				s2len--;
-				s2addr++;
-			}
+	uint32 cnt;
+
+	// Compare both strings first.
+	s1 = s2 = 0;
+	cnt     = vax_CompareString(vax, s1addr, s2addr,
+		(s1len < s2len) ? s1len : s2len, &s1, &s2);
+	s1len  -= cnt;
+	s1addr += cnt;
+	s2len  -= cnt;
+	s2addr += cnt;
+
+	// Compare rest of longer string against fill character.
+	if ((s1 == s2) && (s1len > 0)) {
+		cnt     = vax_SkipString(vax, s1addr, s1len, fill);
+		s1len  -= cnt;
+		s1addr += cnt;
+		if (s1len > 0) {
+			s1 = ReadV(s1addr, OP_BYTE, RA);
+			s2 = fill;
+		}
+	} else if ((s1 == s2) && (s2len > 0)) {
+		cnt     = vax_SkipString(vax, s2addr, s2len, fill);
+		s2len  -= cnt;
+		s2addr += cnt;
+		if (s2len > 0) {
+			s1 = fill;
+			s2 = ReadV(s2addr, OP_BYTE, RA);
 		}
+	}
 
-		cc =  (s1 < s2) ? CC_N : 0;
-		cc |= (s1 == s2) ? CC_Z : 0;
-		cc |= ((uint8)s1 < (uint8)s2) ? CC_C : 0;
-	} else
-		cc = CC_Z;
+	cc =  (s1 < s2) ? CC_N : 0;
+	cc |= (s1 == s2) ? CC_Z : 0;
+	cc |= ((uint8)s1 < (uint8)s2) ? CC_C : 0;
 
 	// Update condition bits
 	CC = cc;
@@ -113,7 +203,9 @@ DEF_INST(vax, LOCC)
 	uint8  ch   = OP0;
 	uint16 len  = OP1;
 	int32  addr = OP2;
-	uint8  fch;
+	uint32 cnt;
+	uint8  *str, *fp;
+	uint8  buf;
 
 #ifdef DEBUG
 	if (dbg_Check(DBG_TRACE|DBG_DATA))
@@ -123,16 +215,18 @@ DEF_INST(vax, LOCC)
 
 	// Find a character in that string.
 	while (len > 0) {
-		fch = ReadV(addr, OP_BYTE, RA) & BMASK;
-		if (ch == fch) {
+		str = vax_MapString(vax, addr, len, &cnt, &buf);
+		if (fp = memchr(str, ch, cnt)) {
+			len  -= fp - str;
+			addr += fp - str;
 #ifdef DEBUG
 			if (dbg_Check(DBG_TRACE|DBG_DATA))
 				dbg_Printf("LOCC: Found at location %08X\n", addr);
 #endif /* DEBUG */
 			break;
 		}
-		len--;
-		addr++;
+		len  -= cnt;
+		addr += cnt;
 	}
 
 	// Update registers
@@ -149,117 +243,184 @@ DEF_INST(vax, LOCC)
 #endif /* DEBUG */
 }
 
-// 28 MOVC3 - Move Character 3 Operand
-DEF_INST(vax, MOVC3)
+// MOVC3/MOVC5 Move Engine
+//
+// Strings are moved page by page with host memmove/memset.  Both
+// pages are translated first, so a page fault can not occur in the
+// middle of a run.  Registers are updated after every run and FPD
+// is set, so that instruction will be resumed after a page fault.
+//
+//   R0<15:0>   Number of bytes left to move
+//   R0<16>     Moving backward (destination above source)
+//   R0<31:24>  Instruction length (Delta PC)
+//   R1         Current source address
+//   R2<15:0>   Number of bytes left to fill
+//   R3         Current destination address
+//   R4<7:0>    Fill character
+//   R4<31:16>  Total number of bytes to move
+//   R5<15:0>   Destination length
+//   R5<31:16>  Source length
+//
+// When moving backward, R1 and R3 point one byte past the next
+// byte to be moved and destination is filled first.
+
+#define MVC_BACK      0x00010000
+#define MVC_P_DPC     24
+#define MVC_GETDPC(r) (((r) >> MVC_P_DPC) & BMASK)
+
+static void vax_SetupMoveChar(register VAX_CPU *vax, uint16 srcLen,
+	uint32 srcAddr, uint8 fill, uint16 dstLen, uint32 dstAddr)
 {
-	uint16 len     = OP0;
-	uint32 srcAddr = OP1;
-	uint32 dstAddr = OP2;
-	uint16 svlen;
-	uint8  ch;
+	uint16 mvLen = (srcLen < dstLen) ? srcLen : dstLen;
 
 	if (srcAddr > dstAddr) {
-		while (len > 0) {
-			ch = ReadV(srcAddr, OP_BYTE, RA);
-			WriteV(dstAddr, ch, OP_BYTE, WA);
-			len--;
-			srcAddr++;
-			dstAddr++;
-		}
+		R0 = mvLen;
 		R1 = srcAddr;
 		R3 = dstAddr;
 	} else {
-		svlen = len;
-		srcAddr += len;
-		dstAddr += len;
-		while (len > 0) {
-			len--;
-			srcAddr--;
-			dstAddr--;
-			ch = ReadV(srcAddr, OP_BYTE, RA);
-			WriteV(dstAddr, ch, OP_BYTE, WA);
-		}
-		R1 = srcAddr + svlen;
-		R3 = dstAddr + svlen;
+		R0 = mvLen | MVC_BACK;
+		R1 = srcAddr + mvLen;
+		R3 = dstAddr + dstLen;
 	}
-	
-	// Clear rest of registers
-	R0 = 0;
-	R2 = 0;
-	R4 = 0;
-	R5 = 0;
-
-	// Update condition bits
-	CC = CC_Z;
+	R0  |= (PC - faultPC) << MVC_P_DPC;
+	R2   = dstLen - mvLen;
+	R4   = fill | (mvLen << 16);
+	R5   = dstLen | (srcLen << 16);
+	PSL |= PSL_FPD;
 }
 
-// 2C MOVC5 - Move Character 5 Operand
-DEF_INST(vax, MOVC5)
+static void vax_MoveChar(register VAX_CPU *vax)
 {
-	uint16 srcLen  = OP0;
-	uint32 srcAddr = OP1;
-	uint8  fill    = OP2;
-	uint16 dstLen  = OP3;
-	uint32 dstAddr = OP4;
-	uint16 srcLen2 = srcLen;
-	uint16 dstLen2 = dstLen;
-	uint16 sv_srcLen, sv_dstLen;
-	uint8  ch;
-
-#ifdef DEBUG
-	if (dbg_Check(DBG_TRACE|DBG_DATA)) {
-		dbg_Printf("MOVC5: SA %08X (%04X) => DA %08X (%04X)\n",
-			srcAddr, srcLen, dstAddr, dstLen);
-		dbg_Printf("MOVC5: Fill = %02X\n", fill);
-	}
-#endif /* DEBUG */
-
-
-	if (srcAddr > dstAddr) {
-		while ((srcLen > 0) && (dstLen > 0)) {
-			ch = ReadV(srcAddr, OP_BYTE, RA);
-			WriteV(dstAddr, ch, OP_BYTE, WA);
-			srcLen--;
-			srcAddr++;
-			dstLen--;
-			dstAddr++;
+	uint32 mvLen   = ZXTW(R0);
+	uint32 srcAddr = R1;
+	uint32 fillLen = ZXTW(R2);
+	uint32 dstAddr = R3;
+	uint8  fill    = R4;
+	uint16 srcLen, dstLen;
+	uint32 cnt;
+	uint8  *src, *dst;
+
+	if ((R0 & MVC_BACK) == 0) {
+		// Move forward then fill rest of destination.
+		while (mvLen > 0) {
+			cnt = VA_PAGESIZE - VA_GETOFF(srcAddr);
+			if (cnt > VA_PAGESIZE - VA_GETOFF(dstAddr))
+				cnt = VA_PAGESIZE - VA_GETOFF(dstAddr);
+			if (cnt > mvLen)
+				cnt = mvLen;
+			src = vax_MapPage(vax, srcAddr, RA);
+			dst = vax_MapPage(vax, dstAddr, WA);
+			if (src && dst)
+				memmove(dst, src, cnt);
+			else {
+				// I/O space - Move one byte at a time.
+				cnt = 1;
+				WriteV(dstAddr, ReadV(srcAddr, OP_BYTE, RA), OP_BYTE, WA);
+			}
+			mvLen   -= cnt;
+			srcAddr += cnt;
+			dstAddr += cnt;
+			R0 = (R0 & ~WMASK) | mvLen;
+			R1 = srcAddr;
+			R3 = dstAddr;
 		}
-		while (dstLen > 0) {
-			WriteV(dstAddr, fill, OP_BYTE, WA);
-			dstLen--;
-			dstAddr++;
+
+		while (fillLen > 0) {
+			cnt = VA_PAGESIZE - VA_GETOFF(dstAddr);
+			if (cnt > fillLen)
+				cnt = fillLen;
+			if (dst = vax_MapPage(vax, dstAddr, WA))
+				memset(dst, fill, cnt);
+			else {
+				cnt = 1;
+				WriteV(dstAddr, fill, OP_BYTE, WA);
+			}
+			fillLen -= cnt;
+			dstAddr += cnt;
+			R2 = fillLen;
+			R3 = dstAddr;
 		}
-		R1 = srcAddr;
-		R3 = dstAddr;
 	} else {
-		sv_srcLen = (srcLen < dstLen) ? srcLen : dstLen;
-		sv_dstLen = dstLen;
-		srcAddr   += sv_srcLen;
-		dstAddr   += sv_dstLen;
-		while (dstLen > srcLen) {
-			dstLen--;
-			dstAddr--;
-			WriteV(dstAddr, fill, OP_BYTE, WA);
+		// Fill top of destination then move backward.
+		while (fillLen > 0) {
+			cnt = VA_GETOFF(dstAddr - 1) + 1;
+			if (cnt > fillLen)
+				cnt = fillLen;
+			if (dst = vax_MapPage(vax, dstAddr - cnt, WA))
+				memset(dst, fill, cnt);
+			else {
+				cnt = 1;
+				WriteV(dstAddr - 1, fill, OP_BYTE, WA);
+			}
+			fillLen -= cnt;
+			dstAddr -= cnt;
+			R2 = fillLen;
+			R3 = dstAddr;
 		}
-		while (dstLen > 0) {
-			srcLen--;
-			srcAddr--;
-			dstLen--;
-			dstAddr--;
-			ch = ReadV(srcAddr, OP_BYTE, RA);
-			WriteV(dstAddr, ch, OP_BYTE, WA);
+
+		while (mvLen > 0) {
+			cnt = VA_GETOFF(srcAddr - 1) + 1;
+			if (cnt > VA_GETOFF(dstAddr - 1) + 1)
+				cnt = VA_GETOFF(dstAddr - 1) + 1;
+			if (cnt > mvLen)
+				cnt = mvLen;
+			src = vax_MapPage(vax, srcAddr - cnt, RA);
+			dst = vax_MapPage(vax, dstAddr - cnt, WA);
+			if (src && dst)
+				memmove(dst, src, cnt);
+			else {
+				cnt = 1;
+				WriteV(dstAddr - 1, ReadV(srcAddr - 1, OP_BYTE, RA), OP_BYTE, WA);
+			}
+			mvLen   -= cnt;
+			srcAddr -= cnt;
+			dstAddr -= cnt;
+			R0 = (R0 & ~WMASK) | mvLen;
+			R1 = srcAddr;
+			R3 = dstAddr;
 		}
-		R1 = srcAddr + sv_srcLen;
-		R3 = dstAddr + sv_dstLen;
+
+		// Point past end of strings.
+		R1 += ZXTW(R4 >> 16);
+		R3 += ZXTW(R5);
 	}
 
-	R0 = srcLen;
-	R2 = 0;
-	R4 = 0;
-	R5 = 0;
+	// All done - set final results.
+	srcLen = R5 >> 16;
+	dstLen = R5;
+	SET_PC(faultPC + MVC_GETDPC(R0));
+	R0   = srcLen - ZXTW(R4 >> 16);
+	R2   = 0;
+	R4   = 0;
+	R5   = 0;
+	PSL &= ~PSL_FPD;
 
 	// Update condition codes
-	CC_CMP_W((int16)srcLen2, (int16)dstLen2);
+	CC_CMP_W((int16)srcLen, (int16)dstLen);
+}
+
+// 28 MOVC3 - Move Character 3 Operand
+DEF_INST(vax, MOVC3)
+{
+	if ((PSL & PSL_FPD) == 0)
+		vax_SetupMoveChar(vax, OP0, OP1, 0, OP0, OP2);
+	vax_MoveChar(vax);
+}
+
+// 2C MOVC5 - Move Character 5 Operand
+DEF_INST(vax, MOVC5)
+{
+	if ((PSL & PSL_FPD) == 0) {
+#ifdef DEBUG
+		if (dbg_Check(DBG_TRACE|DBG_DATA)) {
+			dbg_Printf("MOVC5: SA %08X (%04X) => DA %08X (%04X)\n",
+				OP1, ZXTW(OP0), OP4, ZXTW(OP3));
+			dbg_Printf("MOVC5: Fill = %02X\n", ZXTB(OP2));
+		}
+#endif /* DEBUG */
+		vax_SetupMoveChar(vax, OP0, OP1, OP2, OP3, OP4);
+	}
+	vax_MoveChar(vax);
 }
 
 DEF_INST(vax, SCANC)
@@ -268,16 +429,24 @@ DEF_INST(vax, SCANC)
 	int32  addr    = OP1;
 	int32  tbladdr = OP2;
 	uint8  mask    = OP3;
-	uint8  ch, tmp;
+	uint8  table[256];
+	uint32 cnt, idx;
+	uint8  *str;
+	uint8  buf;
+
+	if (len > 0)
+		vax_LoadTable(vax, tbladdr, table);
 
 	// Scan Characters
 	while (len > 0) {
-		ch  = ReadV(addr, OP_BYTE, RA);
-		tmp = ReadV(tbladdr + ch, OP_BYTE, RA);
-		if (tmp & mask)
+		str = vax_MapString(vax, addr, len, &cnt, &buf);
+		for (idx = 0; idx < cnt; idx++)
+			if (table[str[idx]] & mask)
+				break;
+		len  -= idx;
+		addr += idx;
+		if (idx < cnt)
 			break;
-		len--;
-		addr++;
 	}
 
 	// Update condition bits
@@ -295,14 +464,12 @@ DEF_INST(vax, SKPC)
 	uint8  ch   = OP0;
 	uint16 len  = OP1;
 	int32  addr = OP2;
+	uint32 cnt;
 
 	// Skip Character(s)
-	while (len > 0) {
-		if ((ReadV(addr, OP_BYTE, RA) & BMASK) != ch)
-			break;
-		len--;
-		addr++;
-	}
+	cnt   = vax_SkipString(vax, addr, len, ch);
+	len  -= cnt;
+	addr += cnt;
 
 	// Update condition bits
 	CC = (len == 0) ? CC_Z : 0;
@@ -318,16 +485,24 @@ DEF_INST(vax, SPANC)
 	int32  addr    = OP1;
 	int32  tbladdr = OP2;
 	uint8  mask    = OP3;
-	uint8  ch, tmp;
+	uint8  table[256];
+	uint32 cnt, idx;
+	uint8  *str;
+	uint8  buf;
+
+	if (len > 0)
+		vax_LoadTable(vax, tbladdr, table);
 
 	// Span Characters
 	while (len > 0) {
-		ch  = ReadV(addr, OP_BYTE, RA);
-		tmp = ReadV(tbladdr + ch, OP_BYTE, RA);
-		if ((tmp & mask) == 0)
+		str = vax_MapString(vax, addr, len, &cnt, &buf);
+		for (idx = 0; idx < cnt; idx++)
+			if ((table[str[idx]] & mask) == 0)
+				break;
+		len  -= idx;
+		addr += idx;
+		if (idx < cnt)
 			break;
-		len--;
-		addr++;
 	}
 
 	// Update condition bits
@@ -87,6 +87,9 @@
 
 #define ISTR_NORMAL  0x00000000 // Normal Instruction
 #define ISTR_EMULATE 0x80000000 // Instruction is emulatable
+#define ISTR_CONTEXT 0x00000400 // Instruction changes mapping or mode
+#define ISTR_JUMP    0x00000200 // Instruction changes flow or context
+#define ISTR_FPD     0x00000100 // Instruction is restartable (First Part Done)
 #define ISTR_STRING  0x00000080 // String Instructions
 #define ISTR_PACKED  0x00000040 // Packed Instructions
 #define ISTR_VECTOR  0x00000020 // Vector Instructions
@@ -444,7 +447,7 @@
 // Processor Status macro definitions
 #define PSL vax->stReg
 #define PSW vax->stReg
-#define CC  vax->ccReg
+#define CC  (*vax_EvalCC(vax)) // See Lazy Condition Codes below
 
 // Processor Status Long Register (32-bit word)
 #define PSL_MBZ  0x3020FF00 // Must Be Zeros
@@ -508,6 +511,95 @@ typedef struct {
 	void   (*Execute)(); // Execute Routine
 } INSTRUCTION;
 
+// Decoded Instruction Cache
+//
+// Each entry holds an instruction already fetched from the instruction
+// stream, keyed by its physical PC.  Specifier data (mode bytes, index
+// bytes, displacements and immediates) are kept in order as they were
+// fetched.  When an entry is completed, each specifier is also decoded
+// once into a descriptor (kind, base register, displacement, absolute
+// address or operand value) so that common addressing modes are
+// replayed without decoding them again.  Other modes (autoincrement,
+// autodecrement and indexed) replay their specifier data through the
+// operand decoder without going through the prefetch buffer again.
+// Entries are validated against a per-page generation count which is
+// bumped by any write to a page holding cached instructions.
+
+#define IC_N_SIZE  12                  // Cache Index Size
+#define IC_SIZE    (1 << IC_N_SIZE)    // Number of Cache Entries
+#define IC_M_SIZE  (IC_SIZE - 1)       // Cache Index Mask
+#define IC_MAXDATA 24                  // Maximum Specifier Data
+#define IC_NONE    0xFFFFFFFF          // Empty Entry
+#define IC_LIVE    1                   // Page holds cached instructions
+
+#define IC_INDEX(ppc) (((ppc) ^ ((ppc) >> IC_N_SIZE)) & IC_M_SIZE)
+
+// Decoded Specifier Kinds
+#define IC_RAW     0  // Replay specifier data through decoder
+#define IC_BRANCH  1  // Branch displacement
+#define IC_VALUE   2  // Literal or immediate operand value
+#define IC_REG     3  // Register
+#define IC_DISP    4  // Register + displacement
+#define IC_DISPD   5  // Register + displacement deferred
+#define IC_ABS     6  // Absolute address
+
+typedef struct {
+	uint8  Kind;             // Specifier Kind
+	uint8  Reg;              // Base Register
+	uint8  Length;           // Specifier Length in Bytes
+	uint8  Data;             // First Specifier Data
+	int32  Value[2];         // Displacement, Address or Value
+} ICSPEC;
+
+typedef struct {
+	uint32 ppc;              // Physical PC (Tag)
+	uint32 gen;              // Page Generation
+	uint16 opCode;           // Opcode
+	uint8  nLength;          // Instruction Length in Bytes
+	uint8  nData;            // Number of Specifier Data
+	ICSPEC Spec[MAX_SPEC];   // Decoded Specifiers
+	int32  Data[IC_MAXDATA]; // Specifier Data
+} ICENTRY;
+
+// Call-Threaded Instruction Blocks
+//
+// With VAX_BLOCKS, straight-line runs of cached instructions that are
+// executed often enough get x86-64 host code which calls a replay
+// routine and the instruction handler for each instruction in turn.
+// That is not a compiler - instructions are still executed by their
+// handlers - but fetch, cache lookup and dispatch are gone from hot
+// loops.  Blocks are keyed by physical PC, never cross a page and end
+// at any instruction flagged ISTR_JUMP.  They are checked against the
+// same page generation counts as the instruction cache.
+
+#if defined(VAX_BLOCKS) && !(defined(__GNUC__) && defined(__x86_64__))
+#warning "VAX_BLOCKS requires GCC on x86-64 hosts - using interpreter only."
+#undef VAX_BLOCKS
+#endif
+
+#ifdef VAX_BLOCKS
+#define BLK_N_TABLE   11                   // Block Index Size
+#define BLK_TABLE     (1 << BLK_N_TABLE)   // Number of Blocks
+#define BLK_M_TABLE   (BLK_TABLE - 1)      // Block Index Mask
+#define BLK_MAXINST   16                   // Maximum Instructions per Block
+#define BLK_THRESHOLD 64                   // Executions before Translation
+#define BLK_CODESIZE  (4 << 20)            // Size of Host Code Buffer
+
+#define BLK_INDEX(ppc) (((ppc) ^ ((ppc) >> BLK_N_TABLE)) & BLK_M_TABLE)
+
+typedef struct vax_Block VAX_BLOCK;
+
+struct vax_Block {
+	uint32    ppc;               // Physical PC (Tag)
+	uint32    gen;               // Page Generation
+	uint32    nCount;            // Execution Count
+	uint32    nInst;             // Number of Instructions
+	uint8     *Code;             // Host Code (NULL if not translated)
+	VAX_BLOCK *Link;             // Last Successor Block
+	ICENTRY   Inst[BLK_MAXINST]; // Decoded Instructions
+};
+#endif /* VAX_BLOCKS */
+
 // I/O Memory Map
 typedef struct {
 	uint32 loAddr;      // Address Low
@@ -521,6 +613,9 @@ typedef struct vax_System    VAX_SYSTEM;
 typedef struct vax_Processor VAX_CPU;
 typedef struct vax_Console   VAX_CONSOLE;
 
+// Operand Specifier Decoder
+typedef int (*SPECDEC)(VAX_CPU *, uint32, int);
+
 struct vax_System {
 	// System Identification
 	char *devName;    // System Device
@@ -550,7 +645,12 @@ struct vax_Processor {
 	// Instruction Table for this processor
 	void    (*tblOpcode[NUM_INST])();
 	uint32  tblOperand[NUM_INST][MAX_SPEC+1];
+	SPECDEC tblSpecs[NUM_INST][MAX_SPEC+1]; // Specifier Decoders
+	uint32  tblFlags[NUM_INST];             // Instruction Flags
 	int     ips; // Instructions Per Second Meter
+#ifdef IDLE
+	int     idleWait; // Simulation events already skipped
+#endif /* IDLE */
 
 	// Internal Processor Register Table
 	uint32  (*ReadIPR[MAX_PREGS])(uint8, uint32 *);
@@ -571,6 +671,12 @@ struct vax_Processor {
 	int32   gRegs[MAX_GREGS];   // General Registers
 	uint32  stReg;              // Status Register
 	uint32  ccReg;              //   Condition Code
+	int32   ccOp;               //   Lazy Operation
+	int32   ccRes;              //   Lazy Result
+	int32   ccSrc1, ccSrc2;     //   Lazy Operands
+	uint32  ccNeg;              //   Lazy Negative Result
+	uint32  ccSign;             //   Lazy Sign Mask
+	uint32  ccCarry;            //   Lazy Preserved Carry
 	int32   pRegs[MAX_PREGS];   // Processor (Privileged) Registers
 	int32   opRegs[MAX_OPREGS]; // Operand Registers
 	int32   brDisp;             // Branch Displacement Register
@@ -595,6 +701,8 @@ struct vax_Processor {
 	uint32 p1, p2, p3;           // Page Fault Results
 	TLBENT stlbTable[VA_TBSIZE]; // System TLB Table
 	TLBENT ptlbTable[VA_TBSIZE]; // Process TLB Table
+	HTLBENT hrtlbTable[VA_TBSIZE]; // Host TLB Table - Read Access
+	HTLBENT hwtlbTable[VA_TBSIZE]; // Host TLB Table - Write Access
 
 	// RAM (Physical Memory) for VAX series
 	uint8 *RAM;       // Address of physical memory
@@ -603,6 +711,21 @@ struct vax_Processor {
 	int32 sizeRAM;    // Size of physical memory
 	int32 ramMaxSize; // Maximum memory size.
 
+	// Decoded Instruction Cache
+	ICENTRY *icTable;  // Cache Entries
+	uint32  *icPages;  // Page Generations (One per RAM page)
+	ICENTRY *icEntry;  // Entry being filled by decoder
+	int32   *isData;   // Specifier data being replayed
+
+#ifdef VAX_BLOCKS
+	// Call-Threaded Instruction Blocks
+	VAX_BLOCK *blkTable; // Block Table
+	uint8     *blkCode;  // Host Code Buffer
+	uint32    blkUsed;   // Bytes used in code buffer
+	uint32    blkBase;   // Virtual PC of current block
+	uint32    blkCount;  // Instructions executed by host code
+#endif /* VAX_BLOCKS */
+
 	// ROM Image for MicroVAX series
 	uint8 *ROM;
 	int32 baseROM;      // Starting Address of ROM
@@ -666,9 +789,11 @@ struct vax_Processor {
 #define FLT_UNFL_FAULT  P1=FAULT_FLTUND, ABORT(-SCB_ARITH)
 #define NEXT -1
 
-#define SET_TRAP(trap)  TIR = (TIR & TIR_IPL) | ((trap) << TIR_P_TRAP)
+#define SET_TRAP(trap)  TIR = (TIR & TIR_IPL) | ((trap) << TIR_P_TRAP), \
+                        ts10_CutBatch()
 #define CLR_TRAPS       TIR &= ~TIR_TRAP
-#define SET_IRQ         TIR = (TIR & TIR_TRAP) | vax_EvaluateIRQ(vax)
+#define SET_IRQ         ((TIR = (TIR & TIR_TRAP) | vax_EvaluateIRQ(vax)) \
+                        ? ts10_CutBatch() : (void)0)
 #define GET_TRAP(x)     (((x) >> TIR_P_TRAP) & TIR_M_TRAP)
 #define GET_IRQ(x)      (((x) >> TIR_P_IPL) & TIR_M_IPL)
 
@@ -731,6 +856,8 @@ struct vax_Processor {
 #define P3   vax->p3
 #define STLB vax->stlbTable
 #define PTLB vax->ptlbTable
+#define HRTLB vax->hrtlbTable
+#define HWTLB vax->hwtlbTable
 
 // Update Access Mode Routine
 #define SET_ACCESS ACC = ACC_MASK(PSL_GETCUR(PSL))
@@ -764,6 +891,11 @@ ATTR_REGPARM(1) void DEF_NAME(cpu, name)(VAX_CPU *vax)
 #define WriteV(va, data, len, acc) vax_Write(vax, va, data, len, acc)
 #define TestV(va, acc, st)         vax_Test(vax, va, acc, st)
 
+// Invalidate cached instructions on a physical page being written.
+#define IC_WRITE(pa) \
+	if (vax->icPages && (vax->icPages[(pa) >> VA_N_OFF] & IC_LIVE)) \
+		vax->icPages[(pa) >> VA_N_OFF] += IC_LIVE;
+
 // Store/Load Register/Memory
 // Note: This macro only works for little endian at this time.
 
@@ -795,10 +927,30 @@ ATTR_REGPARM(1) void DEF_NAME(cpu, name)(VAX_CPU *vax)
 #define CC_Z1ZP \
 	CC = CC_Z | (CC & CC_C);
 
+// Lazy Condition Codes
+//
+// Most integer instructions do not evaluate condition codes at once.
+// Result, operands and kind of operation are saved instead and
+// condition codes are evaluated when CC is referenced next time
+// (branches, PSL pushes, MOVPSL, etc.).  N is always saved as
+// it is because it depends on type of result.
+
+#define CC_OP_NONE 0 // Condition codes are in ccReg
+#define CC_OP_IIZZ 1 // N,Z from result - V,C cleared
+#define CC_OP_IIZP 2 // N,Z from result - V cleared, C preserved
+#define CC_OP_ADD  3 // Addition
+#define CC_OP_SUB  4 // Subtraction
+#define CC_OP_CMP  5 // Comparison
+
+#define CC_LAZY(op, r, n) \
+	vax->ccOp = (op), vax->ccRes = (r), vax->ccNeg = (n)
+
+#define CC_ARITH(op, r, s1, s2, sign) \
+	CC_LAZY(op, r, (r) < 0), vax->ccSrc1 = (s1), \
+	vax->ccSrc2 = (s2), vax->ccSign = (sign)
+
 #define CC_IIZZ_I(r) \
-	if ((r) < 0)       CC = CC_N; \
-	else if ((r) == 0) CC = CC_Z; \
-	else               CC = 0;
+	CC_LAZY(CC_OP_IIZZ, r, (r) < 0);
 
 #define CC_IIZZ_B(r) CC_IIZZ_I(r)
 #define CC_IIZZ_W(r) CC_IIZZ_I(r)
@@ -816,9 +968,8 @@ ATTR_REGPARM(1) void DEF_NAME(cpu, name)(VAX_CPU *vax)
 
 
 #define CC_IIZP_I(r) \
-	if ((r) < 0)       CC = CC_N | (CC & CC_C); \
-	else if ((r) == 0) CC = CC_Z | (CC & CC_C); \
-	else               CC = CC & CC_C;
+	vax->ccCarry = vax_GetCarry(vax); \
+	CC_LAZY(CC_OP_IIZP, r, (r) < 0);
 
 #define CC_IIZP_B(r) CC_IIZP_I(r)
 #define CC_IIZP_W(r) CC_IIZP_I(r)
@@ -847,19 +998,16 @@ ATTR_REGPARM(1) void DEF_NAME(cpu, name)(VAX_CPU *vax)
 	if (((uint32)(r)) < ((uint32)(s2)))          CC |= CC_C;
 
 #define CC_ADD_B(r, s1, s2) \
-	CC_IIZZ_B(r); \
-	V_ADD_B(r, s1, s2); \
-	C_ADD(r, s1, s2);
+	CC_ARITH(CC_OP_ADD, r, s1, s2, BSIGN); \
+	if (PSW & PSW_IV) { V_ADD_B(r, s1, s2); }
 
 #define CC_ADD_W(r, s1, s2) \
-	CC_IIZZ_W(r); \
-	V_ADD_W(r, s1, s2); \
-	C_ADD(r, s1, s2);
+	CC_ARITH(CC_OP_ADD, r, s1, s2, WSIGN); \
+	if (PSW & PSW_IV) { V_ADD_W(r, s1, s2); }
 
 #define CC_ADD_L(r, s1, s2) \
-	CC_IIZZ_L(r); \
-	V_ADD_L(r, s1, s2); \
-	C_ADD(r, s1, s2);
+	CC_ARITH(CC_OP_ADD, r, s1, s2, LSIGN); \
+	if (PSW & PSW_IV) { V_ADD_L(r, s1, s2); }
 
 
 #define V_SUB_B(r, s1, s2) \
@@ -872,25 +1020,19 @@ ATTR_REGPARM(1) void DEF_NAME(cpu, name)(VAX_CPU *vax)
 	if (((uint32)(s2)) < ((uint32)(s1)))         CC |= CC_C;
 
 #define CC_SUB_B(r, s1, s2) \
-	CC_IIZZ_B(r); \
-	V_SUB_B(r, s1, s2); \
-	C_SUB(r, s1, s2);
+	CC_ARITH(CC_OP_SUB, r, s1, s2, BSIGN); \
+	if (PSW & PSW_IV) { V_SUB_B(r, s1, s2); }
 
 #define CC_SUB_W(r, s1, s2) \
-	CC_IIZZ_W(r); \
-	V_SUB_W(r, s1, s2); \
-	C_SUB(r, s1, s2);
+	CC_ARITH(CC_OP_SUB, r, s1, s2, WSIGN); \
+	if (PSW & PSW_IV) { V_SUB_W(r, s1, s2); }
 
 #define CC_SUB_L(r, s1, s2) \
-	CC_IIZZ_L(r); \
-	V_SUB_L(r, s1, s2); \
-	C_SUB(r, s1, s2);
+	CC_ARITH(CC_OP_SUB, r, s1, s2, LSIGN); \
+	if (PSW & PSW_IV) { V_SUB_L(r, s1, s2); }
 
 #define CC_CMP_I(s1, s2) \
-	if ((s1) < (s2))                 CC = CC_N; \
-	else if ((s1) == (s2))           CC = CC_Z; \
-	else                             CC = 0; \
-	if ((uint32)(s1) < (uint32)(s2)) CC |= CC_C;
+	CC_LAZY(CC_OP_CMP, s1, (s1) < (s2)), vax->ccSrc2 = (s2);
 
 #define CC_CMP_B(s1, s2) CC_CMP_I(s1, s2)
 #define CC_CMP_W(s1, s2) CC_CMP_I(s1, s2)
@@ -900,3 +1042,50 @@ ATTR_REGPARM(1) void DEF_NAME(cpu, name)(VAX_CPU *vax)
 
 // Procedure/Function prototype definitions
 #include "vax/proto.h"
+
+// Return carry bit without evaluating all condition codes.
+static __inline__ uint32 vax_GetCarry(register VAX_CPU *vax)
+{
+	switch (vax->ccOp) {
+		case CC_OP_NONE:
+			return vax->ccReg & CC_C;
+		case CC_OP_IIZP:
+			return vax->ccCarry;
+		case CC_OP_ADD:
+			return ((uint32)vax->ccRes < (uint32)vax->ccSrc2) ? CC_C : 0;
+		case CC_OP_SUB:
+			return ((uint32)vax->ccSrc2 < (uint32)vax->ccSrc1) ? CC_C : 0;
+		case CC_OP_CMP:
+			return ((uint32)vax->ccRes < (uint32)vax->ccSrc2) ? CC_C : 0;
+	}
+	return 0;
+}
+
+// Evaluate condition codes from last operation if needed.
+static __inline__ uint32 *vax_EvalCC(register VAX_CPU *vax)
+{
+	if (vax->ccOp != CC_OP_NONE)
+		vax_UpdateCC(vax);
+	return &vax->ccReg;
+}
+
+// Translate current PC to physical address for the decoded
+// instruction cache.  Only current TLB entries are checked, so
+// no memory management faults will be taken here.  Return IC_NONE
+// if PC is not mapped yet.
+static __inline__ uint32 vax_GetPhysPC(register VAX_CPU *vax)
+{
+	uint32 vpn, tbi;
+	TLBENT xpte;
+
+	if (MAPEN == 0)
+		return PC & PAMASK;
+
+	vpn  = VA_GETVPN(PC);
+	tbi  = VA_GETTBI(vpn);
+	xpte = (PC & VA_S0) ? STLB[tbi] : PTLB[tbi];
+	if (((xpte.pte & RA) == 0) || (xpte.tag != vpn))
+		return IC_NONE;
+
+	return (xpte.pte & TLB_PFN) | VA_GETOFF(PC);
+}
@@ -329,7 +329,7 @@ void vax_ConsoleOutput(VAX_CONSOLE *cty)
 		TXCS &= ~TXCS_RDY;
 		ch = TXDB;
 
-		sock_Print(cty->Socket, &ch, 1);
+		sock_Output(cty->Socket, &ch, 1);
 
 		// Log a character into a log file.
 		if (ch == '\n') {
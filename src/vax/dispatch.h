@@ -0,0 +1,244 @@
+// dispatch.h - VAX Instruction Handlers for Threaded Dispatch
+//
+// Copyright (c) 2001-2002, Timothy M. Stark
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// TIMOTHY M STARK BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// Except as contained in this notice, the name of Timothy M Stark shall not
+// be used in advertising or otherwise to promote the sale, use or other 
+// dealings in this Software without prior written authorization from
+// Timothy M Stark.
+
+// List of instruction handlers for threaded dispatch.  Each entry
+// gets its own label in vax_Execute so that every handler returns to
+// its own copy of the dispatch jump.  Handlers not listed here
+// (illegal, unimplemented and emulated opcodes) are called through
+// the opcode table instead, so an entry missing from this list only
+// costs speed.
+
+#define VAX_HANDLERS \
+	VAX_HANDLER(HALT) \
+	VAX_HANDLER(NOP) \
+	VAX_HANDLER(REI) \
+	VAX_HANDLER(BPT) \
+	VAX_HANDLER(RET) \
+	VAX_HANDLER(RSB) \
+	VAX_HANDLER(LDPCTX) \
+	VAX_HANDLER(SVPCTX) \
+	VAX_HANDLER(INDEX) \
+	VAX_HANDLER(PROBER) \
+	VAX_HANDLER(PROBEW) \
+	VAX_HANDLER(INSQUE) \
+	VAX_HANDLER(REMQUE) \
+	VAX_HANDLER(BSBB) \
+	VAX_HANDLER(BRB) \
+	VAX_HANDLER(BNEQ) \
+	VAX_HANDLER(BEQL) \
+	VAX_HANDLER(BGTR) \
+	VAX_HANDLER(BLEQ) \
+	VAX_HANDLER(JSB) \
+	VAX_HANDLER(JMP) \
+	VAX_HANDLER(BGEQ) \
+	VAX_HANDLER(BLSS) \
+	VAX_HANDLER(BGTRU) \
+	VAX_HANDLER(BLEQU) \
+	VAX_HANDLER(BVC) \
+	VAX_HANDLER(BVS) \
+	VAX_HANDLER(BCC) \
+	VAX_HANDLER(BCS) \
+	VAX_HANDLER(MOVC3) \
+	VAX_HANDLER(CMPC3) \
+	VAX_HANDLER(SCANC) \
+	VAX_HANDLER(SPANC) \
+	VAX_HANDLER(MOVC5) \
+	VAX_HANDLER(CMPC5) \
+	VAX_HANDLER(BSBW) \
+	VAX_HANDLER(BRW) \
+	VAX_HANDLER(CVTWL) \
+	VAX_HANDLER(CVTWB) \
+	VAX_HANDLER(LOCC) \
+	VAX_HANDLER(SKPC) \
+	VAX_HANDLER(MOVZWL) \
+	VAX_HANDLER(ACBW) \
+	VAX_HANDLER(MOVL) \
+	VAX_HANDLER(PUSHL) \
+	VAX_HANDLER(ADDF) \
+	VAX_HANDLER(SUBF) \
+	VAX_HANDLER(MULF) \
+	VAX_HANDLER(DIVF) \
+	VAX_HANDLER(CVTFB) \
+	VAX_HANDLER(CVTFW) \
+	VAX_HANDLER(CVTFL) \
+	VAX_HANDLER(CVTRFL) \
+	VAX_HANDLER(CVTBF) \
+	VAX_HANDLER(CVTWF) \
+	VAX_HANDLER(CVTLF) \
+	VAX_HANDLER(ACBF) \
+	VAX_HANDLER(MOVF) \
+	VAX_HANDLER(CMPF) \
+	VAX_HANDLER(MNEGF) \
+	VAX_HANDLER(TSTF) \
+	VAX_HANDLER(EMODF) \
+	VAX_HANDLER(POLYF) \
+	VAX_HANDLER(CVTFD) \
+	VAX_HANDLER(ADAWI) \
+	VAX_HANDLER(INSQHI) \
+	VAX_HANDLER(INSQTI) \
+	VAX_HANDLER(REMQHI) \
+	VAX_HANDLER(REMQTI) \
+	VAX_HANDLER(ADDD) \
+	VAX_HANDLER(SUBD) \
+	VAX_HANDLER(MULD) \
+	VAX_HANDLER(DIVD) \
+	VAX_HANDLER(CVTDB) \
+	VAX_HANDLER(CVTDW) \
+	VAX_HANDLER(CVTDL) \
+	VAX_HANDLER(CVTRDL) \
+	VAX_HANDLER(CVTBD) \
+	VAX_HANDLER(CVTWD) \
+	VAX_HANDLER(CVTLD) \
+	VAX_HANDLER(ACBD) \
+	VAX_HANDLER(MOVD) \
+	VAX_HANDLER(CMPD) \
+	VAX_HANDLER(MNEGD) \
+	VAX_HANDLER(TSTD) \
+	VAX_HANDLER(EMODD) \
+	VAX_HANDLER(POLYD) \
+	VAX_HANDLER(CVTDF) \
+	VAX_HANDLER(ASHL) \
+	VAX_HANDLER(ASHQ) \
+	VAX_HANDLER(EMUL) \
+	VAX_HANDLER(EDIV) \
+	VAX_HANDLER(CLRQ) \
+	VAX_HANDLER(MOVQ) \
+	VAX_HANDLER(ADDB) \
+	VAX_HANDLER(SUBB) \
+	VAX_HANDLER(MULB) \
+	VAX_HANDLER(DIVB) \
+	VAX_HANDLER(BISB) \
+	VAX_HANDLER(BICB) \
+	VAX_HANDLER(XORB) \
+	VAX_HANDLER(MNEGB) \
+	VAX_HANDLER(CASEB) \
+	VAX_HANDLER(MOVB) \
+	VAX_HANDLER(CMPB) \
+	VAX_HANDLER(MCOMB) \
+	VAX_HANDLER(BITB) \
+	VAX_HANDLER(CLRB) \
+	VAX_HANDLER(TSTB) \
+	VAX_HANDLER(INCB) \
+	VAX_HANDLER(DECB) \
+	VAX_HANDLER(CVTBL) \
+	VAX_HANDLER(CVTBW) \
+	VAX_HANDLER(MOVZBL) \
+	VAX_HANDLER(MOVZBW) \
+	VAX_HANDLER(ROTL) \
+	VAX_HANDLER(ACBB) \
+	VAX_HANDLER(ADDW) \
+	VAX_HANDLER(SUBW) \
+	VAX_HANDLER(MULW) \
+	VAX_HANDLER(DIVW) \
+	VAX_HANDLER(BISW) \
+	VAX_HANDLER(BICW) \
+	VAX_HANDLER(XORW) \
+	VAX_HANDLER(MNEGW) \
+	VAX_HANDLER(CASEW) \
+	VAX_HANDLER(MOVW) \
+	VAX_HANDLER(CMPW) \
+	VAX_HANDLER(MCOMW) \
+	VAX_HANDLER(BITW) \
+	VAX_HANDLER(CLRW) \
+	VAX_HANDLER(TSTW) \
+	VAX_HANDLER(INCW) \
+	VAX_HANDLER(DECW) \
+	VAX_HANDLER(BISPSW) \
+	VAX_HANDLER(BICPSW) \
+	VAX_HANDLER(POPR) \
+	VAX_HANDLER(PUSHR) \
+	VAX_HANDLER(CHMK) \
+	VAX_HANDLER(CHME) \
+	VAX_HANDLER(CHMS) \
+	VAX_HANDLER(CHMU) \
+	VAX_HANDLER(ADDL) \
+	VAX_HANDLER(SUBL) \
+	VAX_HANDLER(MULL) \
+	VAX_HANDLER(DIVL) \
+	VAX_HANDLER(BISL) \
+	VAX_HANDLER(BICL) \
+	VAX_HANDLER(XORL) \
+	VAX_HANDLER(MNEGL) \
+	VAX_HANDLER(CASEL) \
+	VAX_HANDLER(CMPL) \
+	VAX_HANDLER(MCOML) \
+	VAX_HANDLER(BITL) \
+	VAX_HANDLER(CLRL) \
+	VAX_HANDLER(TSTL) \
+	VAX_HANDLER(INCL) \
+	VAX_HANDLER(DECL) \
+	VAX_HANDLER(ADWC) \
+	VAX_HANDLER(SBWC) \
+	VAX_HANDLER(MTPR) \
+	VAX_HANDLER(MFPR) \
+	VAX_HANDLER(MOVPSL) \
+	VAX_HANDLER(BBS) \
+	VAX_HANDLER(BBC) \
+	VAX_HANDLER(BBSS) \
+	VAX_HANDLER(BBCS) \
+	VAX_HANDLER(BBSC) \
+	VAX_HANDLER(BBCC) \
+	VAX_HANDLER(BLBS) \
+	VAX_HANDLER(BLBC) \
+	VAX_HANDLER(FFS) \
+	VAX_HANDLER(FFC) \
+	VAX_HANDLER(CMPV) \
+	VAX_HANDLER(CMPZV) \
+	VAX_HANDLER(EXTV) \
+	VAX_HANDLER(EXTZV) \
+	VAX_HANDLER(INSV) \
+	VAX_HANDLER(ACBL) \
+	VAX_HANDLER(AOBLSS) \
+	VAX_HANDLER(AOBLEQ) \
+	VAX_HANDLER(SOBGEQ) \
+	VAX_HANDLER(SOBGTR) \
+	VAX_HANDLER(CVTLB) \
+	VAX_HANDLER(CVTLW) \
+	VAX_HANDLER(CALLG) \
+	VAX_HANDLER(CALLS) \
+	VAX_HANDLER(XFC) \
+	VAX_HANDLER(CVTGF) \
+	VAX_HANDLER(ADDG) \
+	VAX_HANDLER(SUBG) \
+	VAX_HANDLER(MULG) \
+	VAX_HANDLER(DIVG) \
+	VAX_HANDLER(CVTGB) \
+	VAX_HANDLER(CVTGW) \
+	VAX_HANDLER(CVTGL) \
+	VAX_HANDLER(CVTRGL) \
+	VAX_HANDLER(CVTBG) \
+	VAX_HANDLER(CVTWG) \
+	VAX_HANDLER(CVTLG) \
+	VAX_HANDLER(ACBG) \
+	VAX_HANDLER(MOVG) \
+	VAX_HANDLER(CMPG) \
+	VAX_HANDLER(MNEGG) \
+	VAX_HANDLER(TSTG) \
+	VAX_HANDLER(EMODG) \
+	VAX_HANDLER(POLYG) \
+	VAX_HANDLER(CVTFG) \
+	VAX_HANDLER(BUGL) \
+	VAX_HANDLER(BUGW)
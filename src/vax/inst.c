@@ -30,7 +30,7 @@ INSTRUCTION vax_Instruction[] =
 {
 	{
 		"HALT", "Halt",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0x00,   // Opcode (Extended + Normal)
 		0,            // Number of Operands
 		{ 0 , 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -50,7 +50,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"REI", "Return from exception or interrupt",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP|ISTR_CONTEXT, // Instruction Flags
 		0x00, 0x02,   // Opcode (Extended + Normal)
 		0,            // Number of Operands
 		{ 0 , 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -60,7 +60,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"BPT", "Break point trap",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0x03,   // Opcode (Extended + Normal)
 		0,            // Number of Operands
 		{ 0 , 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -70,7 +70,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"RET", "Return from called procedure",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0x04,   // Opcode (Extended + Normal)
 		0,            // Number of Operands
 		{ 0 , 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -80,7 +80,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"RSB", "Return from subroutine",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0x05,   // Opcode (Extended + Normal)
 		0,            // Number of Operands
 		{ 0 , 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -90,7 +90,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"LDPCTX", "Load program context",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP|ISTR_CONTEXT, // Instruction Flags
 		0x00, 0x06,   // Opcode (Extended + Normal)
 		0,            // Number of Operands
 		{ 0 , 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -100,7 +100,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"SVPCTX", "Save program context",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP|ISTR_CONTEXT, // Instruction Flags
 		0x00, 0x07,   // Opcode (Extended + Normal)
 		0,            // Number of Operands
 		{ 0 , 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -270,7 +270,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"JSB", "Jump to subroutine",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0x16,   // Opcode (Extended + Normal)
 		1,            // Number of Operands
 		{ AB, 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -280,7 +280,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"JMP", "Jump",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0x17,   // Opcode (Extended + Normal)
 		1,            // Number of Operands
 		{ AB, 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -470,7 +470,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"MOVC3", "Move character 3 operand",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_FPD,     // Instruction Flags
 		0x00, 0x28,   // Opcode (Extended + Normal)
 		3,            // Number of Operands
 		{ RW, AB, AB, 0 , 0 , 0  }, // Operand Scale/Mode
@@ -510,7 +510,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"MOVC5", "Move character 5 operand",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_FPD,     // Instruction Flags
 		0x00, 0x2C,   // Opcode (Extended + Normal)
 		5,            // Number of Operands
 		{ RW, AB, RB, RW, AB, 0  }, // Operand Scale/Mode
@@ -1510,7 +1510,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"CASEB", "Case byte",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0x8F,   // Opcode (Extended + Normal)
 		3,            // Number of Operands
 		{ RB, RB, RB, 0 , 0 , 0  }, // Operand Scale/Mode
@@ -1830,7 +1830,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"CASEW", "Case word",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0xAF,   // Opcode (Extended + Normal)
 		3,            // Number of Operands
 		{ RW, RW, RW, 0 , 0 , 0  }, // Operand Scale/Mode
@@ -1960,7 +1960,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"CHMK", "Change mode to kernel",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP|ISTR_CONTEXT, // Instruction Flags
 		0x00, 0xBC,   // Opcode (Extended + Normal)
 		1,            // Number of Operands
 		{ RW, 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -1970,7 +1970,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"CHME", "Change mode to executive",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP|ISTR_CONTEXT, // Instruction Flags
 		0x00, 0xBD,   // Opcode (Extended + Normal)
 		1,            // Number of Operands
 		{ RW, 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -1980,7 +1980,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"CHMS", "Change mode to supervisor",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP|ISTR_CONTEXT, // Instruction Flags
 		0x00, 0xBE,   // Opcode (Extended + Normal)
 		1,            // Number of Operands
 		{ RW, 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -1990,7 +1990,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"CHMU", "Change mode to user",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP|ISTR_CONTEXT, // Instruction Flags
 		0x00, 0xBF,   // Opcode (Extended + Normal)
 		1,            // Number of Operands
 		{ RW, 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -2150,7 +2150,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"CASEL", "Case longword",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0xCF,   // Opcode (Extended + Normal)
 		3,            // Number of Operands
 		{ RL, RL, RL, 0 , 0 , 0  }, // Operand Scale/Mode
@@ -2270,7 +2270,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"MTPR", "Move to processor register",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP|ISTR_CONTEXT, // Instruction Flags
 		0x00, 0xDA,     // Opcode (Extended + Normal)
 		2,              // Number of Operands
 		{ RL, RL, 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -2610,7 +2610,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"CALLG", "Call with general argument list",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0xFA,   // Opcode (Extended + Normal)
 		2,            // Number of Operands
 		{ AB, AB, 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -2620,7 +2620,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"CALLS", "Call with stack",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0xFB,   // Opcode (Extended + Normal)
 		2,            // Number of Operands
 		{ RL, AB, 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -2630,7 +2630,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"XFC", "Extended function call",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0x00, 0xFC,   // Opcode (Extended + Normal)
 		0,            // Number of Operands
 		{ 0 , 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -3862,7 +3862,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"BUGL", "Bug Check Long",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0xFF, 0xFD,   // Opcode (Extended + Normal)
 		1,            // Number of Operands
 		{ IL, 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
@@ -3872,7 +3872,7 @@ INSTRUCTION vax_Instruction[] =
 
 	{
 		"BUGW", "Bug Check Word",
-		ISTR_NORMAL,  // Instruction Flags
+		ISTR_JUMP,    // Instruction Flags
 		0xFF, 0xFE,   // Opcode (Extended + Normal)
 		1,            // Number of Operands
 		{ IW, 0 , 0 , 0 , 0 , 0  }, // Operand Scale/Mode
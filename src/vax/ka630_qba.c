@@ -212,6 +212,7 @@ void u2qba_WriteMEM(void *dptr, uint32 pAddr, uint32 data, uint32 size)
 		}
 #endif /* TEST_PARITY */
 
+		IC_WRITE(mAddr);
 		if (size >= LONG)
 			LMEM(mAddr >> 2) = data;
 		else if (size == WORD)
@@ -320,6 +321,7 @@ uint32 u2qba_WriteBlockIO(void *dptr, uint32 ioAddr,
 			(ioAddr & MAP_OFF);
 
 		memcpy(&ka630->cpu.RAM[mapAddr], &data[idxAddr], cntBytes);
+		vax_ClearICacheRange(&ka630->cpu, mapAddr, cntBytes);
 
 #ifdef DEBUG
 		if (dbg_Check(DBG_IODATA)) {
@@ -663,6 +665,76 @@ int qba_Info(MAP_DEVICE *map, int argc, char **argv)
 	return UQ_OK;
 }
 
+// Map block of Q22 addresses to host memory for direct transfers.
+// Return number of bytes mapped (less than requested if any page
+// is not mapped) and number of entries in scatter/gather list.
+uint32 u2qba_MapBlockIO(void *dptr, uint32 ioAddr, uint32 szBytes,
+	UQ_IOVEC *iov, int *nVecs)
+{
+	KA630_DEVICE *ka630 = (KA630_DEVICE *)dptr;
+	QBA_DEVICE   *qba   = ka630->qba;
+	uint32       mapAddr, cntBytes, szMapped = 0;
+	uint8        *hstAddr;
+	int          maxVecs = *nVecs, idx = 0;
+
+	cntBytes = MAP_PAGSZ - (ioAddr & MAP_OFF);
+	if (szBytes < cntBytes)
+		cntBytes = szBytes;
+
+	while (szBytes) {
+		if ((qba->mapRegs[ioAddr >> MAP_N_OFF] & MAP_V) == 0)
+			break;
+		mapAddr = (qba->mapRegs[ioAddr >> MAP_N_OFF] << MAP_N_OFF) |
+			(ioAddr & MAP_OFF);
+		if ((mapAddr + cntBytes) > ka630->cpu.sizeRAM)
+			break;
+
+		// Merge adjacent pages into one entry.
+		hstAddr = &ka630->cpu.RAM[mapAddr];
+		if (idx && (((uint8 *)iov[idx-1].iov_base + iov[idx-1].iov_len) == hstAddr))
+			iov[idx-1].iov_len += cntBytes;
+		else if (idx < maxVecs) {
+			iov[idx].iov_base  = hstAddr;
+			iov[idx++].iov_len = cntBytes;
+		} else
+			break;
+
+		// Increment them by 512-bytes page.
+		ioAddr   += cntBytes;
+		szMapped += cntBytes;
+		szBytes  -= cntBytes;
+		cntBytes =  (szBytes > MAP_PAGSZ) ? MAP_PAGSZ : szBytes;
+	}
+
+	*nVecs = idx;
+	return szMapped;
+}
+
+// Done with direct transfers to memory - clear instruction
+// cache for that block.
+void u2qba_SyncBlockIO(void *dptr, uint32 ioAddr, uint32 szBytes)
+{
+	KA630_DEVICE *ka630 = (KA630_DEVICE *)dptr;
+	QBA_DEVICE   *qba   = ka630->qba;
+	uint32       mapAddr, cntBytes;
+
+	cntBytes = MAP_PAGSZ - (ioAddr & MAP_OFF);
+	if (szBytes < cntBytes)
+		cntBytes = szBytes;
+
+	while (szBytes) {
+		if ((qba->mapRegs[ioAddr >> MAP_N_OFF] & MAP_V) == 0)
+			break;
+		mapAddr = (qba->mapRegs[ioAddr >> MAP_N_OFF] << MAP_N_OFF) |
+			(ioAddr & MAP_OFF);
+		vax_ClearICacheRange(&ka630->cpu, mapAddr, cntBytes);
+
+		ioAddr   += cntBytes;
+		szBytes  -= cntBytes;
+		cntBytes =  (szBytes > MAP_PAGSZ) ? MAP_PAGSZ : szBytes;
+	}
+}
+
 UQ_CALL u2qba_Callback =
 {
 	NULL,                // Read Data I/O
@@ -672,6 +744,10 @@ UQ_CALL u2qba_Callback =
 	NULL,                // Get Host Address
 
 	u2qba_SetMap,        // SetMap Routine
+	NULL,                // Boot Routine
+
+	u2qba_MapBlockIO,    // Map Block for DMA
+	u2qba_SyncBlockIO,   // Sync Block after DMA
 };
 
 DEVICE qba_Device =
@@ -604,6 +604,7 @@ inline void ka630_WriteCPU(KA630_DEVICE *ka630, uint32 pAddr, uint32 data, uint3
 			} else {
 				ka630->cpu.TestParity  = ka630_TestParity;
 				ka630->cpu.WriteParity = ka630_WriteParity;
+				vax_ClearHostTB(&ka630->cpu, 1);
 			}
 #endif /* TEST_PARITY */
 			break;
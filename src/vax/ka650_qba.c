@@ -288,6 +288,7 @@ void cq_WriteMAP(CQ_DEVICE *cq, uint32 pAddr, uint32 data, uint32 size)
 #endif /* DEBUG */
 
 	if (IN_RAM(mAddr)) {
+		IC_WRITE(mAddr);
 		if (size >= LN_LONG)
 			LMEM(mAddr >> 2) = data;
 		else if (size == LN_WORD)
@@ -340,6 +341,7 @@ void cq_WriteMEM(CQ_DEVICE *cq, uint32 pAddr, uint32 data, uint32 size)
 	uint32  mAddr;
 
 	if (cq_MapAddr(cq, pAddr & CQMEM_MASK, &mAddr)) {
+		IC_WRITE(mAddr);
 		if (size >= LN_LONG)
 			LMEM(mAddr >> 2) = data;
 		else if (size == LN_WORD)
@@ -594,6 +596,7 @@ uint32 cq_WriteBlock(void *dptr, uint32 ioAddr, uint8 *data, uint32 szBytes, uin
 			return szBytes;
 
 		memcpy(&ka650->cpu.RAM[mapAddr], &data[idxAddr], cntBytes);
+		vax_ClearICacheRange(&ka650->cpu, mapAddr, cntBytes);
 
 #ifdef DEBUG
 		if (dbg_Check(DBG_IODATA)) {
@@ -613,6 +616,78 @@ uint32 cq_WriteBlock(void *dptr, uint32 ioAddr, uint8 *data, uint32 szBytes, uin
 	return szBytes;
 }
 
+// Map block of Q22 addresses to host memory for direct transfers.
+// Return number of bytes mapped (less than requested if any page
+// is not mapped) and number of entries in scatter/gather list.
+// Errors are not reported here - device will find them by usual
+// block transfer instead.
+uint32 cq_MapBlock(void *dptr, uint32 ioAddr, uint32 szBytes,
+	UQ_IOVEC *iov, int *nVecs)
+{
+	KA650_DEVICE *ka650 = (KA650_DEVICE *)dptr;
+	CQ_DEVICE    *cq    = ka650->qba;
+	VAX_CPU      *vax   = &ka650->cpu;
+	uint32       meAddr, mapEntry, mapAddr;
+	uint32       cntBytes, szMapped = 0;
+	uint8        *hstAddr;
+	int          maxVecs = *nVecs, idx = 0;
+
+	cntBytes = VA_PAGESIZE - VA_GETOFF(ioAddr);
+	if (szBytes < cntBytes)
+		cntBytes = szBytes;
+
+	while (szBytes) {
+		meAddr = cq->mbr + ((((ioAddr & CQMEM_MASK) >> VA_P_VPN) << 2) & CQMEM_MASK);
+		if (!IN_RAM(meAddr) || !((mapEntry = LMEM(meAddr >> 2)) & MAP_VALID))
+			break;
+		mapAddr = ((mapEntry & MAP_PAGE) << VA_P_VPN) + VA_GETOFF(ioAddr);
+		if (!IN_RAM(mapAddr))
+			break;
+
+		// Merge adjacent pages into one entry.
+		hstAddr = &vax->RAM[mapAddr];
+		if (idx && (((uint8 *)iov[idx-1].iov_base + iov[idx-1].iov_len) == hstAddr))
+			iov[idx-1].iov_len += cntBytes;
+		else if (idx < maxVecs) {
+			iov[idx].iov_base  = hstAddr;
+			iov[idx++].iov_len = cntBytes;
+		} else
+			break;
+
+		// Increment them by 512-bytes page.
+		ioAddr   += cntBytes;
+		szMapped += cntBytes;
+		szBytes  -= cntBytes;
+		cntBytes =  (szBytes > VA_PAGESIZE) ? VA_PAGESIZE : szBytes;
+	}
+
+	*nVecs = idx;
+	return szMapped;
+}
+
+// Done with direct transfers to memory - clear instruction
+// cache for that block.
+void cq_SyncBlock(void *dptr, uint32 ioAddr, uint32 szBytes)
+{
+	KA650_DEVICE *ka650 = (KA650_DEVICE *)dptr;
+	CQ_DEVICE    *cq    = ka650->qba;
+	uint32       mapAddr, cntBytes;
+
+	cntBytes = VA_PAGESIZE - VA_GETOFF(ioAddr);
+	if (szBytes < cntBytes)
+		cntBytes = szBytes;
+
+	while (szBytes) {
+		if (cq_MapAddr(cq, ioAddr & CQMEM_MASK, &mapAddr) == 0)
+			break;
+		vax_ClearICacheRange(&ka650->cpu, mapAddr, cntBytes);
+
+		ioAddr   += cntBytes;
+		szBytes  -= cntBytes;
+		cntBytes =  (szBytes > VA_PAGESIZE) ? VA_PAGESIZE : szBytes;
+	}
+}
+
 // *************************************************************
 
 int cq_SetMap(void *dptr, MAP_IO *io)
@@ -801,6 +876,10 @@ UQ_CALL cq_Callback =
 	NULL,           // Get Host Address
 
 	cq_SetMap,      // SetMap Routine
+	NULL,           // Boot Routine
+
+	cq_MapBlock,    // Map Block for DMA
+	cq_SyncBlock,   // Sync Block after DMA
 };
 
 DEVICE cq_Device =
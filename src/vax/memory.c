@@ -35,6 +35,9 @@
 
 #include "vax/defs.h"
 
+#define IN_RAM(addr) \
+	((addr) < vax->sizeRAM)
+
 uint32 vax_SetMemory(VAX_CPU *vax, char *reqSize)
 {
 	uint32 ramSize;
@@ -63,6 +66,8 @@ uint32 vax_SetMemory(VAX_CPU *vax, char *reqSize)
 			vax->baseRAM = 0L;
 			vax->endRAM  = ramSize - 1;
 			vax->sizeRAM = ramSize;
+			vax_ClearHostTB(vax, 1);
+			vax_InitICache(vax);
 			return ramSize;
 		}
 	}
@@ -80,6 +85,8 @@ int vax_InitMemory(VAX_CPU *vax, int reqSize)
 
 	// Clear all physical memory
 	memset(vax->RAM, 0, reqSize);
+	vax_ClearHostTB(vax, 1);
+	vax_InitICache(vax);
 
 	return VAX_OK;
 }
@@ -89,6 +96,8 @@ int vax_ReleaseMemory(VAX_CPU *vax)
 	// Free physical memory back to host system.
 	if (vax->RAM)
 		free(vax->RAM);
+	vax_ReleaseICache(vax);
+	vax_ClearHostTB(vax, 1);
 
 	// Reset all memory values;
 	vax->RAM     = NULL;
@@ -99,13 +108,78 @@ int vax_ReleaseMemory(VAX_CPU *vax)
 	return VAX_OK;
 }
 
+// ******************************************
+// Decoded Instruction Cache Support Routines
+// ******************************************
+
+// Allocate instruction cache for current physical memory.
+void vax_InitICache(VAX_CPU *vax)
+{
+	vax_ReleaseICache(vax);
+
+	vax->icTable = (ICENTRY *)calloc(IC_SIZE, sizeof(ICENTRY));
+	vax->icPages = (uint32 *)calloc(vax->sizeRAM >> VA_N_OFF, sizeof(uint32));
+	if ((vax->icTable == NULL) || (vax->icPages == NULL)) {
+		vax_ReleaseICache(vax);
+		return;
+	}
+#ifdef VAX_BLOCKS
+	vax_BlockInit(vax);
+#endif /* VAX_BLOCKS */
+	vax_ClearICache(vax);
+}
+
+void vax_ReleaseICache(VAX_CPU *vax)
+{
+	if (vax->icTable)
+		free(vax->icTable);
+	if (vax->icPages)
+		free(vax->icPages);
+
+	vax->icTable = NULL;
+	vax->icPages = NULL;
+	vax->icEntry = NULL;
+#ifdef VAX_BLOCKS
+	vax_BlockRelease(vax);
+#endif /* VAX_BLOCKS */
+}
+
+// Invalidate all cached instructions.
+void vax_ClearICache(VAX_CPU *vax)
+{
+	int idx;
+
+	if (vax->icTable == NULL)
+		return;
+	for (idx = 0; idx < IC_SIZE; idx++)
+		vax->icTable[idx].ppc = IC_NONE;
+	vax->icEntry = NULL;
+#ifdef VAX_BLOCKS
+	vax_BlockFlush(vax);
+#endif /* VAX_BLOCKS */
+}
+
+// Invalidate cached instructions within a range of physical memory.
+// Used by DMA transfers and console writes that bypass the CPU.
+void vax_ClearICacheRange(VAX_CPU *vax, uint32 pAddr, uint32 szBytes)
+{
+	uint32 pg, epg;
+
+	if ((vax->icPages == NULL) || (szBytes == 0) || !IN_RAM(pAddr))
+		return;
+	if (!IN_RAM(pAddr + szBytes - 1))
+		szBytes = vax->sizeRAM - pAddr;
+
+	epg = (pAddr + szBytes - 1) >> VA_N_OFF;
+	for (pg = pAddr >> VA_N_OFF; pg <= epg; pg++)
+		if (vax->icPages[pg] & IC_LIVE)
+			vax->icPages[pg] += IC_LIVE;
+}
+
 // **************************************
 // New Memory Routines for more effective
 // **************************************
 
-#define IN_RAM(addr) \
-	((addr) < vax->sizeRAM)
-
 // Aligned Memory Access
 // Note: It only works for little endian machines at this time.
 #define BMEM(addr)  ((uint8 *)vax->RAM)[addr]
@@ -152,6 +226,7 @@ void vax_WriteAligned(register VAX_CPU *vax,
 		if (vax->WriteParity)
 			vax->WriteParity(vax, pAddr);
 #endif /* TEST_PARITY */
+		IC_WRITE(pAddr);
 		if (len >= LN_LONG)
 			LMEM(pAddr >> 2) = data;
 		else if (len == LN_WORD)
@@ -180,9 +255,10 @@ inline uint32 vax_ReadLP(register VAX_CPU *vax, uint32 pAddr)
 // Physical Write Longword Aligned (Optimized)
 inline void vax_WriteLP(register VAX_CPU *vax, uint32 pAddr, uint32 data)
 {
-	if (IN_RAM(pAddr))
+	if (IN_RAM(pAddr)) {
+		IC_WRITE(pAddr);
 		LMEM(pAddr >> 2) = data;
-	else {
+	} else {
 		MCHK_ADDR = pAddr;
 		MCHK_REF  = REF_P;
 		vax->WriteAligned(vax, pAddr, data, LN_LONG);
@@ -203,25 +279,55 @@ inline uint32 vax_ReadL(register VAX_CPU *vax, uint32 pAddr)
 // Virtual Write Longword Aligned (Optimized)
 inline void vax_WriteL(register VAX_CPU *vax, uint32 pAddr, uint32 data)
 {
-	if (IN_RAM(pAddr))
+	if (IN_RAM(pAddr)) {
+		IC_WRITE(pAddr);
 		LMEM(pAddr >> 2) = data;
-	else {
+	} else {
 		MCHK_REF = REF_V;
 		vax->WriteAligned(vax, pAddr, data, LN_LONG);
 	}
 }
 
+// Load host TLB entry for RAM page
+#ifdef TEST_PARITY
+#define HTLB_LOAD(hte, va, pa, acc, parity) \
+	if (IN_RAM(pa) && (parity == NULL)) { \
+		hte->tag   = HTLB_TAG(va, acc); \
+		hte->pAddr = VA_GETBASE(pa); \
+		hte->host  = &vax->RAM[VA_GETBASE(pa)]; \
+	}
+#else /* TEST_PARITY */
+#define HTLB_LOAD(hte, va, pa, acc, parity) \
+	if (IN_RAM(pa)) { \
+		hte->tag   = HTLB_TAG(va, acc); \
+		hte->pAddr = VA_GETBASE(pa); \
+		hte->host  = &vax->RAM[VA_GETBASE(pa)]; \
+	}
+#endif /* TEST_PARITY */
+
 // Virtual Read
 uint32 vax_Read(register VAX_CPU *vax, uint32 vAddr, int32 lint, int32 acc)
 {
 	uint32 vpn, off, tbi;
 	TLBENT xpte;
+	HTLBENT *hte;
 	uint32 pAddr, pAddr1;
 	uint32 wl, wh, sc;
 
-	MCHK_ADDR = vAddr;
 	if (MAPEN) {
+		// Aligned access to RAM page through host TLB
+		hte = &HRTLB[HTLB_INDEX(vAddr)];
+		if ((hte->tag == HTLB_TAG(vAddr, acc)) && ((vAddr & (lint - 1)) == 0)) {
+			off = VA_GETOFF(vAddr);
+			if (lint >= LN_LONG)
+				return *(uint32 *)(hte->host + off);
+			if (lint == LN_WORD)
+				return *(uint16 *)(hte->host + off);
+			return hte->host[off];
+		}
+
 		// Translate virtual to physcial address
+		MCHK_ADDR = vAddr;
 		vpn = VA_GETVPN(vAddr); // Get Virtual Page Number
 		off = VA_GETOFF(vAddr); // Get Byte Offset
 		tbi = VA_GETTBI(vpn);   // Get TLB Index
@@ -232,8 +338,11 @@ uint32 vax_Read(register VAX_CPU *vax, uint32 vAddr, int32 lint, int32 acc)
 		    ((acc & TLB_WACC) && ((xpte.pte & TLB_M) == 0)))
 			xpte = vax_Fill(vax, vAddr, lint, acc, NULL);
 		pAddr = (xpte.pte & TLB_PFN) | off;
-	} else
+		HTLB_LOAD(hte, vAddr, pAddr, acc, vax->TestParity);
+	} else {
+		MCHK_ADDR = vAddr;
 		pAddr = vAddr & PAMASK;
+	}
 
 	// Check address is aligned first.
 	if ((pAddr & (lint - 1)) == 0)
@@ -278,12 +387,27 @@ void vax_Write(register VAX_CPU *vax,
 {
 	uint32 vpn, off, tbi;
 	TLBENT xpte;
+	HTLBENT *hte;
 	uint32 pAddr, pAddr1;
 	uint32 wl, wh, bo, sc;
 
-	MCHK_ADDR = vAddr;
 	if (MAPEN) {
+		// Aligned access to RAM page through host TLB
+		hte = &HWTLB[HTLB_INDEX(vAddr)];
+		if ((hte->tag == HTLB_TAG(vAddr, acc)) && ((vAddr & (lint - 1)) == 0)) {
+			off = VA_GETOFF(vAddr);
+			IC_WRITE(hte->pAddr);
+			if (lint >= LN_LONG)
+				*(uint32 *)(hte->host + off) = data;
+			else if (lint == LN_WORD)
+				*(uint16 *)(hte->host + off) = data;
+			else
+				hte->host[off] = data;
+			return;
+		}
+
 		// Translate virtual to physcial address
+		MCHK_ADDR = vAddr;
 		vpn = VA_GETVPN(vAddr); // Get Virtual Page Number
 		off = VA_GETOFF(vAddr); // Get Byte Offset
 		tbi = VA_GETTBI(vpn);   // Get TLB Index
@@ -294,8 +418,11 @@ void vax_Write(register VAX_CPU *vax,
 		    ((xpte.pte & TLB_M) == 0))
 			xpte = vax_Fill(vax, vAddr, lint, acc, NULL);
 		pAddr = (xpte.pte & TLB_PFN) | off;
-	} else
+		HTLB_LOAD(hte, vAddr, pAddr, acc, vax->WriteParity);
+	} else {
+		MCHK_ADDR = vAddr;
 		pAddr = vAddr & PAMASK;
+	}
 
 	// Check address is aligned first.
 	if ((pAddr & (lint - 1)) == 0)
@@ -343,6 +470,45 @@ void vax_Write(register VAX_CPU *vax,
 	}
 }
 
+// Map virtual address to host address for block transfers
+// within a page.  Page faults are taken as usual.  Return NULL
+// if page is not in RAM, so that caller must access it by using
+// ReadV/WriteV instead.  For write access, cached instructions
+// on that page are invalidated first.
+uint8 *vax_MapPage(register VAX_CPU *vax, uint32 vAddr, int32 acc)
+{
+	uint32 vpn, tbi;
+	TLBENT xpte;
+	uint32 pAddr;
+
+	MCHK_ADDR = vAddr;
+	if (MAPEN) {
+		// Translate virtual to physcial address
+		vpn = VA_GETVPN(vAddr); // Get Virtual Page Number
+		tbi = VA_GETTBI(vpn);   // Get TLB Index
+
+		xpte = (vAddr & VA_S0) ? STLB[tbi] : PTLB[tbi];
+
+		if (((xpte.pte & acc) == 0) || (xpte.tag != vpn) ||
+		    ((acc & TLB_WACC) && ((xpte.pte & TLB_M) == 0)))
+			xpte = vax_Fill(vax, vAddr, LN_BYTE, acc, NULL);
+		pAddr = (xpte.pte & TLB_PFN) | VA_GETOFF(vAddr);
+	} else
+		pAddr = vAddr & PAMASK;
+
+	if (!IN_RAM(pAddr))
+		return NULL;
+#ifdef TEST_PARITY
+	if ((acc & TLB_WACC) ? vax->WriteParity : vax->TestParity)
+		return NULL;
+#endif /* TEST_PARITY */
+	if (acc & TLB_WACC) {
+		IC_WRITE(pAddr);
+	}
+
+	return &vax->RAM[pAddr];
+}
+
 // Virtual Access Check
 int32 vax_Test(register VAX_CPU *vax, uint32 vAddr, int32 acc, int32 *status)
 {
@@ -247,15 +247,32 @@ void  vax_Emulate(register VAX_CPU *, int32);
 
 // cpu_main.c
 void  vax_BuildCPU(VAX_CPU *, uint32);
+void  vax_UpdateCC(register VAX_CPU *);
+SPECDEC vax_GetSpecDecoder(uint32);
 char *vax_DisplayConditions(uint32);
+#ifdef VAX_BLOCKS
+void  vax_ReplayInst(register VAX_CPU *, ICENTRY *);
+#endif /* VAX_BLOCKS */
 //void vax_DecodeOperand(INSTRUCTION *, int32 *);
 //void  vax_DecodeOperand(uint32 *, int32 *);
 int   vax_Execute(MAP_DEVICE *);
+#ifdef IDLE
+void  vax_Idle(register VAX_CPU *);
+#endif /* IDLE */
+
+// cpu_block.c
+#ifdef VAX_BLOCKS
+void  vax_BlockInit(VAX_CPU *);
+int   vax_BlockExecute(register VAX_CPU *);
+void  vax_BlockFlush(VAX_CPU *);
+void  vax_BlockRelease(VAX_CPU *);
+#endif /* VAX_BLOCKS */
 
 // cpu_mmu.c
 TLBENT  vax_Fill(register VAX_CPU *, uint32, int32, int32, int32 *);
 void    vax_ClearTBTable(register VAX_CPU *, int);
 void    vax_ClearTBEntry(register VAX_CPU *, uint32);
+void    vax_ClearHostTB(register VAX_CPU *, int);
 int     vax_CheckTBEntry(register VAX_CPU *, uint32);
 int     vax_ShowTLB(void *, int, char **);
 
@@ -282,11 +299,16 @@ void   vax_WriteTXDB(VAX_CPU *, uint32);
 int    vax_InitMemory(VAX_CPU *, int);
 int    vax_FreeMemory(VAX_CPU *);
 int32  vax_ReadInst(register VAX_CPU *, int32);
+void   vax_InitICache(VAX_CPU *);
+void   vax_ReleaseICache(VAX_CPU *);
+void   vax_ClearICache(VAX_CPU *);
+void   vax_ClearICacheRange(VAX_CPU *, uint32, uint32);
 uint32 vax_ReadAligned(register VAX_CPU *, uint32, int32);
 uint32 vax_Read(register VAX_CPU *, uint32, int32, int32);
 void   vax_WriteAligned(register VAX_CPU *, uint32, uint32, int32);
 void   vax_Write(register VAX_CPU *, uint32, uint32, int32, int32);
 int32  vax_Test(register VAX_CPU *, uint32, int32, int32 *);
+uint8  *vax_MapPage(register VAX_CPU *, uint32, int32);
 
 int32  vax_ReadC(register VAX_CPU *, uint32, uint32 *, int32, uint32);
 int32  vax_WriteC(register VAX_CPU *, uint32, uint32, int32, uint32);
@@ -220,6 +220,22 @@ typedef struct {
 	int32 pte; // Process Table Entry
 } TLBENT;
 
+// Host TLB Entry
+//
+// Holds host address of a RAM page for aligned access without
+// translation.  Tag is the virtual page address with access mode
+// bits (RA or WA) so that one compare checks page and access mode
+// together.  Tag is -1 for empty entry.  I/O pages are never loaded.
+
+#define HTLB_INDEX(va) VA_GETTBI((va) >> VA_N_OFF)
+#define HTLB_TAG(va, acc) (VA_GETBASE(va) | (acc))
+
+typedef struct {
+	uint32 tag;   // Virtual Page Address | Access Mode
+	uint32 pAddr; // Physical Page Address
+	uint8  *host; // Host Address of Page
+} HTLBENT;
+
 // Memory Management Fault Codes and Probe Results for exception
 //
 //  31                                    2 1 0